@@ -0,0 +1,186 @@
+#include "ads1115_scheduler.h"
+
+#include <algorithm>
+
+namespace halmet {
+
+static const unsigned int kDataRates[] = {8, 16, 32, 64, 128, 250, 475, 860};
+
+// A conversion that hasn't completed in this time is abandoned. Even at
+// 8 SPS a conversion takes only 125 ms.
+const uint32_t kConversionTimeout = 250000;  // us
+
+unsigned int Ads1115Scheduler::supported_data_rate(unsigned int data_rate) {
+  for (unsigned int rate : kDataRates) {
+    if (rate >= data_rate) {
+      return rate;
+    }
+  }
+  return 860;
+}
+
+uint32_t Ads1115Scheduler::conversion_time(unsigned int data_rate) {
+  // The internal oscillator is accurate to 10%, and the converter takes
+  // about 25 us to power up from single-shot mode
+  uint32_t nominal = 1000000 / supported_data_rate(data_rate);
+  return nominal + nominal / 10 + 25;
+}
+
+bool Ads1115Scheduler::add_channel(int channel, unsigned int read_interval,
+                                   Callback callback,
+                                   const ADS1115Oversampling& oversampling) {
+  if (channel < 0 || channel > 3) {
+    return false;
+  }
+  uint8_t samples = std::min(std::max(oversampling.samples, uint8_t(1)),
+                             kMaxSamples);
+  channels_.push_back({channel, read_interval * 1000, 0, callback, samples,
+                       supported_data_rate(oversampling.data_rate)});
+  scheduled_ = false;
+  return true;
+}
+
+int16_t Ads1115Scheduler::reduce(int16_t* samples, uint8_t count) {
+  if (count == 1) {
+    return samples[0];
+  }
+  std::sort(samples, samples + count);
+  // Average about the middle half, rounded so that as many samples are
+  // discarded at the top as at the bottom: the median of three, but the
+  // mean of two
+  uint8_t keep = std::max(count / 2, 1);
+  if ((count - keep) % 2 != 0) {
+    keep++;
+  }
+  uint8_t first = (count - keep) / 2;
+  int32_t sum = 0;
+  for (uint8_t i = first; i < first + keep; i++) {
+    sum += samples[i];
+  }
+  return (sum + keep / 2) / keep;
+}
+
+void Ads1115Scheduler::tick(uint32_t now_us) {
+  if (active_ >= 0) {
+    uint32_t elapsed = now_us - started_at_;
+    if (elapsed >= conversion_time_) {
+      stats_.ready_checks++;
+      if (io_->conversion_complete()) {
+        finish_conversion(now_us);
+      } else if (elapsed > kConversionTimeout) {
+        stats_.timeouts++;
+        active_ = -1;
+      }
+    }
+  }
+
+  if (active_ < 0) {
+    if (capture_channel_ >= 0) {
+      tick_capture(now_us);
+    } else {
+      start_next(now_us);
+    }
+  }
+}
+
+bool Ads1115Scheduler::start_capture(int channel, int16_t* buffer,
+                                     uint32_t* times, size_t count,
+                                     CaptureCallback callback) {
+  if (capture_channel_ >= 0 || channel < 0 || channel > 3 || count == 0) {
+    return false;
+  }
+  capture_channel_ = channel;
+  capture_running_ = false;
+  capture_buffer_ = buffer;
+  capture_times_ = times;
+  capture_count_ = count;
+  capture_index_ = 0;
+  capture_duration_ = count * kCapturePeriod;
+  capture_callback_ = callback;
+  return true;
+}
+
+void Ads1115Scheduler::tick_capture(uint32_t now_us) {
+  if (!capture_running_) {
+    io_->start(capture_channel_, 860, true);
+    capture_started_ = now_us;
+    capture_last_read_ = now_us;
+    capture_running_ = true;
+    return;
+  }
+
+  // In continuous mode, the conversion register always holds the latest
+  // result. Reading it sooner than a worst-case conversion time after the
+  // previous read could return the same conversion again.
+  if (now_us - capture_last_read_ >= conversion_time(860)) {
+    capture_last_read_ = now_us;
+    capture_buffer_[capture_index_] = io_->read_result();
+    capture_times_[capture_index_] = now_us - capture_started_;
+    capture_index_++;
+  }
+  if (capture_index_ < capture_count_ &&
+      now_us - capture_started_ < capture_duration_) {
+    return;
+  }
+
+  // The next single-shot conversion ends the continuous mode
+  capture_channel_ = -1;
+  capture_running_ = false;
+  capture_callback_(capture_index_);
+}
+
+void Ads1115Scheduler::start_next(uint32_t now_us) {
+  if (!scheduled_) {
+    // Everything is due at the first tick
+    for (auto& channel : channels_) {
+      channel.next_due = now_us;
+    }
+    scheduled_ = true;
+  }
+
+  int next = -1;
+  int32_t most_overdue = -1;
+  for (size_t i = 0; i < channels_.size(); i++) {
+    int32_t overdue = static_cast<int32_t>(now_us - channels_[i].next_due);
+    if (overdue > most_overdue) {
+      most_overdue = overdue;
+      next = i;
+    }
+  }
+  if (next < 0) {
+    return;
+  }
+
+  Channel& channel = channels_[next];
+  channel.next_due += channel.read_interval;
+  if (static_cast<int32_t>(now_us - channel.next_due) >= 0) {
+    // Fell more than a full interval behind; don't try to catch up
+    channel.next_due = now_us + channel.read_interval;
+  }
+
+  active_ = next;
+  burst_count_ = 0;
+  start_conversion(now_us);
+}
+
+void Ads1115Scheduler::start_conversion(uint32_t now_us) {
+  const Channel& channel = channels_[active_];
+  io_->start(channel.channel, channel.data_rate, false);
+  started_at_ = now_us;
+  conversion_time_ = conversion_time(channel.data_rate);
+}
+
+void Ads1115Scheduler::finish_conversion(uint32_t now_us) {
+  Channel& channel = channels_[active_];
+  burst_[burst_count_++] = io_->read_result();
+  stats_.conversions++;
+  if (burst_count_ < channel.samples) {
+    // The rest of the burst goes ahead of other due channels
+    start_conversion(now_us);
+    return;
+  }
+  active_ = -1;
+  channel.callback(reduce(burst_, burst_count_));
+}
+
+}  // namespace halmet
@@ -0,0 +1,179 @@
+#ifndef HALMET_SRC_ADS1115_SCHEDULER_H_
+#define HALMET_SRC_ADS1115_SCHEDULER_H_
+
+// Framework-independent ADS1115 conversion scheduling. The device code
+// provides an Ads1115Io on top of the actual driver; on the host, the
+// scheduler can be driven by a simulated converter.
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace halmet {
+
+/// Burst acquisition settings of one ADS1115 channel.
+struct ADS1115Oversampling {
+  // Conversions per reading
+  uint8_t samples = 1;
+  // Samples per second: 8, 16, 32, 64, 128, 250, 475 or 860. Other values
+  // are rounded up.
+  unsigned int data_rate = 128;
+};
+
+/// Register-level access to an ADS1115.
+class Ads1115Io {
+ public:
+  virtual ~Ads1115Io() {}
+
+  /// Start a conversion of single-ended input channel (0-3) at data_rate
+  /// samples per second, one of the rates the ADS1115 supports.
+  virtual void start(int channel, unsigned int data_rate,
+                     bool continuous) = 0;
+  /// Whether the conversion started last is complete. May be an I2C
+  /// transaction; only called once the conversion should be done.
+  virtual bool conversion_complete() = 0;
+  /// Result of the last completed conversion.
+  virtual int16_t read_result() = 0;
+};
+
+/**
+ * @brief Conversion scheduler for all channels of one ADS1115.
+ *
+ * Every input on the ADS1115 registers a channel with its own read interval.
+ * tick() starts a single-shot conversion and returns. The conversion time
+ * follows from the data rate, so the converter isn't asked whether the
+ * conversion is complete until that time, plus the tolerance of its
+ * oscillator, has passed; normally, the first check finds it done. Only one
+ * conversion is in flight at a time. When several channels are due, the
+ * most overdue one is converted first, so registration order decides ties
+ * and no channel can starve the others.
+ *
+ * A channel can be oversampled: each reading is then a burst of conversions
+ * at the channel's own data rate, taken back to back. The samples are
+ * sorted, about the outer half is discarded evenly from both ends and the
+ * rest averaged, which rejects spikes like a median and smooths like a
+ * mean. Two samples are simply averaged.
+ *
+ * For short events, one channel can be captured in continuous conversion
+ * mode at 860 SPS with start_capture(). Scanning pauses for the duration of
+ * the capture.
+ *
+ * Times are in microseconds and may wrap.
+ */
+class Ads1115Scheduler {
+ public:
+  /// Called with the raw ADC code of a finished reading.
+  using Callback = std::function<void(int16_t)>;
+  /// Called when a capture is complete, with the number of samples stored.
+  using CaptureCallback = std::function<void(size_t)>;
+
+  struct Stats {
+    uint32_t conversions;
+    uint32_t timeouts;
+    // Calls to Ads1115Io::conversion_complete()
+    uint32_t ready_checks;
+  };
+
+  /// Time between conversions during a capture, in microseconds (860 SPS).
+  static constexpr uint32_t kCapturePeriod = 1163;
+  static constexpr uint8_t kMaxSamples = 32;
+
+  explicit Ads1115Scheduler(Ads1115Io* io) : io_{io} {}
+
+  /**
+   * @brief Register a channel for periodic conversion.
+   *
+   * @param channel ADS1115 single-ended input (0-3)
+   * @param read_interval Milliseconds between readings of this channel
+   * @param callback Receives the raw ADC code of each reading
+   * @param oversampling Conversions per reading and their data rate
+   * @return false if channel is invalid
+   */
+  bool add_channel(int channel, unsigned int read_interval,
+                   Callback callback,
+                   const ADS1115Oversampling& oversampling = {});
+
+  /**
+   * @brief Capture one channel in continuous conversion mode.
+   *
+   * As soon as the conversion in flight, if any, is done, the ADS1115 is
+   * switched to continuous conversion at 860 SPS on channel. The capture
+   * lasts count * kCapturePeriod microseconds, the time the ADS1115 takes
+   * for count conversions. Only real conversion results are stored: a
+   * result is read at most once per worst-case conversion time, so no
+   * conversion is stored twice, and conversions that complete while tick()
+   * isn't called are skipped. Each sample is stored with the time it was
+   * read, so the gaps are visible. With ticks every millisecond, that
+   * gives a sample every 2 ms. Scanning resumes afterwards with the most
+   * overdue channel.
+   *
+   * @param buffer Receives up to count raw ADC codes
+   * @param times Receives the time of each sample, in microseconds since
+   * the start of the capture
+   * @return false if a capture is already in progress
+   */
+  bool start_capture(int channel, int16_t* buffer, uint32_t* times,
+                     size_t count, CaptureCallback callback);
+
+  bool is_capturing() const { return capture_channel_ >= 0; }
+
+  /// Advance the scheduler. Call frequently, e.g. every millisecond.
+  void tick(uint32_t now_us);
+
+  const Stats& get_stats() const { return stats_; }
+  void clear_stats() { stats_ = {}; }
+
+  /// Supported data rate at or above data_rate, in samples per second.
+  static unsigned int supported_data_rate(unsigned int data_rate);
+  /// Longest time a conversion at data_rate can take, in microseconds.
+  static uint32_t conversion_time(unsigned int data_rate);
+
+  /// Reduce a burst of samples to one reading.
+  static int16_t reduce(int16_t* samples, uint8_t count);
+
+ protected:
+  struct Channel {
+    int channel;
+    uint32_t read_interval;  // us
+    uint32_t next_due;
+    Callback callback;
+    uint8_t samples;
+    unsigned int data_rate;
+  };
+
+  void start_next(uint32_t now_us);
+  void start_conversion(uint32_t now_us);
+  void finish_conversion(uint32_t now_us);
+  void tick_capture(uint32_t now_us);
+
+  Ads1115Io* io_;
+  std::vector<Channel> channels_;
+  bool scheduled_ = false;
+
+  // Index into channels_ of the conversion in flight, or -1 when idle
+  int active_ = -1;
+  uint32_t started_at_ = 0;
+  uint32_t conversion_time_ = 0;
+  // Samples of the burst in progress
+  int16_t burst_[kMaxSamples];
+  uint8_t burst_count_ = 0;
+
+  // Capture requested or in progress, or -1
+  int capture_channel_ = -1;
+  bool capture_running_ = false;
+  int16_t* capture_buffer_ = nullptr;
+  uint32_t* capture_times_ = nullptr;
+  size_t capture_count_ = 0;
+  size_t capture_index_ = 0;
+  uint32_t capture_started_ = 0;
+  uint32_t capture_duration_ = 0;
+  uint32_t capture_last_read_ = 0;
+  CaptureCallback capture_callback_;
+
+  Stats stats_ = {};
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_ADS1115_SCHEDULER_H_
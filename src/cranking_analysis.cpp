@@ -0,0 +1,41 @@
+#include "cranking_analysis.h"
+
+#include <cmath>
+
+namespace halmet {
+
+CrankingSummary AnalyzeCranking(const int16_t* samples,
+                                const uint32_t* times_us, size_t count,
+                                float volts_per_code, float baseline,
+                                float recovery_voltage) {
+  CrankingSummary summary = {NAN, NAN, NAN, 0};
+  if (count == 0) {
+    return summary;
+  }
+
+  size_t minimum_index = 0;
+  uint32_t previous_us = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (samples[i] < samples[minimum_index]) {
+      minimum_index = i;
+    }
+    float volts = samples[i] * volts_per_code;
+    if (volts < baseline) {
+      float interval = (times_us[i] - previous_us) / 1e6;
+      summary.sag_integral += (baseline - volts) * interval;
+    }
+    previous_us = times_us[i];
+  }
+  summary.minimum = samples[minimum_index] * volts_per_code;
+  summary.time_to_minimum = times_us[minimum_index] / 1e6;
+
+  for (size_t i = minimum_index; i < count; i++) {
+    if (samples[i] * volts_per_code >= recovery_voltage) {
+      summary.recovery_time = (times_us[i] - times_us[minimum_index]) / 1e6;
+      break;
+    }
+  }
+  return summary;
+}
+
+}  // namespace halmet
@@ -0,0 +1,44 @@
+#ifndef HALMET_SRC_CRANKING_ANALYSIS_H_
+#define HALMET_SRC_CRANKING_ANALYSIS_H_
+
+// Framework-independent evaluation of a battery voltage capture taken while
+// the engine is cranked.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace halmet {
+
+struct CrankingSummary {
+  // Lowest voltage in the capture, V
+  float minimum;
+  // Time from the start of the capture to the minimum, s
+  float time_to_minimum;
+  // Time from the minimum until the voltage is back at the recovery
+  // voltage, s. NaN if it didn't recover within the capture.
+  float recovery_time;
+  // Integral of the voltage drop below the baseline, V*s
+  float sag_integral;
+};
+
+/**
+ * @brief Summarize a cranking capture.
+ *
+ * Samples need not be evenly spaced; each one stands for the time since
+ * the previous one.
+ *
+ * @param samples Raw ADC codes
+ * @param times_us Time of each sample since the start of the capture, us
+ * @param count Number of samples
+ * @param volts_per_code Input voltage of one ADC code
+ * @param baseline Resting voltage before the capture
+ * @param recovery_voltage Voltage that counts as recovered
+ */
+CrankingSummary AnalyzeCranking(const int16_t* samples,
+                                const uint32_t* times_us, size_t count,
+                                float volts_per_code, float baseline,
+                                float recovery_voltage);
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_CRANKING_ANALYSIS_H_
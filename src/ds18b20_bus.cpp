@@ -0,0 +1,237 @@
+#include "ds18b20_bus.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace halmet {
+
+// 1-Wire ROM and DS18B20 function commands
+const uint8_t kMatchRom = 0x55;
+const uint8_t kSkipRom = 0xCC;
+const uint8_t kConvertT = 0x44;
+const uint8_t kReadScratchpad = 0xBE;
+const uint8_t kWriteScratchpad = 0x4E;
+
+// Temperature register value after power-on
+const int16_t kPowerOnReset = 0x0550;
+
+// Written to the TH and TL alarm registers, which are unused otherwise. A
+// power-on reset reloads them from EEPROM (factory default 75 and 70 °C),
+// so reading anything else back reveals that the sensor has reset since
+// it was configured.
+const uint8_t kAlarmHighMarker = 0x7F;
+const uint8_t kAlarmLowMarker = 0x80;
+
+bool OneWireRom::operator==(const OneWireRom& other) const {
+  return memcmp(bytes, other.bytes, sizeof(bytes)) == 0;
+}
+
+void FormatOneWireRom(const OneWireRom& rom, char* buf, size_t size) {
+  snprintf(buf, size, "%02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x",
+           rom.bytes[0], rom.bytes[1], rom.bytes[2], rom.bytes[3],
+           rom.bytes[4], rom.bytes[5], rom.bytes[6], rom.bytes[7]);
+}
+
+bool ParseOneWireRom(const char* text, OneWireRom* rom) {
+  for (int i = 0; i < 8; i++) {
+    char* end;
+    unsigned long byte = strtoul(text, &end, 16);
+    if (end == text || byte > 0xFF ||
+        (i < 7 && *end != ':') || (i == 7 && *end != '\0')) {
+      return false;
+    }
+    rom->bytes[i] = byte;
+    text = end + 1;
+  }
+  return true;
+}
+
+uint8_t OneWireCrc8(const uint8_t* data, size_t len) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < len; i++) {
+    uint8_t byte = data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      uint8_t mix = (crc ^ byte) & 0x01;
+      crc >>= 1;
+      if (mix) {
+        crc ^= 0x8C;
+      }
+      byte >>= 1;
+    }
+  }
+  return crc;
+}
+
+uint32_t Ds18b20Bus::conversion_time(uint8_t resolution) {
+  // 93.75 ms at 9 bits, doubling with every extra bit
+  return (750 >> (12 - resolution)) + 1;
+}
+
+Ds18b20Bus::Ds18b20Bus(OneWireIo* io, unsigned int read_interval)
+    : io_{io}, read_interval_{read_interval} {}
+
+size_t Ds18b20Bus::add_sensor(const OneWireRom& rom, uint8_t resolution) {
+  sensors_.push_back({rom, 12, false, false, false});
+  set_resolution(sensors_.size() - 1, resolution);
+  return sensors_.size() - 1;
+}
+
+void Ds18b20Bus::set_resolution(size_t sensor, uint8_t resolution) {
+  if (resolution < 9 || resolution > 12) {
+    resolution = 12;
+  }
+  sensors_[sensor].resolution = resolution;
+  sensors_[sensor].configured = false;
+}
+
+void Ds18b20Bus::select(const OneWireRom& rom) {
+  io_->write_bytes(&kMatchRom, 1);
+  io_->write_bytes(rom.bytes, sizeof(rom.bytes));
+}
+
+bool Ds18b20Bus::read_scratchpad(const OneWireRom& rom, uint8_t* scratchpad) {
+  if (!io_->reset()) {
+    stats_.no_presence++;
+    return false;
+  }
+  select(rom);
+  io_->write_bytes(&kReadScratchpad, 1);
+  io_->read_bytes(scratchpad, 9);
+  // An absent sensor leaves the bus high, which reads as all ones and fails
+  // the CRC. A bus shorted low reads as all zeros, which passes it.
+  bool all_zero = true;
+  for (int i = 0; i < 9; i++) {
+    all_zero = all_zero && scratchpad[i] == 0;
+  }
+  if (all_zero || OneWireCrc8(scratchpad, 8) != scratchpad[8]) {
+    stats_.crc_errors++;
+    return false;
+  }
+  return true;
+}
+
+bool Ds18b20Bus::probe(const OneWireRom& rom) {
+  uint8_t scratchpad[9];
+  return read_scratchpad(rom, scratchpad);
+}
+
+bool Ds18b20Bus::configure(Sensor& sensor) {
+  if (!io_->reset()) {
+    stats_.no_presence++;
+    return false;
+  }
+  select(sensor.rom);
+  // The configuration register holds the resolution in bits 5-6. Not
+  // copied to EEPROM, so written again after every boot.
+  uint8_t command[] = {kWriteScratchpad, kAlarmHighMarker, kAlarmLowMarker,
+                       static_cast<uint8_t>(((sensor.resolution - 9) << 5) |
+                                            0x1F)};
+  io_->write_bytes(command, sizeof(command));
+  sensor.configured = true;
+  sensor.converted = false;
+  return true;
+}
+
+bool Ds18b20Bus::start_conversion() {
+  if (!io_->reset()) {
+    stats_.no_presence++;
+    return false;
+  }
+  uint8_t command[] = {kSkipRom, kConvertT};
+  io_->write_bytes(command, sizeof(command));
+  stats_.conversions++;
+  return true;
+}
+
+bool Ds18b20Bus::read(size_t index, uint32_t now_ms) {
+  uint8_t scratchpad[9];
+  if (!read_scratchpad(sensors_[index].rom, scratchpad)) {
+    return false;
+  }
+
+  Sensor& sensor = sensors_[index];
+  bool reset = scratchpad[2] != kAlarmHighMarker ||
+               scratchpad[3] != kAlarmLowMarker;
+  if (reset) {
+    // Restore the resolution before the next conversion
+    sensor.configured = false;
+  }
+
+  // 85 °C is a genuine temperature, too. It is only taken for the
+  // power-on value if the sensor has reset, or on the first reading after
+  // configuring it.
+  bool in_doubt = reset || !sensor.converted;
+  sensor.converted = true;
+  int16_t raw = static_cast<int16_t>(scratchpad[1] << 8 | scratchpad[0]);
+  if (raw == kPowerOnReset && in_doubt) {
+    stats_.invalid++;
+    return false;
+  }
+  // The low bits are undefined below 12 bits of resolution
+  uint8_t resolution = ((scratchpad[4] >> 5) & 0x03) + 9;
+  raw &= ~((1 << (12 - resolution)) - 1);
+
+  stats_.readings++;
+  uint32_t latency = now_ms - cycle_start_;
+  if (latency > stats_.max_latency_ms) {
+    stats_.max_latency_ms = latency;
+  }
+  if (callback_) {
+    callback_(index, raw / 16.0f);
+  }
+  return true;
+}
+
+void Ds18b20Bus::tick(uint32_t now_ms) {
+  if (sensors_.empty()) {
+    return;
+  }
+
+  if (state_ == State::kIdle) {
+    if (started_ && now_ms - cycle_start_ < read_interval_) {
+      return;
+    }
+    // Write pending resolution changes first, one sensor per tick
+    while (next_configure_ < sensors_.size()) {
+      Sensor& sensor = sensors_[next_configure_++];
+      if (!sensor.configured) {
+        configure(sensor);
+        return;
+      }
+    }
+    next_configure_ = 0;
+
+    // Retry at the next interval if the bus is empty
+    cycle_start_ = now_ms;
+    started_ = true;
+    if (start_conversion()) {
+      for (auto& sensor : sensors_) {
+        sensor.pending = true;
+      }
+      state_ = State::kConverting;
+    }
+    return;
+  }
+
+  // Read the first sensor whose conversion is complete
+  bool any_pending = false;
+  for (size_t i = 0; i < sensors_.size(); i++) {
+    Sensor& sensor = sensors_[i];
+    if (!sensor.pending) {
+      continue;
+    }
+    any_pending = true;
+    if (now_ms - cycle_start_ >=
+        conversion_time(effective_resolution(sensor))) {
+      sensor.pending = false;
+      read(i, now_ms);
+      return;
+    }
+  }
+  if (!any_pending) {
+    state_ = State::kIdle;
+  }
+}
+
+}  // namespace halmet
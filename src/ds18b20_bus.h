@@ -0,0 +1,160 @@
+#ifndef HALMET_SRC_DS18B20_BUS_H_
+#define HALMET_SRC_DS18B20_BUS_H_
+
+// Framework-independent DS18B20 acquisition engine. The device code provides
+// a OneWireIo on top of the actual 1-Wire driver; on the host, the engine
+// can be driven by a simulated bus.
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace halmet {
+
+/// 64-bit 1-Wire ROM code: family code, serial number and CRC.
+struct OneWireRom {
+  uint8_t bytes[8];
+
+  bool operator==(const OneWireRom& other) const;
+  bool operator!=(const OneWireRom& other) const { return !(*this == other); }
+};
+
+/// Format rom as "28:ff:12:...", the format used in the sensor config.
+void FormatOneWireRom(const OneWireRom& rom, char* buf, size_t size);
+
+/// Parse a ROM code formatted by FormatOneWireRom().
+bool ParseOneWireRom(const char* text, OneWireRom* rom);
+
+/// Dallas/Maxim CRC-8 as used for ROM codes and scratchpads.
+uint8_t OneWireCrc8(const uint8_t* data, size_t len);
+
+/// Byte-level access to a 1-Wire bus.
+class OneWireIo {
+ public:
+  virtual ~OneWireIo() {}
+
+  /// Reset pulse. Returns true if any device answered with presence.
+  virtual bool reset() = 0;
+  virtual void write_bytes(const uint8_t* data, size_t len) = 0;
+  virtual void read_bytes(uint8_t* data, size_t len) = 0;
+  /// ROM search. Call with first = true to start over. Returns false when
+  /// there are no more devices.
+  virtual bool search(OneWireRom* rom, bool first) = 0;
+};
+
+/**
+ * @brief Non-blocking acquisition of all DS18B20 sensors on one bus.
+ *
+ * Every read interval, one Skip ROM "Convert T" command starts a
+ * temperature conversion in all sensors at once. The engine then returns
+ * and does not wait for the conversions: on later ticks, each sensor's
+ * scratchpad is read once its own conversion time (which depends on its
+ * resolution: 94 ms at 9 bits up to 750 ms at 12 bits) has passed. At most
+ * one bus transaction happens per tick, so a tick never holds the caller
+ * for more than a few milliseconds.
+ *
+ * The sensors must be externally powered; parasite-powered sensors would
+ * need a strong pull-up during the conversion.
+ */
+class Ds18b20Bus {
+ public:
+  /// Called with the sensor index and the temperature in Celsius.
+  using ReadingCallback = std::function<void(size_t sensor, float celsius)>;
+
+  struct Stats {
+    uint32_t conversions;
+    uint32_t readings;
+    uint32_t crc_errors;
+    // Power-on value read back after a sensor reset
+    uint32_t invalid;
+    uint32_t no_presence;
+    // Longest time from "Convert T" to a delivered reading, in ms
+    uint32_t max_latency_ms;
+  };
+
+  Ds18b20Bus(OneWireIo* io, unsigned int read_interval);
+
+  /**
+   * @brief Add a sensor.
+   *
+   * @param rom ROM code of the sensor
+   * @param resolution Resolution in bits, 9-12
+   * @return Index of the sensor, passed to the reading callback
+   */
+  size_t add_sensor(const OneWireRom& rom, uint8_t resolution = 12);
+
+  void set_resolution(size_t sensor, uint8_t resolution);
+  void set_read_interval(unsigned int read_interval) {
+    read_interval_ = read_interval;
+  }
+  void set_reading_callback(ReadingCallback callback) {
+    callback_ = callback;
+  }
+
+  /**
+   * @brief Check that the sensor with rom is on the bus.
+   *
+   * Addresses the sensor directly and reads its scratchpad, which must pass
+   * the CRC. One bus transaction, independent of the state machine.
+   */
+  bool probe(const OneWireRom& rom);
+
+  /// Advance the state machine. Call frequently, e.g. every 10 ms.
+  void tick(uint32_t now_ms);
+
+  size_t get_sensor_count() const { return sensors_.size(); }
+  const OneWireRom& get_rom(size_t sensor) const {
+    return sensors_[sensor].rom;
+  }
+  const Stats& get_stats() const { return stats_; }
+  void clear_stats() { stats_ = {}; }
+
+  /// Conversion time for resolution, in ms.
+  static uint32_t conversion_time(uint8_t resolution);
+
+ protected:
+  enum class State { kIdle, kConverting };
+
+  struct Sensor {
+    OneWireRom rom;
+    uint8_t resolution;
+    // Resolution has been written to the sensor
+    bool configured;
+    // Converting in this cycle, not read yet
+    bool pending;
+    // The scratchpad has been read since the sensor was configured
+    bool converted;
+  };
+
+  // Until the configuration is written, a sensor is at its power-on (or
+  // EEPROM) resolution, which is 12 bits by default
+  static uint8_t effective_resolution(const Sensor& sensor) {
+    return sensor.configured ? sensor.resolution : 12;
+  }
+
+  // Each of these is one bus transaction
+  bool configure(Sensor& sensor);
+  bool start_conversion();
+  bool read(size_t index, uint32_t now_ms);
+
+  void select(const OneWireRom& rom);
+  bool read_scratchpad(const OneWireRom& rom, uint8_t* scratchpad);
+
+  OneWireIo* io_;
+  unsigned int read_interval_;
+  std::vector<Sensor> sensors_;
+  ReadingCallback callback_;
+
+  State state_ = State::kIdle;
+  // Next sensor to check for a pending configuration before the conversion
+  size_t next_configure_ = 0;
+  uint32_t cycle_start_ = 0;
+  bool started_ = false;
+
+  Stats stats_ = {};
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_DS18B20_BUS_H_
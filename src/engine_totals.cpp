@@ -0,0 +1,59 @@
+#include "engine_totals.h"
+
+#include "halmet_clock.h"
+
+namespace halmet {
+
+EngineTotals::EngineTotals(FlashLog* log)
+    : log_{log}, last_integration_{ClockMillis()} {}
+
+bool EngineTotals::restore() {
+  Record record;
+  if (log_ == nullptr ||
+      log_->read_last(&record, sizeof(record)) != sizeof(record)) {
+    return false;
+  }
+  fuel_used_ = record.fuel_used;
+  run_time_ = record.run_time;
+  return true;
+}
+
+void EngineTotals::integrate() {
+  unsigned long now = ClockMillis();
+  double elapsed_s = (now - last_integration_) / 1000.0;
+  last_integration_ = now;
+
+  float fuel_rate = fuel_rate_.get();
+  if (fuel_rate > 0) {
+    fuel_used_ += fuel_rate * elapsed_s;
+    dirty_ = true;
+  }
+  if (revolutions_.get() > 0) {
+    run_time_ += elapsed_s;
+    dirty_ = true;
+  }
+}
+
+bool EngineTotals::persist() {
+  if (!dirty_ || log_ == nullptr) {
+    return true;
+  }
+  Record record = {fuel_used_, run_time_};
+  if (!log_->append(&record, sizeof(record))) {
+    return false;
+  }
+  dirty_ = false;
+  return true;
+}
+
+void EngineTotals::set_fuel_used(double fuel_used) {
+  fuel_used_ = fuel_used;
+  dirty_ = true;
+}
+
+void EngineTotals::set_run_time(double run_time) {
+  run_time_ = run_time;
+  dirty_ = true;
+}
+
+}  // namespace halmet
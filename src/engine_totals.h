@@ -0,0 +1,73 @@
+#ifndef HALMET_SRC_ENGINE_TOTALS_H_
+#define HALMET_SRC_ENGINE_TOTALS_H_
+
+// Framework-independent core of EngineTotalizer: the integration of the
+// inputs into totals and their persistence in a FlashLog.
+
+#include "expiring_value.h"
+#include "flash_log.h"
+
+namespace halmet {
+
+/**
+ * @brief Total fuel used and engine run time.
+ *
+ * Fuel rate (m3/s) is integrated into fuel used (m3), and time during which
+ * the engine revolutions (Hz) are above zero is added to the run time (s).
+ * Inputs that haven't been updated for kMaxInputAge milliseconds count as
+ * zero.
+ */
+class EngineTotals {
+ public:
+  // Three periods of the 500 ms engine PGNs, so an input that went silent
+  // adds at most about a second of stale rate. The fuel rate must
+  // therefore be fed at the PGN rate, not deduplicated.
+  static const unsigned long kMaxInputAge = 1500;  // ms
+
+  /// log may be null, in which case nothing is restored or persisted.
+  explicit EngineTotals(FlashLog* log);
+
+  /// Load the most recent totals from the log. Returns false if it has none.
+  bool restore();
+
+  void set_fuel_rate(float fuel_rate) { fuel_rate_.update(fuel_rate); }
+  void set_revolutions(float revolutions) {
+    revolutions_.update(revolutions);
+  }
+
+  /// Add the inputs over the time since the previous call.
+  void integrate();
+
+  /**
+   * @brief Append the totals to the log if they changed since last time.
+   *
+   * @return false if the log couldn't be written
+   */
+  bool persist();
+
+  double get_fuel_used() const { return fuel_used_; }  // m3
+  double get_run_time() const { return run_time_; }    // s
+
+  void set_fuel_used(double fuel_used);
+  void set_run_time(double run_time);
+
+ protected:
+  struct Record {
+    double fuel_used;
+    double run_time;
+  };
+
+  FlashLog* log_;
+
+  ExpiringValue<float> fuel_rate_{0, kMaxInputAge, 0};
+  ExpiringValue<float> revolutions_{0, kMaxInputAge, 0};
+
+  double fuel_used_ = 0;
+  double run_time_ = 0;
+  bool dirty_ = false;
+  unsigned long last_integration_;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_ENGINE_TOTALS_H_
@@ -1,25 +1,26 @@
 #ifndef HALMET_SRC_EXPIRING_VALUE_H_
 #define HALMET_SRC_EXPIRING_VALUE_H_
 
+#include "halmet_clock.h"
+
 template <typename T>
 class ExpiringValue {
  public:
   ExpiringValue()
       : value_{},
+        expired_value_{-1},
         expiration_duration_{1000},
-        last_update_{0},
-        expired_value_{-1}
-      {}
+        last_update_{0} {}
 
   ExpiringValue(T value, unsigned long expiration_duration, T expired_value)
       : value_{value},
-        expiration_duration_{expiration_duration},
         expired_value_{expired_value},
-        last_update_{millis()} {}
+        expiration_duration_{expiration_duration},
+        last_update_{halmet::ClockMillis()} {}
 
   void update(T value) {
     value_ = value;
-    last_update_ = millis();
+    last_update_ = halmet::ClockMillis();
   }
 
   T get() const {
@@ -31,7 +32,7 @@ class ExpiringValue {
   }
 
   bool is_expired() const {
-    return millis() - last_update_ > expiration_duration_;
+    return halmet::ClockMillis() - last_update_ > expiration_duration_;
   }
 
  private:
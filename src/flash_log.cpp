@@ -0,0 +1,200 @@
+#include "flash_log.h"
+
+namespace halmet {
+
+uint32_t Crc32(const void* data, size_t len, uint32_t crc) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= bytes[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+  }
+  return ~crc;
+}
+
+int FlashLog::read_record(size_t sector, size_t offset, Header* header,
+                          void* payload, size_t max_len) {
+  if (offset + record_size(0) > sector_size_) {
+    return -1;
+  }
+  size_t base = sector * sector_size_ + offset;
+  if (!storage_->read(base, header, sizeof(Header)) ||
+      header->magic != kMagic || header->length > kMaxPayload ||
+      offset + record_size(header->length) > sector_size_) {
+    return -1;
+  }
+
+  uint8_t body[kMaxPayload + sizeof(uint32_t)];
+  size_t padded = record_size(header->length) - sizeof(Header) -
+                  sizeof(uint32_t);
+  if (!storage_->read(base + sizeof(Header), body, padded + sizeof(uint32_t))) {
+    return -1;
+  }
+  uint32_t stored_crc;
+  memcpy(&stored_crc, body + padded, sizeof(stored_crc));
+  uint32_t crc = Crc32(header, sizeof(Header));
+  if (Crc32(body, padded, crc) != stored_crc) {
+    return -1;
+  }
+
+  if (payload != nullptr) {
+    memcpy(payload, body,
+           header->length < max_len ? header->length : max_len);
+  }
+  return header->length;
+}
+
+bool FlashLog::is_erased(size_t sector, size_t offset, size_t len) {
+  uint8_t buf[32];
+  size_t base = sector * sector_size_ + offset;
+  while (len > 0) {
+    size_t chunk = len < sizeof(buf) ? len : sizeof(buf);
+    if (!storage_->read(base, buf, chunk)) {
+      return false;
+    }
+    for (size_t i = 0; i < chunk; i++) {
+      if (buf[i] != 0xFF) {
+        return false;
+      }
+    }
+    base += chunk;
+    len -= chunk;
+  }
+  return true;
+}
+
+bool FlashLog::begin() {
+  sector_size_ = storage_->sector_size();
+  sectors_ = storage_->size() / sector_size_;
+  if (sectors_ < 2) {
+    return false;
+  }
+
+  // The newest sector is the one whose first record has the highest
+  // sequence number
+  Header header;
+  bool found = false;
+  uint32_t newest_sequence = 0;
+  for (size_t sector = 0; sector < sectors_; sector++) {
+    if (read_record(sector, 0, &header, nullptr, 0) < 0) {
+      continue;
+    }
+    if (!found ||
+        static_cast<int32_t>(header.sequence - newest_sequence) > 0) {
+      found = true;
+      newest_sequence = header.sequence;
+      head_sector_ = sector;
+    }
+  }
+
+  if (!found) {
+    // Nothing usable: the first append erases and starts at sector 0
+    head_sector_ = sectors_ - 1;
+    head_offset_ = sector_size_;
+    has_last_ = false;
+    next_sequence_ = 0;
+    return true;
+  }
+
+  size_t offset = 0;
+  int len;
+  while ((len = read_record(head_sector_, offset, &header, nullptr, 0)) >= 0) {
+    has_last_ = true;
+    last_sector_ = head_sector_;
+    last_offset_ = offset;
+    next_sequence_ = header.sequence + 1;
+    offset += record_size(len);
+  }
+  head_offset_ = offset;
+
+  // Anything but erased flash after the last good record is a torn write;
+  // leave the rest of this sector alone
+  size_t tail = sector_size_ - offset;
+  if (tail > record_size(kMaxPayload)) {
+    tail = record_size(kMaxPayload);
+  }
+  if (!is_erased(head_sector_, offset, tail)) {
+    head_offset_ = sector_size_;
+  }
+  return true;
+}
+
+bool FlashLog::start_next_sector() {
+  size_t next = (head_sector_ + 1) % sectors_;
+  if (!storage_->erase_sector(next)) {
+    return false;
+  }
+  erased_++;
+  head_sector_ = next;
+  head_offset_ = 0;
+  return true;
+}
+
+bool FlashLog::append(const void* payload, size_t len) {
+  if (sectors_ < 2 || len > kMaxPayload) {
+    return false;
+  }
+  size_t size = record_size(len);
+  if (head_offset_ + size > sector_size_ && !start_next_sector()) {
+    return false;
+  }
+
+  uint8_t record[record_size(kMaxPayload)];
+  Header header = {kMagic, static_cast<uint16_t>(len), next_sequence_};
+  memcpy(record, &header, sizeof(header));
+  memset(record + sizeof(header), 0, size - sizeof(header));
+  memcpy(record + sizeof(header), payload, len);
+  uint32_t crc = Crc32(record, size - sizeof(crc));
+  memcpy(record + size - sizeof(crc), &crc, sizeof(crc));
+
+  if (!storage_->write(head_sector_ * sector_size_ + head_offset_, record,
+                       size)) {
+    // Don't write over a possibly half-written record
+    head_offset_ = sector_size_;
+    return false;
+  }
+  has_last_ = true;
+  last_sector_ = head_sector_;
+  last_offset_ = head_offset_;
+  head_offset_ += size;
+  next_sequence_++;
+  appended_++;
+  return true;
+}
+
+int FlashLog::read_last(void* payload, size_t max_len) {
+  if (!has_last_) {
+    return -1;
+  }
+  Header header;
+  return read_record(last_sector_, last_offset_, &header, payload, max_len);
+}
+
+FlashLog::Cursor FlashLog::oldest() const {
+  return {sectors_, (head_sector_ + 1) % sectors_, 0};
+}
+
+bool FlashLog::read_next(Cursor* cursor, void* payload, size_t max_len,
+                         size_t* len, uint32_t* sequence) {
+  Header header;
+  while (cursor->sectors_left > 0) {
+    int record_len =
+        read_record(cursor->sector, cursor->offset, &header, payload, max_len);
+    if (record_len >= 0) {
+      cursor->offset += record_size(record_len);
+      *len = record_len;
+      if (sequence != nullptr) {
+        *sequence = header.sequence;
+      }
+      return true;
+    }
+    cursor->sector = (cursor->sector + 1) % sectors_;
+    cursor->offset = 0;
+    cursor->sectors_left--;
+  }
+  return false;
+}
+
+}  // namespace halmet
@@ -0,0 +1,174 @@
+#ifndef HALMET_SRC_FLASH_LOG_H_
+#define HALMET_SRC_FLASH_LOG_H_
+
+// Append-only record log on raw NOR flash. Framework independent: the
+// device code provides a FlashStorage for a flash partition, and on the host
+// the log runs on RamFlashStorage.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace halmet {
+
+/**
+ * @brief Raw NOR flash access.
+ *
+ * Erasing a sector sets all of its bits to 1; writing can only clear bits.
+ */
+class FlashStorage {
+ public:
+  virtual ~FlashStorage() {}
+
+  virtual size_t size() const = 0;
+  virtual size_t sector_size() const = 0;
+  virtual bool read(size_t offset, void* data, size_t len) = 0;
+  virtual bool write(size_t offset, const void* data, size_t len) = 0;
+  virtual bool erase_sector(size_t sector) = 0;
+};
+
+/// FlashStorage in RAM with NOR semantics, for running the log on the host.
+class RamFlashStorage : public FlashStorage {
+ public:
+  RamFlashStorage(size_t sectors, size_t sector_size = 4096)
+      : data_(sectors * sector_size, 0xFF), sector_size_{sector_size} {}
+
+  size_t size() const override { return data_.size(); }
+  size_t sector_size() const override { return sector_size_; }
+
+  bool read(size_t offset, void* data, size_t len) override {
+    if (offset + len > data_.size()) {
+      return false;
+    }
+    memcpy(data, &data_[offset], len);
+    return true;
+  }
+
+  bool write(size_t offset, const void* data, size_t len) override {
+    if (offset + len > data_.size()) {
+      return false;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < len; i++) {
+      data_[offset + i] &= bytes[i];
+    }
+    return true;
+  }
+
+  bool erase_sector(size_t sector) override {
+    if ((sector + 1) * sector_size_ > data_.size()) {
+      return false;
+    }
+    memset(&data_[sector * sector_size_], 0xFF, sector_size_);
+    erase_count_++;
+    return true;
+  }
+
+  uint32_t get_erase_count() const { return erase_count_; }
+
+ private:
+  std::vector<uint8_t> data_;
+  size_t sector_size_;
+  uint32_t erase_count_ = 0;
+};
+
+/**
+ * @brief Append-only, wear-levelled log of small records.
+ *
+ * Records are written one after the other through the sectors of the
+ * storage, which is used as a ring: when the current sector is full, the
+ * oldest sector is erased and reused. Every sector is thus erased once per
+ * trip around the ring, no matter how small and frequent the records are.
+ *
+ * Each record carries a sequence number and a CRC. begin() finds the newest
+ * sector by reading only the first record header of every sector, and then
+ * scans that one sector, so recovery takes a few milliseconds. A record
+ * torn by a power loss fails its CRC and is ignored; writing then continues
+ * in a fresh sector.
+ */
+class FlashLog {
+ public:
+  static const size_t kMaxPayload = 240;
+
+  /// Read position for iterating over the records, oldest first.
+  struct Cursor {
+    size_t sectors_left;
+    size_t sector;
+    size_t offset;
+  };
+
+  explicit FlashLog(FlashStorage* storage) : storage_{storage} {}
+
+  /// Locate the end of the log. Call once before anything else.
+  bool begin();
+
+  /// Append a record of len bytes (at most kMaxPayload).
+  bool append(const void* payload, size_t len);
+
+  /**
+   * @brief Read the most recent record.
+   *
+   * @return Length of the record, or -1 if the log is empty
+   */
+  int read_last(void* payload, size_t max_len);
+
+  Cursor oldest() const;
+
+  /**
+   * @brief Read the record at cursor and advance it.
+   *
+   * @return false at the end of the log
+   */
+  bool read_next(Cursor* cursor, void* payload, size_t max_len, size_t* len,
+                 uint32_t* sequence = nullptr);
+
+  /// Sequence number the next record will get.
+  uint32_t get_next_sequence() const { return next_sequence_; }
+  uint32_t get_appended() const { return appended_; }
+  uint32_t get_erased() const { return erased_; }
+
+ protected:
+  struct Header {
+    uint16_t magic;
+    uint16_t length;
+    uint32_t sequence;
+  };
+
+  static const uint16_t kMagic = 0x4C47;
+
+  static constexpr size_t record_size(size_t len) {
+    return sizeof(Header) + ((len + 3) & ~size_t(3)) + sizeof(uint32_t);
+  }
+
+  // Check the record at offset. Returns its payload length, or -1.
+  int read_record(size_t sector, size_t offset, Header* header,
+                  void* payload, size_t max_len);
+
+  bool is_erased(size_t sector, size_t offset, size_t len);
+
+  // Erase the next sector in the ring and make it the current one
+  bool start_next_sector();
+
+  FlashStorage* storage_;
+  size_t sectors_ = 0;
+  size_t sector_size_ = 0;
+
+  size_t head_sector_ = 0;
+  size_t head_offset_ = 0;
+  // Location of the newest record, if any
+  bool has_last_ = false;
+  size_t last_sector_ = 0;
+  size_t last_offset_ = 0;
+  uint32_t next_sequence_ = 0;
+
+  uint32_t appended_ = 0;
+  uint32_t erased_ = 0;
+};
+
+/// CRC-32 (IEEE 802.3), as used for the log records.
+uint32_t Crc32(const void* data, size_t len, uint32_t crc = 0);
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_FLASH_LOG_H_
@@ -0,0 +1,96 @@
+#include "halmet_ads1115_scanner.h"
+
+namespace halmet {
+
+// Single-ended input multiplexer settings, indexed by channel
+static const uint16_t kMuxByChannel[] = {
+    ADS1X15_REG_CONFIG_MUX_SINGLE_0, ADS1X15_REG_CONFIG_MUX_SINGLE_1,
+    ADS1X15_REG_CONFIG_MUX_SINGLE_2, ADS1X15_REG_CONFIG_MUX_SINGLE_3};
+
+// Supported data rates and their config register bits
+static const struct {
+  unsigned int sps;
+  uint16_t bits;
+} kDataRates[] = {
+    {8, RATE_ADS1115_8SPS},     {16, RATE_ADS1115_16SPS},
+    {32, RATE_ADS1115_32SPS},   {64, RATE_ADS1115_64SPS},
+    {128, RATE_ADS1115_128SPS}, {250, RATE_ADS1115_250SPS},
+    {475, RATE_ADS1115_475SPS}, {860, RATE_ADS1115_860SPS}};
+
+/// Ads1115Io on top of the Adafruit driver.
+class AdafruitAds1115Io : public Ads1115Io {
+ public:
+  AdafruitAds1115Io(Adafruit_ADS1115* ads1115, int alert_pin)
+      : ads1115_{ads1115}, alert_pin_{alert_pin} {
+    if (alert_pin_ >= 0) {
+      pinMode(alert_pin_, INPUT_PULLUP);
+      // ALERT/RDY is active low and pulses at the end of each conversion
+      attachInterruptArg(digitalPinToInterrupt(alert_pin_), alert_isr, this,
+                         FALLING);
+    }
+  }
+
+  void start(int channel, unsigned int data_rate, bool continuous) override {
+    uint16_t bits = RATE_ADS1115_860SPS;
+    for (const auto& rate : kDataRates) {
+      if (rate.sps == data_rate) {
+        bits = rate.bits;
+        break;
+      }
+    }
+    ready_ = false;
+    ads1115_->setDataRate(bits);
+    ads1115_->startADCReading(kMuxByChannel[channel], continuous);
+  }
+
+  bool conversion_complete() override {
+    return alert_pin_ >= 0 ? ready_ : ads1115_->conversionComplete();
+  }
+
+  int16_t read_result() override {
+    return ads1115_->getLastConversionResults();
+  }
+
+ private:
+  static void IRAM_ATTR alert_isr(void* arg) {
+    static_cast<AdafruitAds1115Io*>(arg)->ready_ = true;
+  }
+
+  Adafruit_ADS1115* ads1115_;
+  int alert_pin_;
+  volatile bool ready_ = false;
+};
+
+ADS1115Scanner::ADS1115Scanner(Adafruit_ADS1115* ads1115, int alert_pin,
+                               unsigned int poll_interval)
+    : ads1115_{ads1115},
+      io_{new AdafruitAds1115Io(ads1115, alert_pin)},
+      scheduler_{io_} {
+  sensesp::event_loop()->onRepeat(poll_interval, [this]() { this->poll(); });
+}
+
+void ADS1115Scanner::add_channel(int channel, unsigned int read_interval,
+                                 Callback callback,
+                                 const ADS1115Oversampling& oversampling) {
+  if (!scheduler_.add_channel(channel, read_interval, callback,
+                              oversampling)) {
+    debugE("ADS1115Scanner: invalid channel %d", channel);
+  }
+}
+
+void ADS1115Scanner::poll() {
+  uint32_t poll_start = micros();
+  uint32_t timeouts = scheduler_.get_stats().timeouts;
+
+  scheduler_.tick(poll_start);
+
+  if (scheduler_.get_stats().timeouts != timeouts) {
+    debugW("ADS1115Scanner: conversion timed out");
+  }
+  uint32_t elapsed = micros() - poll_start;
+  if (elapsed > max_poll_us_) {
+    max_poll_us_ = elapsed;
+  }
+}
+
+}  // namespace halmet
@@ -0,0 +1,74 @@
+#ifndef HALMET_SRC_HALMET_ADS1115_SCANNER_H_
+#define HALMET_SRC_HALMET_ADS1115_SCANNER_H_
+
+#include <Adafruit_ADS1X15.h>
+
+#include <cstdint>
+
+#include "ads1115_scheduler.h"
+#include "sensesp_base_app.h"
+
+namespace halmet {
+
+class AdafruitAds1115Io;
+
+/**
+ * @brief Shared, non-blocking conversion scheduler for one ADS1115.
+ *
+ * Runs an Ads1115Scheduler from the event loop; see there for how channels
+ * are scheduled, oversampled and captured. Callbacks are called from the
+ * event loop.
+ *
+ * Without an ALERT/RDY pin, the converter is asked over I2C whether a
+ * conversion is complete, but only once it should be. With the pin, the
+ * pin interrupt signals completion and no I2C traffic is needed for it.
+ */
+class ADS1115Scanner {
+ public:
+  using Callback = Ads1115Scheduler::Callback;
+  using CaptureCallback = Ads1115Scheduler::CaptureCallback;
+
+  /// Time between conversions during a capture, in microseconds (860 SPS).
+  static constexpr uint32_t kCapturePeriod = Ads1115Scheduler::kCapturePeriod;
+
+  ADS1115Scanner(Adafruit_ADS1115* ads1115, int alert_pin = -1,
+                 unsigned int poll_interval = 1);
+
+  /// See Ads1115Scheduler::add_channel().
+  void add_channel(int channel, unsigned int read_interval, Callback callback,
+                   const ADS1115Oversampling& oversampling = {});
+
+  /// See Ads1115Scheduler::start_capture().
+  bool start_capture(int channel, int16_t* buffer, uint32_t* times,
+                     size_t count, CaptureCallback callback) {
+    return scheduler_.start_capture(channel, buffer, times, count, callback);
+  }
+
+  bool is_capturing() const { return scheduler_.is_capturing(); }
+
+  float compute_volts(int16_t adc_output) const {
+    return ads1115_->computeVolts(adc_output);
+  }
+
+  uint32_t get_conversion_count() const {
+    return scheduler_.get_stats().conversions;
+  }
+  uint32_t get_timeout_count() const {
+    return scheduler_.get_stats().timeouts;
+  }
+  /// Longest time a single poll kept the event loop busy, in microseconds.
+  uint32_t get_max_poll_us() const { return max_poll_us_; }
+
+ protected:
+  void poll();
+
+  Adafruit_ADS1115* ads1115_;
+  AdafruitAds1115Io* io_;
+  Ads1115Scheduler scheduler_;
+
+  uint32_t max_poll_us_ = 0;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_HALMET_ADS1115_SCANNER_H_
@@ -1,11 +1,15 @@
 #include "halmet_analog.h"
 
 #include "sensesp/sensors/sensor.h"
-#include "sensesp/signalk/signalk_output.h"
+#include "sensesp/system/observablevalue.h"
 #include "sensesp/system/valueproducer.h"
 #include "sensesp/transforms/curveinterpolator.h"
 #include "sensesp/transforms/linear.h"
+#include "halmet_sk_delta.h"
+#include "rate_limiter.h"
 #include "sensesp/ui/config_item.h"
+#include "sk_delta_batcher.h"
+#include "tank_level_table.h"
 
 namespace halmet {
 
@@ -15,20 +19,78 @@ const float kMeasurementCurrent = 0.01;
 // Default fuel tank size, in m3
 const float kTankDefaultSize = 120. / 1000;
 
-sensesp::FloatProducer* ConnectTankSender(Adafruit_ADS1115* ads1115,
+// Unchanged tank values are repeated this often, in ms
+const unsigned int kTankHeartbeat = 30000;
+
+/// Tank level curve that reports configuration changes.
+class TankLevelCurve : public sensesp::CurveInterpolator {
+ public:
+  using sensesp::CurveInterpolator::CurveInterpolator;
+
+  void set_change_callback(std::function<void()> callback) {
+    change_callback_ = callback;
+  }
+
+  virtual bool from_json(const JsonObject& config) override {
+    bool result = sensesp::CurveInterpolator::from_json(config);
+    if (result && change_callback_) {
+      change_callback_();
+    }
+    return result;
+  }
+
+ protected:
+  std::function<void()> change_callback_;
+};
+
+inline const String ConfigSchema(const TankLevelCurve& obj) {
+  return ConfigSchema(static_cast<const sensesp::CurveInterpolator&>(obj));
+}
+
+/// Tank volume transform whose parameters can be read back.
+class TankVolume : public sensesp::Linear {
+ public:
+  using sensesp::Linear::Linear;
+
+  float get_multiplier() const { return multiplier_; }
+  float get_offset() const { return offset_; }
+};
+
+inline const String ConfigSchema(const TankVolume& obj) {
+  return ConfigSchema(static_cast<const sensesp::Linear&>(obj));
+}
+
+// Report-by-exception stage in front of a tank Signal K output
+static sensesp::Deadband<float>* NewTankDeadband(const String& name,
+                                                 const char* output,
+                                                 float deadband,
+                                                 int sort_order) {
+  char config_path[80];
+  snprintf(config_path, sizeof(config_path), "/Tanks/%s/%s Deadband",
+           name.c_str(), output);
+  char title[80];
+  snprintf(title, sizeof(title), "%s Tank %s Deadband", name.c_str(), output);
+  auto deadband_transform =
+      new sensesp::Deadband<float>(deadband, kTankHeartbeat, config_path);
+  ConfigItem(deadband_transform)
+      ->set_title(title)
+      ->set_description("Minimum change that is sent to Signal K")
+      ->set_sort_order(sort_order);
+  return deadband_transform;
+}
+
+sensesp::FloatProducer* ConnectTankSender(ADS1115Scanner* ads1115_scanner,
                                           int channel, const String& name,
                                           const String& sk_id, int sort_order,
-                                          bool enable_signalk_output) {
+                                          bool enable_signalk_output,
+                                          bool use_lookup_table,
+                                          const ADS1115Oversampling&
+                                              oversampling) {
   const uint ads_read_delay = 500;  // ms
 
   // Configure the sender resistance sensor
 
-  auto sender_resistance =
-      new sensesp::RepeatSensor<float>(ads_read_delay, [ads1115, channel]() {
-        int16_t adc_output = ads1115->readADC_SingleEnded(channel);
-        float adc_output_volts = ads1115->computeVolts(adc_output);
-        return kVoltageDividerScale * adc_output_volts / kMeasurementCurrent;
-      });
+  auto sender_resistance = new sensesp::ObservableValue<float>();
 
   if (enable_signalk_output) {
     char resistance_sk_config_path[80];
@@ -47,21 +109,19 @@ sensesp::FloatProducer* ConnectTankSender(Adafruit_ADS1115* ads1115,
     char resistance_meta_display_name[80];
     snprintf(resistance_meta_display_name, sizeof(resistance_meta_display_name),
              "Resistance %s", name.c_str());
-    char resistance_meta_description[80];
-    snprintf(resistance_meta_description, sizeof(resistance_meta_description),
-             "Measured tank %s sender resistance", name.c_str());
 
-    auto sender_resistance_sk_output = new sensesp::SKOutputFloat(
-        resistance_sk_path, resistance_sk_config_path,
-        new sensesp::SKMetadata("ohm", resistance_meta_display_name,
-                                resistance_meta_description));
+    auto sender_resistance_sk_output = new SKTemplateOutputFloat(
+        resistance_sk_path, resistance_sk_config_path, "ohm",
+        resistance_meta_display_name);
 
     ConfigItem(sender_resistance_sk_output)
         ->set_title(resistance_title)
         ->set_description(resistance_description)
         ->set_sort_order(sort_order);
 
-    sender_resistance->connect_to(sender_resistance_sk_output);
+    sender_resistance
+        ->connect_to(NewTankDeadband(name, "Resistance", 0.5, sort_order + 5))
+        ->connect_to(Batched(sender_resistance_sk_output));
   }
 
   // Configure the piecewise linear interpolator for the tank level (ratio)
@@ -76,9 +136,9 @@ sensesp::FloatProducer* ConnectTankSender(Adafruit_ADS1115* ads1115,
   snprintf(curve_description, sizeof(curve_description),
            "Piecewise linear curve for the %s tank level", name.c_str());
 
-  auto tank_level = (new sensesp::CurveInterpolator(nullptr, curve_config_path))
-                        ->set_input_title("Sender Resistance (ohms)")
-                        ->set_output_title("Fuel Level (ratio)");
+  auto tank_level = new TankLevelCurve(nullptr, curve_config_path);
+  tank_level->set_input_title("Sender Resistance (ohms)")
+      ->set_output_title("Fuel Level (ratio)");
 
   ConfigItem(tank_level)
       ->set_title(curve_title)
@@ -93,7 +153,76 @@ sensesp::FloatProducer* ConnectTankSender(Adafruit_ADS1115* ads1115,
     tank_level->add_sample(sensesp::CurveInterpolator::Sample(1000., 1));
   }
 
-  sender_resistance->connect_to(tank_level);
+  // Configure the linear transform for the tank volume
+
+  char volume_config_path[80];
+  snprintf(volume_config_path, sizeof(volume_config_path),
+           "/Tanks/%s/Total Volume", name.c_str());
+  char volume_title[80];
+  snprintf(volume_title, sizeof(volume_title), "%s Tank Total Volume",
+           name.c_str());
+  char volume_description[80];
+  snprintf(volume_description, sizeof(volume_description),
+           "Calculated total volume of the %s tank", name.c_str());
+  auto tank_volume = new TankVolume(kTankDefaultSize, 0, volume_config_path);
+
+  ConfigItem(tank_volume)
+      ->set_title(volume_title)
+      ->set_description(volume_description)
+      ->set_sort_order(sort_order + 3);
+
+  // Feed the level and volume outputs, either through the transform chain
+  // or from the compiled table
+
+  sensesp::FloatProducer* level_output = tank_level;
+  sensesp::FloatProducer* volume_output = tank_volume;
+
+  if (!use_lookup_table) {
+    ads1115_scanner->add_channel(
+        channel, ads_read_delay,
+        [ads1115_scanner, sender_resistance](int16_t adc_output) {
+          float adc_output_volts = ads1115_scanner->compute_volts(adc_output);
+          sender_resistance->set(kVoltageDividerScale * adc_output_volts /
+                                 kMeasurementCurrent);
+        },
+        oversampling);
+    sender_resistance->connect_to(tank_level);
+    tank_level->connect_to(tank_volume);
+  } else {
+    // The curve and the volume transform only hold the configuration. At a
+    // fixed gain, the resistance is proportional to the ADC code.
+    const float ohms_per_code = ads1115_scanner->compute_volts(INT16_MAX) /
+                                INT16_MAX * kVoltageDividerScale /
+                                kMeasurementCurrent;
+    auto table = new TankLevelTable();
+    auto rebuild = [table, tank_level, ohms_per_code, name]() {
+      std::vector<TankLevelTable::Point> curve;
+      for (const auto& sample : tank_level->get_samples()) {
+        curve.push_back({sample.input_, sample.output_});
+      }
+      table->build(curve, ohms_per_code);
+      debugD("%s tank level table: %u entries", name.c_str(), table->size());
+    };
+    rebuild();
+    tank_level->set_change_callback(rebuild);
+
+    auto level = new sensesp::ObservableValue<float>();
+    auto volume = new sensesp::ObservableValue<float>();
+    level_output = level;
+    volume_output = volume;
+
+    ads1115_scanner->add_channel(
+        channel, ads_read_delay,
+        [sender_resistance, table, tank_volume, level, volume,
+         ohms_per_code](int16_t adc_output) {
+          sender_resistance->set(adc_output * ohms_per_code);
+          float level_value = table->level(adc_output);
+          level->set(level_value);
+          volume->set(level_value * tank_volume->get_multiplier() +
+                      tank_volume->get_offset());
+        },
+        oversampling);
+  }
 
   if (enable_signalk_output) {
     char level_config_path[80];
@@ -111,44 +240,21 @@ sensesp::FloatProducer* ConnectTankSender(Adafruit_ADS1115* ads1115,
     char level_meta_display_name[80];
     snprintf(level_meta_display_name, sizeof(level_meta_display_name),
              "Tank %s level", name.c_str());
-    char level_meta_description[80];
-    snprintf(level_meta_description, sizeof(level_meta_description),
-             "Tank %s level", name.c_str());
 
-    auto tank_level_sk_output = new sensesp::SKOutputFloat(
-        level_sk_path, level_config_path,
-        new sensesp::SKMetadata("ratio", level_meta_display_name,
-                                level_meta_description));
+    auto tank_level_sk_output = new SKTemplateOutputFloat(
+        level_sk_path, level_config_path, "ratio",
+        level_meta_display_name);
 
     ConfigItem(tank_level_sk_output)
         ->set_title(level_title)
         ->set_description(level_description)
         ->set_sort_order(sort_order + 2);
 
-    tank_level->connect_to(tank_level_sk_output);
+    level_output
+        ->connect_to(NewTankDeadband(name, "Level", 0.002, sort_order + 6))
+        ->connect_to(Batched(tank_level_sk_output));
   }
 
-  // Configure the linear transform for the tank volume
-
-  char volume_config_path[80];
-  snprintf(volume_config_path, sizeof(volume_config_path),
-           "/Tanks/%s/Total Volume", name.c_str());
-  char volume_title[80];
-  snprintf(volume_title, sizeof(volume_title), "%s Tank Total Volume",
-           name.c_str());
-  char volume_description[80];
-  snprintf(volume_description, sizeof(volume_description),
-           "Calculated total volume of the %s tank", name.c_str());
-  auto tank_volume =
-      new sensesp::Linear(kTankDefaultSize, 0, volume_config_path);
-
-  ConfigItem(tank_volume)
-      ->set_title(volume_title)
-      ->set_description(volume_description)
-      ->set_sort_order(sort_order + 3);
-
-  tank_level->connect_to(tank_volume);
-
   if (enable_signalk_output) {
     char volume_sk_config_path[80];
     snprintf(volume_sk_config_path, sizeof(volume_sk_config_path),
@@ -165,24 +271,22 @@ sensesp::FloatProducer* ConnectTankSender(Adafruit_ADS1115* ads1115,
     char volume_meta_display_name[80];
     snprintf(volume_meta_display_name, sizeof(volume_meta_display_name),
              "Tank %s volume", name.c_str());
-    char volume_meta_description[80];
-    snprintf(volume_meta_description, sizeof(volume_meta_description),
-             "Calculated tank %s remaining volume", name.c_str());
 
-    auto tank_volume_sk_output = new sensesp::SKOutputFloat(
-        volume_sk_path, volume_sk_config_path,
-        new sensesp::SKMetadata("m3", volume_meta_display_name,
-                                volume_meta_description));
+    auto tank_volume_sk_output = new SKTemplateOutputFloat(
+        volume_sk_path, volume_sk_config_path, "m3",
+        volume_meta_display_name);
 
     ConfigItem(tank_volume_sk_output)
         ->set_title(volume_title)
         ->set_description(volume_description)
         ->set_sort_order(sort_order + 4);
 
-    tank_volume->connect_to(tank_volume_sk_output);
+    volume_output
+        ->connect_to(NewTankDeadband(name, "Volume", 0.0002, sort_order + 7))
+        ->connect_to(Batched(tank_volume_sk_output));
   }
 
-  return tank_level;
+  return level_output;
 }
 
 }  // namespace halmet
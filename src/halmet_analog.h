@@ -3,6 +3,7 @@
 
 #include <Adafruit_ADS1X15.h>
 
+#include "halmet_ads1115_scanner.h"
 #include "sensesp/sensors/sensor.h"
 #include "sensesp_base_app.h"
 
@@ -11,68 +12,94 @@ namespace halmet {
 // HALMET voltage divider scale factor
 const float kVoltageDividerScale = 33.3 / 3.3;
 
-sensesp::FloatProducer* ConnectTankSender(Adafruit_ADS1115* ads1115,
+/**
+ * @brief Connect a resistive tank sender to one ADS1115 channel.
+ *
+ * The level curve and the tank volume are configured in the UI. With
+ * use_lookup_table, the curve is compiled into a TankLevelTable indexed by
+ * ADC code, rebuilt whenever the curve changes, and each conversion takes
+ * one table lookup instead of the float transform chain. oversampling
+ * sets the ADS1115 burst size and data rate of the sender channel.
+ *
+ * @return The tank level producer
+ */
+sensesp::FloatProducer* ConnectTankSender(ADS1115Scanner* ads1115_scanner,
                                           int channel, const String& name,
                                           const String& sk_id, int sort_order,
-                                          bool enable_signalk_output = true);
-
+                                          bool enable_signalk_output = true,
+                                          bool use_lookup_table = false,
+                                          const ADS1115Oversampling&
+                                              oversampling = {});
+
+/**
+ * @brief Voltage on one ADS1115 input, scaled by the HALMET input divider.
+ *
+ * With oversampling, every reading is a burst of conversions reduced to one
+ * value by the scanner; see ADS1115Scanner.
+ */
 class ADS1115VoltageInput : public sensesp::FloatSensor {
  public:
-  ADS1115VoltageInput(Adafruit_ADS1115* ads1115, int channel,
+  ADS1115VoltageInput(ADS1115Scanner* ads1115_scanner, int channel,
                       const String& config_path,
                       unsigned int read_interval = 1000,
-                      float calibration_factor = 1.0)
+                      float calibration_factor = 1.0,
+                      const ADS1115Oversampling& oversampling = {})
       : sensesp::FloatSensor(config_path),
-        ads1115_{ads1115},
+        ads1115_scanner_{ads1115_scanner},
         channel_{channel},
         read_interval_{read_interval},
-        calibration_factor_{calibration_factor} {
+        calibration_factor_{calibration_factor},
+        oversampling_{oversampling} {
     load();
 
-    repeat_event_ = set_repeat_event(read_interval_);
+    ads1115_scanner_->add_channel(
+        channel_, read_interval_,
+        [this](int16_t adc_output) { this->update(adc_output); },
+        oversampling_);
   }
 
-  void update() {
-    int16_t adc_output = ads1115_->readADC_SingleEnded(channel_);
-    float adc_output_volts = ads1115_->computeVolts(adc_output);
-    this->emit(calibration_factor_ * kVoltageDividerScale * adc_output_volts);
+  void update(int16_t adc_output) { this->emit(to_volts(adc_output)); }
+
+  /// Input voltage for an ADC code of this channel.
+  float to_volts(int16_t adc_output) const {
+    float adc_output_volts = ads1115_scanner_->compute_volts(adc_output);
+    return calibration_factor_ * kVoltageDividerScale * adc_output_volts;
   }
 
-  void get_configuration(JsonObject& root) {
-    root["read_delay"] = read_interval_;
-    root["calibration_value"] = calibration_factor_;
+  ADS1115Scanner* get_scanner() const { return ads1115_scanner_; }
+  int get_channel() const { return channel_; }
+
+  virtual bool to_json(JsonObject& root) override {
+    root["read_interval"] = read_interval_;
+    root["calibration_factor"] = calibration_factor_;
+    root["samples"] = oversampling_.samples;
+    root["data_rate"] = oversampling_.data_rate;
+    return true;
   };
 
-  bool set_configuration(const JsonObject& config) {
-    String expected[] = {"read_interval"};
+  virtual bool from_json(const JsonObject& config) override {
     if (!config["read_interval"].is<int>()) {
       return false;
     }
     if (config["calibration_factor"].is<float>()) {
       calibration_factor_ = config["calibration_factor"];
     }
+    if (config["samples"].is<int>()) {
+      oversampling_.samples = config["samples"];
+    }
+    if (config["data_rate"].is<int>()) {
+      oversampling_.data_rate = config["data_rate"];
+    }
     read_interval_ = config["read_interval"];
     return true;
   }
 
- protected:
-  reactesp::RepeatEvent* repeat_event_ = nullptr;
-
-  reactesp::RepeatEvent* set_repeat_event(unsigned int read_interval) {
-    if (repeat_event_ != nullptr) {
-      repeat_event_->remove(sensesp::event_loop());
-    }
-
-    repeat_event_ = sensesp::event_loop()->onRepeat(
-        read_interval, [this]() { this->update(); });
-    return repeat_event_;
-  }
-
  private:
-  Adafruit_ADS1115* ads1115_;
+  ADS1115Scanner* ads1115_scanner_;
   int channel_;
   unsigned int read_interval_;
   float calibration_factor_;
+  ADS1115Oversampling oversampling_;
 };
 
 inline const String ConfigSchema(const ADS1115VoltageInput& obj) {
@@ -80,7 +107,9 @@ inline const String ConfigSchema(const ADS1115VoltageInput& obj) {
       "type": "object",
       "properties": {
           "read_interval": { "title": "Read interval", "type": "number", "description": "Number of milliseconds between each reading" },
-          "calibration_factor": { "title": "Calibration factor", "type": "number", "description": "Scale factor to fix the input calibration" }
+          "calibration_factor": { "title": "Calibration factor", "type": "number", "description": "Scale factor to fix the input calibration" },
+          "samples": { "title": "Samples per reading", "type": "integer", "description": "Conversions per reading, 1-32. About the middle half of the sorted samples is averaged." },
+          "data_rate": { "title": "Data rate", "type": "integer", "description": "Conversions per second: 8, 16, 32, 64, 128, 250, 475 or 860" }
       }
     })###";
 
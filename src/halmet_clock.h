@@ -0,0 +1,73 @@
+#ifndef HALMET_SRC_HALMET_CLOCK_H_
+#define HALMET_SRC_HALMET_CLOCK_H_
+
+// Monotonic time source for code that must also build on the host.
+//
+// On the device these are just Arduino's millis() and micros(). In the
+// native environment they fall back to std::chrono, so timing-dependent
+// logic can be exercised and benchmarked without a board, or to a
+// FakeClock that tests set by hand.
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <chrono>
+#include <cstdint>
+#endif
+
+namespace halmet {
+
+#ifndef ARDUINO
+/// Host only: while enabled, ClockMillis() and ClockMicros() return this
+/// clock's time instead of the steady clock's.
+class FakeClock {
+ public:
+  static void enable(uint64_t now_us = 0) {
+    enabled_ = true;
+    now_us_ = now_us;
+  }
+  static void disable() { enabled_ = false; }
+  static bool is_enabled() { return enabled_; }
+
+  static uint64_t now_us() { return now_us_; }
+  static void set_us(uint64_t now_us) { now_us_ = now_us; }
+  static void advance_us(uint64_t us) { now_us_ += us; }
+  static void advance_ms(uint64_t ms) { now_us_ += ms * 1000; }
+
+ private:
+  static inline bool enabled_ = false;
+  static inline uint64_t now_us_ = 0;
+};
+#endif
+
+inline unsigned long ClockMillis() {
+#ifdef ARDUINO
+  return millis();
+#else
+  if (FakeClock::is_enabled()) {
+    return static_cast<unsigned long>(FakeClock::now_us() / 1000);
+  }
+  using namespace std::chrono;
+  return static_cast<unsigned long>(
+      duration_cast<milliseconds>(steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+inline unsigned long ClockMicros() {
+#ifdef ARDUINO
+  return micros();
+#else
+  if (FakeClock::is_enabled()) {
+    return static_cast<unsigned long>(FakeClock::now_us());
+  }
+  using namespace std::chrono;
+  return static_cast<unsigned long>(
+      duration_cast<microseconds>(steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_HALMET_CLOCK_H_
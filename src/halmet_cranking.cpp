@@ -0,0 +1,107 @@
+#include "halmet_cranking.h"
+
+#include "cranking_analysis.h"
+#include "sensesp_base_app.h"
+
+namespace halmet {
+
+CrankingCapture::CrankingCapture(ADS1115VoltageInput* input,
+                                 String config_path)
+    : sensesp::FileSystemSaveable(config_path), input_{input} {
+  load();
+  if (duration_ > kMaxDuration) {
+    duration_ = kMaxDuration;
+  }
+  // Allocated once, so a capture never fails for lack of memory
+  buffer_.resize(duration_ * 1000 / ADS1115Scanner::kCapturePeriod);
+  times_.resize(buffer_.size());
+  input_->connect_to(&voltage_);
+}
+
+void CrankingCapture::update_voltage(float value) {
+  if (capturing_) {
+    return;
+  }
+  if (value >= trigger_voltage_) {
+    baseline_ = value;
+  } else if (last_revolutions_ < trigger_revolutions_) {
+    trigger("voltage drop");
+  }
+}
+
+void CrankingCapture::update_revolutions(float value) {
+  bool rising = last_revolutions_ < trigger_revolutions_ &&
+                value >= trigger_revolutions_;
+  last_revolutions_ = value;
+  if (rising) {
+    trigger("engine turning");
+  }
+}
+
+void CrankingCapture::trigger(const char* reason) {
+  if (capturing_ || buffer_.empty() ||
+      (captured_before_ && millis() - last_capture_ < kRetriggerHoldoff)) {
+    return;
+  }
+  bool started = input_->get_scanner()->start_capture(
+      input_->get_channel(), buffer_.data(), times_.data(), buffer_.size(),
+      [this](size_t count) { this->finish(count); });
+  if (started) {
+    debugI("Cranking capture started: %s", reason);
+    capturing_ = true;
+  }
+}
+
+void CrankingCapture::finish(size_t count) {
+  capturing_ = false;
+  captured_before_ = true;
+  last_capture_ = millis();
+  captures_++;
+  if (count == 0) {
+    return;
+  }
+
+  // Before the first regular reading, the end of the capture is the best
+  // guess of the resting voltage
+  float baseline =
+      std::isnan(baseline_) ? input_->to_volts(buffer_[count - 1]) : baseline_;
+  // to_volts() is linear in the ADC code
+  float volts_per_code = input_->to_volts(INT16_MAX) / INT16_MAX;
+  CrankingSummary summary = AnalyzeCranking(
+      buffer_.data(), times_.data(), count, volts_per_code, baseline,
+      recovery_ratio_ * baseline);
+
+  debugI("Cranking: minimum %.2f V after %.2f s, recovered in %.2f s, "
+         "sag %.2f V*s",
+         summary.minimum, summary.time_to_minimum, summary.recovery_time,
+         summary.sag_integral);
+  minimum_voltage_.set(summary.minimum);
+  recovery_time_.set(summary.recovery_time);
+  sag_integral_.set(summary.sag_integral);
+}
+
+bool CrankingCapture::to_json(JsonObject& root) {
+  root["trigger_voltage"] = trigger_voltage_;
+  root["trigger_revolutions"] = trigger_revolutions_;
+  root["duration"] = duration_;
+  root["recovery_ratio"] = recovery_ratio_;
+  return true;
+}
+
+bool CrankingCapture::from_json(const JsonObject& config) {
+  if (config["trigger_voltage"].is<float>()) {
+    trigger_voltage_ = config["trigger_voltage"];
+  }
+  if (config["trigger_revolutions"].is<float>()) {
+    trigger_revolutions_ = config["trigger_revolutions"];
+  }
+  if (config["duration"].is<int>()) {
+    duration_ = config["duration"];
+  }
+  if (config["recovery_ratio"].is<float>()) {
+    recovery_ratio_ = config["recovery_ratio"];
+  }
+  return true;
+}
+
+}  // namespace halmet
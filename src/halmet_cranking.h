@@ -0,0 +1,94 @@
+#ifndef HALMET_SRC_HALMET_CRANKING_H_
+#define HALMET_SRC_HALMET_CRANKING_H_
+
+#include <cmath>
+#include <vector>
+
+#include "halmet_analog.h"
+#include "sensesp/system/lambda_consumer.h"
+#include "sensesp/system/observablevalue.h"
+#include "sensesp/system/saveable.h"
+
+namespace halmet {
+
+/**
+ * @brief Captures the battery voltage dip while the engine is cranked.
+ *
+ * A capture is triggered when the engine revolutions rise through
+ * trigger_revolutions, or when a regular reading of the battery input drops
+ * below trigger_voltage while the engine isn't running. The input's ADS1115
+ * channel is then converted at 860 SPS for the configured duration, and
+ * the conversions read by the scanner are stored with their times into
+ * buffers allocated at startup. A summary is published: the minimum
+ * voltage, the time from the minimum until the voltage is back at
+ * recovery_ratio of the resting voltage, and the integral of the drop
+ * below the resting voltage. The resting voltage is the last regular
+ * reading above trigger_voltage.
+ *
+ * After a capture, triggers are ignored for kRetriggerHoldoff, so a weak
+ * battery doesn't keep the ADS1115 from scanning its other channels.
+ */
+class CrankingCapture : public sensesp::FileSystemSaveable {
+ public:
+  CrankingCapture(ADS1115VoltageInput* input, String config_path = "");
+
+  sensesp::LambdaConsumer<float> revolutions_{
+      [this](float value) { this->update_revolutions(value); }};
+
+  sensesp::ObservableValue<float> minimum_voltage_;  // V
+  sensesp::ObservableValue<float> recovery_time_;    // s
+  sensesp::ObservableValue<float> sag_integral_;     // V*s
+
+  uint32_t get_capture_count() const { return captures_; }
+
+  virtual bool to_json(JsonObject& root) override;
+  virtual bool from_json(const JsonObject& config) override;
+
+ protected:
+  static const unsigned int kMaxDuration = 10000;         // ms
+  static const unsigned long kRetriggerHoldoff = 60000;  // ms
+
+  void update_voltage(float value);
+  void update_revolutions(float value);
+  void trigger(const char* reason);
+  void finish(size_t count);
+
+  ADS1115VoltageInput* input_;
+
+  float trigger_voltage_ = 11.5;     // V
+  float trigger_revolutions_ = 1.0;  // Hz
+  unsigned int duration_ = 3000;     // ms
+  float recovery_ratio_ = 0.95;
+
+  std::vector<int16_t> buffer_;
+  std::vector<uint32_t> times_;
+  sensesp::LambdaConsumer<float> voltage_{
+      [this](float value) { this->update_voltage(value); }};
+
+  float baseline_ = NAN;
+  float last_revolutions_ = 0;
+  bool capturing_ = false;
+  bool captured_before_ = false;
+  unsigned long last_capture_ = 0;
+  uint32_t captures_ = 0;
+};
+
+inline const String ConfigSchema(const CrankingCapture& obj) {
+  return R"###({
+    "type": "object",
+    "properties": {
+      "trigger_voltage": { "title": "Trigger voltage", "type": "number", "description": "Capture when the battery voltage drops below this while the engine is stopped, in V" },
+      "trigger_revolutions": { "title": "Trigger revolutions", "type": "number", "description": "Capture when the engine revolutions rise through this, in Hz" },
+      "duration": { "title": "Capture duration", "type": "integer", "description": "Length of a capture, in ms (at most 10000)" },
+      "recovery_ratio": { "title": "Recovery ratio", "type": "number", "description": "Fraction of the resting voltage at which the battery counts as recovered" }
+    }
+  })###";
+}
+
+inline bool ConfigRequiresRestart(const CrankingCapture& obj) {
+  return true;
+}
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_HALMET_CRANKING_H_
@@ -1,10 +1,12 @@
 #include "halmet_digital.h"
+#include "halmet_tacho_input.h"
 #include "sensesp/transforms/moving_average.h" 
 #include "sensesp/sensors/digital_input.h"
 #include "sensesp/sensors/sensor.h"
 #include "sensesp/signalk/signalk_output.h"
-#include "sensesp/transforms/frequency.h"
 #include "sensesp/ui/config_item.h"
+#include "halmet_sk_delta.h"
+#include "sk_delta_batcher.h"
 
 using namespace sensesp;
 
@@ -16,12 +18,13 @@ FloatProducer* ConnectTachoSender(int pin, String name) {
   char config_title[80];
   char config_description[80];
 
-  snprintf(config_path, sizeof(config_path), "", name.c_str());
+  snprintf(config_path, sizeof(config_path), "/Tacho %s/Input", name.c_str());
   snprintf(config_title, sizeof(config_title), "Tacho %s Pin", name.c_str());
   snprintf(config_description, sizeof(config_description), "Tacho %s Input Pin",
            name.c_str());
-  auto tacho_input =
-      new DigitalInputCounter(pin, INPUT, RISING, 500, config_path);
+  // Times the pulses at low frequencies and counts them in the PCNT
+  // peripheral at high frequencies; emits the input frequency every 50 ms
+  auto tacho_input = new halmet::TachoInput(pin, 50, 300, config_path);
 
   ConfigItem(tacho_input)
       ->set_title(config_title)
@@ -33,7 +36,12 @@ FloatProducer* ConnectTachoSender(int pin, String name) {
            name.c_str());
   snprintf(config_description, sizeof(config_description),
            "Tacho %s Multiplier", name.c_str());
-  auto tacho_frequency = new Frequency(kDefaultFrequencyScale, config_path);
+  auto tacho_frequency =
+      new halmet::TachoMultiplier(kDefaultFrequencyScale, 0, config_path);
+
+  ConfigItem(tacho_frequency)
+      ->set_title(config_title)
+      ->set_description(config_description);
 
   tacho_input->connect_to(tacho_frequency);
 // configure a smoothing window of N samples (e.g. 10)
@@ -45,7 +53,7 @@ FloatProducer* ConnectTachoSender(int pin, String name) {
            "Number of samples to average for smoothing RPM", name.c_str());
   
 
-  auto tacho_smoother = new MovingAverage(5, 1.0, config_path);
+  auto tacho_smoother = new MovingAverage(2, 1.0, config_path);
   
   ConfigItem(tacho_smoother)
       ->set_title(config_title)
@@ -61,13 +69,14 @@ FloatProducer* ConnectTachoSender(int pin, String name) {
   snprintf(config_description, sizeof(config_description),
            "Tacho %s Signal K Path", name.c_str());
 
-  auto tacho_frequency_sk_output = new SKOutputFloat(sk_path, config_path);
+  auto tacho_frequency_sk_output =
+      new halmet::SKTemplateOutputFloat(sk_path, config_path, "Hz");
 
   ConfigItem(tacho_frequency_sk_output)
       ->set_title(config_title)
       ->set_description(config_description);
 
-  tacho_smoother->connect_to(tacho_frequency_sk_output);
+  tacho_smoother->connect_to(halmet::Batched(tacho_frequency_sk_output));
 
   return tacho_frequency;
 }
@@ -94,6 +103,7 @@ BoolProducer* ConnectAlarmSender(int pin, String name) {
       ->set_title(config_title)
       ->set_description(config_description);
 
+  // Not batched: an alarm goes out as soon as it changes
   alarm_input->connect_to(alarm_sk_output);
 #endif
 
@@ -0,0 +1,35 @@
+#include "halmet_flash_partition.h"
+
+#include "sensesp.h"
+
+namespace halmet {
+
+FlashPartition::FlashPartition(const char* label) {
+  partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                        ESP_PARTITION_SUBTYPE_ANY, label);
+  if (partition_ == nullptr) {
+    debugE("Flash partition '%s' not found", label);
+  }
+}
+
+size_t FlashPartition::size() const {
+  return partition_ ? partition_->size : 0;
+}
+
+bool FlashPartition::read(size_t offset, void* data, size_t len) {
+  return partition_ &&
+         esp_partition_read(partition_, offset, data, len) == ESP_OK;
+}
+
+bool FlashPartition::write(size_t offset, const void* data, size_t len) {
+  return partition_ &&
+         esp_partition_write(partition_, offset, data, len) == ESP_OK;
+}
+
+bool FlashPartition::erase_sector(size_t sector) {
+  return partition_ &&
+         esp_partition_erase_range(partition_, sector * SPI_FLASH_SEC_SIZE,
+                                   SPI_FLASH_SEC_SIZE) == ESP_OK;
+}
+
+}  // namespace halmet
@@ -0,0 +1,34 @@
+#ifndef HALMET_SRC_HALMET_FLASH_PARTITION_H_
+#define HALMET_SRC_HALMET_FLASH_PARTITION_H_
+
+#include <esp_partition.h>
+
+#include "flash_log.h"
+
+namespace halmet {
+
+/**
+ * @brief FlashStorage backed by a raw data partition.
+ *
+ * The partition is looked up by label in the partition table. If it is
+ * missing, is_valid() returns false and all accesses fail.
+ */
+class FlashPartition : public FlashStorage {
+ public:
+  explicit FlashPartition(const char* label);
+
+  bool is_valid() const { return partition_ != nullptr; }
+
+  size_t size() const override;
+  size_t sector_size() const override { return SPI_FLASH_SEC_SIZE; }
+  bool read(size_t offset, void* data, size_t len) override;
+  bool write(size_t offset, const void* data, size_t len) override;
+  bool erase_sector(size_t sector) override;
+
+ private:
+  const esp_partition_t* partition_;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_HALMET_FLASH_PARTITION_H_
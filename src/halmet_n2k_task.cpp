@@ -0,0 +1,75 @@
+#include "halmet_n2k_task.h"
+
+#include "sensesp_base_app.h"
+
+namespace halmet {
+
+const uint32_t kN2kTaskStackSize = 4096;
+const UBaseType_t kN2kTaskPriority = 5;
+
+N2kReceiveTask::N2kReceiveTask(HalmetNMEA2000* nmea2000,
+                               unsigned int report_interval, int core,
+                               unsigned int drain_interval)
+    : nmea2000_{nmea2000},
+      report_interval_{report_interval},
+      core_{core},
+      drain_interval_{drain_interval} {}
+
+void N2kReceiveTask::start() {
+  sensesp::event_loop()->onRepeat(drain_interval_,
+                                  [this]() { values_.drain(); });
+
+  xTaskCreatePinnedToCore(task_entry, "n2k_rx", kN2kTaskStackSize, this,
+                          kN2kTaskPriority, nullptr, core_);
+}
+
+void N2kReceiveTask::task_entry(void* arg) {
+  static_cast<N2kReceiveTask*>(arg)->run();
+}
+
+void N2kReceiveTask::run() {
+  TickType_t last_report = xTaskGetTickCount();
+
+  while (true) {
+    nmea2000_->parse_messages();
+
+    // Hand queued messages to the driver until its frame buffer is full;
+    // whatever does not fit waits in the priority queue for the next round
+    if (tx_queue_ != nullptr) {
+      tx_queue_->drain(
+          [this](const tN2kMsg& msg) { return nmea2000_->SendMsg(msg); });
+    }
+
+    if (report_interval_ > 0 &&
+        xTaskGetTickCount() - last_report >= pdMS_TO_TICKS(report_interval_)) {
+      last_report = xTaskGetTickCount();
+      report();
+    }
+
+    // Yield for one tick; the receive buffer holds far more than the bus
+    // can deliver in a millisecond.
+    vTaskDelay(1);
+  }
+}
+
+void N2kReceiveTask::report() {
+  nmea2000_->report();
+  debugI("N2K queue: depth %u, high water %u/%u, %u dropped, %u unbound",
+         get_queue_depth(), get_queue_high_water(), kQueueSize,
+         get_queue_dropped(), values_.get_unbound());
+
+  if (tx_queue_ == nullptr) {
+    return;
+  }
+  static const char* const kClassNames[] = {"rapid", "dynamic", "slow"};
+  for (int i = 0; i < kNumN2kTxClasses; i++) {
+    auto stats = tx_queue_->get_stats(static_cast<N2kTxClass>(i));
+    debugI("N2K tx %s: %u queued, %u sent, %u coalesced, %u dropped, "
+           "max latency %u ms",
+           kClassNames[i], stats.enqueued, stats.sent, stats.coalesced,
+           stats.dropped, stats.max_latency_ms);
+  }
+  tx_queue_->clear_stats();
+}
+
+}  // namespace halmet
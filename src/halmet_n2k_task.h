@@ -0,0 +1,69 @@
+#ifndef HALMET_SRC_HALMET_N2K_TASK_H_
+#define HALMET_SRC_HALMET_N2K_TASK_H_
+
+#include "halmet_nmea2000.h"
+#include "n2k_tx_queue.h"
+#include "n2k_value_queue.h"
+#include "sensesp/system/valueconsumer.h"
+
+namespace halmet {
+
+/**
+ * @brief FreeRTOS task that drains and decodes NMEA 2000 frames.
+ *
+ * The task runs ParseMessages() on its own core, so slow event loop
+ * callbacks can no longer delay frame draining. Message handlers therefore
+ * run in this task and must not touch SensESP objects directly. Instead,
+ * they post() decoded values into an N2kValueQueue. The event loop drains
+ * the queue and sets each value on the consumer bound to its ID with
+ * bind(). Neither side allocates or builds strings per value.
+ *
+ * Once the task is started, it owns the tNMEA2000 object: no other task may
+ * call into it. Outgoing messages are therefore put into an N2kTxQueue,
+ * which the task drains into the driver in priority order.
+ */
+class N2kReceiveTask {
+ public:
+  N2kReceiveTask(HalmetNMEA2000* nmea2000, unsigned int report_interval = 0,
+                 int core = 0, unsigned int drain_interval = 5);
+
+  void start();
+
+  /// Queue a decoded value for the event loop. Call only from message
+  /// handlers, i.e. from within the task. IdEnum is the decoder's enum of
+  /// value IDs.
+  template <typename IdEnum>
+  bool post(IdEnum id, float value) { return values_.post(id, value); }
+
+  /// Deliver the values posted with id to consumer. Call before start().
+  template <typename IdEnum>
+  void bind(IdEnum id, sensesp::ValueConsumer<float>* consumer) {
+    values_.bind(id, consumer);
+  }
+
+  /// Transmit the messages put into tx_queue. Call before start().
+  void set_tx_queue(N2kTxQueue* tx_queue) { tx_queue_ = tx_queue; }
+
+  size_t get_queue_depth() const { return values_.size(); }
+  size_t get_queue_high_water() const { return values_.get_high_water(); }
+  uint32_t get_queue_dropped() const { return values_.get_dropped(); }
+
+ protected:
+  static void task_entry(void* arg);
+  void run();
+  void report();
+
+  static const size_t kQueueSize = 64;
+
+  HalmetNMEA2000* nmea2000_;
+  unsigned int report_interval_;
+  int core_;
+  unsigned int drain_interval_;
+
+  N2kValueQueue<sensesp::ValueConsumer<float>, kQueueSize> values_;
+  N2kTxQueue* tx_queue_ = nullptr;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_HALMET_N2K_TASK_H_
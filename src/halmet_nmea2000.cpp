@@ -0,0 +1,220 @@
+#include "halmet_nmea2000.h"
+
+#include <SPIFFS.h>
+#include <driver/twai.h>
+#include <esp_timer.h>
+
+#include "sensesp.h"
+#include "sensesp_base_app.h"
+
+namespace halmet {
+
+// Same depth as the receive frame buffer configured in main.cpp; replayed
+// frames beyond this backlog are counted as dropped.
+const size_t kReplayRxBufferFrames = 250;
+
+// Writing the whole capture at once would block the event loop for seconds
+// on a serial console; a few frames per pass keep up with 115200 baud.
+const unsigned int kCaptureDumpInterval = 10;  // ms
+const size_t kCaptureDumpFramesPerPoll = 2;
+
+HalmetNMEA2000* HalmetNMEA2000::instance_ = nullptr;
+
+HalmetNMEA2000::HalmetNMEA2000(gpio_num_t tx_pin, gpio_num_t rx_pin)
+    : tNMEA2000_esp32(tx_pin, rx_pin) {
+  instance_ = this;
+  report_start_us_ = esp_timer_get_time();
+}
+
+void HalmetNMEA2000::enable_capture(size_t capacity, Print* dump_output) {
+  capture_.reset(new N2kFrameRing(capacity));
+  capture_dump_output_ = dump_output;
+  if (dump_output != nullptr) {
+    sensesp::event_loop()->onRepeat(kCaptureDumpInterval,
+                                    [this]() { this->poll_capture_dump(); });
+  }
+}
+
+void HalmetNMEA2000::poll_capture_dump() {
+  if (capture_dump_output_ == nullptr || !capture_complete_.load()) {
+    return;
+  }
+  for (size_t i = 0; i < kCaptureDumpFramesPerPoll; i++) {
+    if (capture_dumped_ == capture_->size()) {
+      capture_dump_output_ = nullptr;
+      return;
+    }
+    dump_frame(*capture_dump_output_, capture_->at(capture_dumped_++));
+  }
+}
+
+bool HalmetNMEA2000::enable_replay(const char* path, float speed) {
+  replay_file_ = SPIFFS.open(path, "r");
+  if (!replay_file_) {
+    debugE("Unable to open NMEA 2000 replay log %s", path);
+    return false;
+  }
+  replayer_.reset(new N2kFrameReplayer(
+      [this](char* buf, size_t size) {
+        if (!replay_file_.available()) {
+          return false;
+        }
+        size_t len = replay_file_.readBytesUntil('\n', buf, size - 1);
+        buf[len] = '\0';
+        return true;
+      },
+      speed, kReplayRxBufferFrames));
+  debugI("Replaying NMEA 2000 log %s at %.1fx", path, speed);
+  return true;
+}
+
+void HalmetNMEA2000::enable_pgn_filter(const N2kPgnFilter& filter) {
+  pgn_filter_.reset(new N2kPgnFilter(filter));
+
+  // The CAN driver sets up the controller to accept everything, so the
+  // filter runs in software. A single hardware code/mask pair wouldn't buy
+  // much anyway: it has to pass the network management PGNs too, which
+  // leaves most PGN bits as "don't care".
+  CanAcceptanceFilter hw_filter = pgn_filter_->get_acceptance_filter();
+  debugI("N2K PGN filter: %u PGNs allowed; a hardware filter (code %08X, "
+         "mask %08X) would pass %.1f%% of PGNs",
+         pgn_filter_->get_pgns().size(), hw_filter.code, hw_filter.mask,
+         100.0 * hw_filter.pgn_pass_ratio());
+}
+
+void HalmetNMEA2000::set_timed_msg_handler(void (*handler)(const tN2kMsg&)) {
+  msg_handler_ = handler;
+  SetMsgHandler(timed_handler);
+}
+
+void HalmetNMEA2000::timed_handler(const tN2kMsg& msg) {
+  if (instance_ == nullptr || instance_->msg_handler_ == nullptr) {
+    return;
+  }
+  int64_t start = esp_timer_get_time();
+  instance_->msg_handler_(msg);
+  instance_->pgn_stats_.record(msg.PGN, esp_timer_get_time() - start);
+}
+
+void HalmetNMEA2000::parse_messages() {
+  int64_t start = esp_timer_get_time();
+  ParseMessages();
+  parse_us_ += esp_timer_get_time() - start;
+}
+
+bool HalmetNMEA2000::CANGetFrame(unsigned long& id, unsigned char& len,
+                                 unsigned char* buf) {
+  // Skip over filtered frames here; returning false would end the
+  // library's read loop for this ParseMessages() call
+  while (read_frame(id, len, buf)) {
+    if (!pgn_filter_ || pgn_filter_->accepts(id)) {
+      return true;
+    }
+    filtered_++;
+  }
+  return false;
+}
+
+bool HalmetNMEA2000::read_frame(unsigned long& id, unsigned char& len,
+                                unsigned char* buf) {
+  N2kCanFrame frame;
+
+  if (replayer_) {
+    if (!replayer_->next(esp_timer_get_time(), &frame)) {
+      return false;
+    }
+    id = frame.id;
+    len = frame.len;
+    memcpy(buf, frame.data, frame.len);
+  } else {
+    if (!tNMEA2000_esp32::CANGetFrame(id, len, buf)) {
+      return false;
+    }
+    if (capture_ && !capture_complete_.load(std::memory_order_relaxed)) {
+      frame.timestamp_us = esp_timer_get_time();
+      frame.id = id;
+      frame.len = len;
+      memcpy(frame.data, buf, len);
+      capture_->push(frame, true);
+      // A capture that is to be dumped is frozen once full, so the event
+      // loop can read it without racing this task
+      if (capture_dump_output_ != nullptr && capture_->full()) {
+        capture_complete_.store(true);
+      }
+    }
+  }
+
+  frames_++;
+  frame_bits_ += N2kFrameBits(len);
+  return true;
+}
+
+void HalmetNMEA2000::report() {
+  int64_t now = esp_timer_get_time();
+  float elapsed_s = (now - report_start_us_) / 1e6;
+  if (elapsed_s <= 0) {
+    return;
+  }
+
+  uint32_t dropped = 0;
+  if (replayer_) {
+    dropped = replayer_->get_dropped() - dropped_reported_;
+    dropped_reported_ = replayer_->get_dropped();
+  } else {
+    // The driver counts frames lost to a full receive queue (missed) and
+    // to a hardware receive FIFO overrun separately
+    twai_status_info_t status;
+    if (twai_get_status_info(&status) == ESP_OK) {
+      dropped = (status.rx_missed_count - rx_missed_reported_) +
+                (status.rx_overrun_count - rx_overrun_reported_);
+      rx_missed_reported_ = status.rx_missed_count;
+      rx_overrun_reported_ = status.rx_overrun_count;
+    }
+  }
+
+  debugI("N2K rx: %.0f frames/s, bus load %.1f%%, parse %.1f us/frame, "
+         "%u filtered, %u dropped",
+         frames_ / elapsed_s,
+         100.0 * frame_bits_ / (kN2kBitRate * elapsed_s),
+         frames_ ? static_cast<float>(parse_us_) / frames_ : 0.0f, filtered_,
+         dropped);
+  for (const auto& entry : pgn_stats_.entries()) {
+    if (entry.pgn == N2kPgnStats::kEmpty) {
+      continue;
+    }
+    debugI("  PGN %6u: %5u msgs, %.1f us avg, %u us max", entry.pgn,
+           entry.count, static_cast<float>(entry.total_us) / entry.count,
+           entry.max_us);
+  }
+  if (replayer_ && replayer_->finished()) {
+    debugI("N2K replay finished: %u frames replayed, %u dropped",
+           replayer_->get_replayed(), replayer_->get_dropped());
+  }
+
+  pgn_stats_.clear();
+  frames_ = 0;
+  filtered_ = 0;
+  frame_bits_ = 0;
+  parse_us_ = 0;
+  report_start_us_ = now;
+}
+
+void HalmetNMEA2000::dump_capture(Print& out) {
+  if (!capture_) {
+    return;
+  }
+  for (size_t i = 0; i < capture_->size(); i++) {
+    dump_frame(out, capture_->at(i));
+  }
+}
+
+void HalmetNMEA2000::dump_frame(Print& out, const N2kCanFrame& frame) {
+  out.printf("(%llu.%06llu) can0 %08X#", frame.timestamp_us / 1000000,
+             frame.timestamp_us % 1000000, frame.id);
+  for (int j = 0; j < frame.len; j++) {
+    out.printf("%02X", frame.data[j]);
+  }
+  out.println();
+}
+
+}  // namespace halmet
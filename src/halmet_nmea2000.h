@@ -0,0 +1,113 @@
+#ifndef HALMET_SRC_HALMET_NMEA2000_H_
+#define HALMET_SRC_HALMET_NMEA2000_H_
+
+#include <FS.h>
+#include <NMEA2000_esp32.h>
+
+#include <atomic>
+#include <memory>
+
+#include "n2k_frame_log.h"
+#include "n2k_pgn_filter.h"
+
+namespace halmet {
+
+/**
+ * @brief NMEA 2000 device with frame capture, log replay and receive path
+ * instrumentation.
+ *
+ * All received frames pass through CANGetFrame(), so this is where frames
+ * are recorded in capture mode and where logged frames are injected in
+ * replay mode. Replayed frames take exactly the same path as live ones:
+ * ParseMessages(), fast-packet reassembly and the message handler.
+ *
+ * With a PGN filter enabled, frames of PGNs nobody is interested in are
+ * discarded right there, before the library's fast-packet reassembly and
+ * message parsing see them.
+ *
+ * The message handler is timed per PGN, and report() logs frames per
+ * second, receive-side bus load, per-PGN handler cost and filtered and
+ * dropped frames. On the live bus, dropped frames are the ones the TWAI
+ * driver lost because its receive queue or the controller's FIFO
+ * overflowed.
+ */
+class HalmetNMEA2000 : public tNMEA2000_esp32 {
+ public:
+  HalmetNMEA2000(gpio_num_t tx_pin, gpio_num_t rx_pin);
+
+  /// Record every received frame into a ring buffer of the given size. If
+  /// dump_output is set, recording stops once the buffer has filled and the
+  /// capture is written to dump_output in candump format from the event
+  /// loop, a few frames at a time.
+  void enable_capture(size_t capacity, Print* dump_output = nullptr);
+
+  /**
+   * @brief Replace the bus as frame source with a candump or Actisense RAW
+   * log file.
+   *
+   * @param path Log file on the SPIFFS filesystem
+   * @param speed Replay speed factor; 0 replays as fast as possible
+   * @return false if the file couldn't be opened
+   */
+  bool enable_replay(const char* path, float speed = 1.0);
+
+  /// Discard frames of PGNs that are not allowed by filter. Captured frames
+  /// are recorded before filtering.
+  void enable_pgn_filter(const N2kPgnFilter& filter);
+
+  /// Like SetMsgHandler(), but the handler is timed per PGN.
+  void set_timed_msg_handler(void (*handler)(const tN2kMsg&));
+
+  /// Drain and handle all pending frames. Use instead of ParseMessages().
+  void parse_messages();
+
+  /// Log the statistics collected since the previous report and reset them.
+  void report();
+
+  /// Write the captured frames to out in candump log format. Not safe while
+  /// frames are still being recorded.
+  void dump_capture(Print& out);
+
+  const N2kFrameRing* get_capture() const { return capture_.get(); }
+
+ protected:
+  bool CANGetFrame(unsigned long& id, unsigned char& len,
+                   unsigned char* buf) override;
+
+  // Next frame from the bus or the replay log, before filtering
+  bool read_frame(unsigned long& id, unsigned char& len, unsigned char* buf);
+
+  static void timed_handler(const tN2kMsg& msg);
+
+  // Event loop side of the capture dump
+  void poll_capture_dump();
+  static void dump_frame(Print& out, const N2kCanFrame& frame);
+
+  static HalmetNMEA2000* instance_;
+
+  void (*msg_handler_)(const tN2kMsg&) = nullptr;
+
+  std::unique_ptr<N2kFrameRing> capture_;
+  Print* capture_dump_output_ = nullptr;
+  // Set by the receive task when the capture has filled up; from then on,
+  // the event loop owns capture_
+  std::atomic<bool> capture_complete_{false};
+  size_t capture_dumped_ = 0;
+  std::unique_ptr<N2kFrameReplayer> replayer_;
+  std::unique_ptr<N2kPgnFilter> pgn_filter_;
+  fs::File replay_file_;
+
+  N2kPgnStats pgn_stats_;
+  uint32_t frames_ = 0;
+  uint32_t filtered_ = 0;
+  uint64_t frame_bits_ = 0;
+  uint64_t parse_us_ = 0;
+  uint32_t dropped_reported_ = 0;
+  uint32_t rx_missed_reported_ = 0;
+  uint32_t rx_overrun_reported_ = 0;
+  int64_t report_start_us_ = 0;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_HALMET_NMEA2000_H_
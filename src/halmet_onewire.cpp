@@ -0,0 +1,270 @@
+#include "halmet_onewire.h"
+
+#include <OneWireNg_CurrentPlatform.h>
+
+#include "sensesp_base_app.h"
+
+namespace halmet {
+
+const uint8_t kDS18B20FamilyCode = 0x28;
+
+/// OneWireIo on top of the OneWireNg driver.
+class OneWireNgIo : public OneWireIo {
+ public:
+  explicit OneWireNgIo(int pin)
+      : onewire_{new OneWireNg_CurrentPlatform(pin, false)} {}
+
+  bool reset() override { return onewire_->reset() == OneWireNg::EC_SUCCESS; }
+
+  void write_bytes(const uint8_t* data, size_t len) override {
+    onewire_->writeBytes(data, len);
+  }
+
+  void read_bytes(uint8_t* data, size_t len) override {
+    onewire_->readBytes(data, len);
+  }
+
+  bool search(OneWireRom* rom, bool first) override {
+    if (first) {
+      onewire_->searchReset();
+      search_done_ = false;
+    }
+    if (search_done_) {
+      return false;
+    }
+    OneWireNg::Id id;
+    OneWireNg::ErrorCode result = onewire_->search(id);
+    if (result != OneWireNg::EC_MORE && result != OneWireNg::EC_DONE) {
+      return false;
+    }
+    search_done_ = result == OneWireNg::EC_DONE;
+    memcpy(rom->bytes, id, sizeof(rom->bytes));
+    return true;
+  }
+
+ private:
+  OneWireNg* onewire_;
+  bool search_done_ = false;
+};
+
+OneWireTemperatureBus::OneWireTemperatureBus(int pin,
+                                             unsigned int read_interval,
+                                             String config_path,
+                                             unsigned int report_interval)
+    : sensesp::FileSystemSaveable(config_path),
+      pin_{pin},
+      report_interval_{report_interval},
+      io_{new OneWireNgIo(pin)},
+      bus_{io_, read_interval} {
+  load();
+}
+
+bool OneWireTemperatureBus::is_claimed(const OneWireRom& rom) const {
+  for (auto sensor : sensors_) {
+    if (sensor->get_address() == rom) {
+      return true;
+    }
+  }
+  for (auto sensor : pending_) {
+    if (sensor->has_address() && sensor->get_address() == rom) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void OneWireTemperatureBus::attach(DS18B20Temperature* sensor) {
+  // Sensors in bus_ keep the indices they have in sensors_
+  bus_.add_sensor(sensor->get_address(), sensor->get_resolution());
+  sensors_.push_back(sensor);
+}
+
+void OneWireTemperatureBus::assign_unclaimed(bool verify) {
+  for (const auto& rom : devices_) {
+    if (is_claimed(rom) || (verify && !bus_.probe(rom))) {
+      continue;
+    }
+    for (auto it = pending_.begin(); it != pending_.end(); ++it) {
+      if (!(*it)->has_address()) {
+        debugI("Assigning a new DS18B20 on pin %d", pin_);
+        (*it)->set_address(rom);
+        attach(*it);
+        pending_.erase(it);
+        break;
+      }
+    }
+  }
+}
+
+bool OneWireTemperatureBus::add_device(const OneWireRom& rom) {
+  if (rom.bytes[0] != kDS18B20FamilyCode) {
+    return false;
+  }
+  for (const auto& device : devices_) {
+    if (device == rom) {
+      return false;
+    }
+  }
+  char address[24];
+  FormatOneWireRom(rom, address, sizeof(address));
+  debugI("New DS18B20 on pin %d: %s", pin_, address);
+  devices_.push_back(rom);
+  return true;
+}
+
+void OneWireTemperatureBus::search() {
+  // Rebuild the cache from what is on the bus now, but keep the addresses
+  // of assigned sensors that are missing
+  std::vector<OneWireRom> previous = devices_;
+  devices_.clear();
+  OneWireRom rom;
+  for (bool first = true; io_->search(&rom, first); first = false) {
+    add_device(rom);
+  }
+  for (auto sensor : sensors_) {
+    add_device(sensor->get_address());
+  }
+  if (devices_ != previous) {
+    save();
+  }
+}
+
+void OneWireTemperatureBus::search_step() {
+  OneWireRom rom;
+  if (io_->search(&rom, search_first_)) {
+    search_first_ = false;
+    if (add_device(rom)) {
+      save();
+    }
+    return;
+  }
+  background_search_ = false;
+  search_first_ = true;
+  assign_unclaimed(false);
+  debugD("Background search on pin %d done, %u DS18B20 sensors known", pin_,
+         devices_.size());
+}
+
+void OneWireTemperatureBus::start() {
+  // Address the sensors directly instead of searching the bus
+  bool need_search = false;
+  for (auto it = pending_.begin(); it != pending_.end();) {
+    DS18B20Temperature* sensor = *it;
+    if (!sensor->has_address()) {
+      ++it;
+      continue;
+    }
+    // A sensor that doesn't answer keeps its address and is read whenever
+    // it comes back
+    if (!bus_.probe(sensor->get_address())) {
+      need_search = true;
+    }
+    attach(sensor);
+    it = pending_.erase(it);
+  }
+  // Sensors without an address get cached devices that answer
+  assign_unclaimed(true);
+  need_search = need_search || !pending_.empty();
+
+  if (need_search) {
+    search();
+    assign_unclaimed(false);
+  }
+  bus_.clear_stats();
+  debugI("%u DS18B20 sensors on pin %d (%s)", sensors_.size(), pin_,
+         need_search ? "bus searched" : "from cache");
+  if (!pending_.empty()) {
+    debugW("No DS18B20 left for %u temperature sensors on pin %d",
+           pending_.size(), pin_);
+  }
+
+  bus_.set_reading_callback([this](size_t index, float celsius) {
+    sensors_[index]->update(celsius);
+  });
+  sensesp::event_loop()->onRepeat(kTickInterval, [this]() {
+    if (background_search_) {
+      search_step();
+    }
+    bus_.tick(millis());
+  });
+  if (!need_search) {
+    sensesp::event_loop()->onDelay(kDeferredSearchDelay,
+                                   [this]() { background_search_ = true; });
+  }
+  if (report_interval_ > 0) {
+    sensesp::event_loop()->onRepeat(report_interval_,
+                                    [this]() { this->report(); });
+  }
+}
+
+bool OneWireTemperatureBus::to_json(JsonObject& root) {
+  JsonArray devices = root["devices"].to<JsonArray>();
+  for (const auto& rom : devices_) {
+    char address[24];
+    FormatOneWireRom(rom, address, sizeof(address));
+    devices.add(address);
+  }
+  return true;
+}
+
+bool OneWireTemperatureBus::from_json(const JsonObject& config) {
+  if (!config["devices"].is<JsonArray>()) {
+    return true;
+  }
+  devices_.clear();
+  for (JsonVariant device : config["devices"].as<JsonArray>()) {
+    OneWireRom rom;
+    if (device.is<const char*>() && ParseOneWireRom(device, &rom)) {
+      devices_.push_back(rom);
+    }
+  }
+  return true;
+}
+
+void OneWireTemperatureBus::report() {
+  const Ds18b20Bus::Stats& stats = bus_.get_stats();
+  debugI("1-Wire pin %d: %u devices, %u conversions, %u readings, "
+         "%u CRC errors, %u invalid, %u no presence, max latency %u ms",
+         pin_, devices_.size(), stats.conversions, stats.readings,
+         stats.crc_errors, stats.invalid, stats.no_presence,
+         stats.max_latency_ms);
+  bus_.clear_stats();
+}
+
+DS18B20Temperature::DS18B20Temperature(OneWireTemperatureBus* bus,
+                                       String config_path)
+    : sensesp::FloatSensor(config_path), bus_{bus} {
+  load();
+  bus_->add_sensor(this);
+}
+
+void DS18B20Temperature::set_address(const OneWireRom& address) {
+  address_ = address;
+  has_address_ = true;
+  save();
+}
+
+bool DS18B20Temperature::to_json(JsonObject& root) {
+  char address[24] = "";
+  if (has_address_) {
+    FormatOneWireRom(address_, address, sizeof(address));
+  }
+  root["address"] = address;
+  root["resolution"] = resolution_;
+  return true;
+}
+
+bool DS18B20Temperature::from_json(const JsonObject& config) {
+  if (config["address"].is<const char*>()) {
+    has_address_ = ParseOneWireRom(config["address"], &address_);
+  }
+  if (config["resolution"].is<int>()) {
+    int resolution = config["resolution"];
+    if (resolution >= 9 && resolution <= 12) {
+      resolution_ = resolution;
+    }
+  }
+  return true;
+}
+
+}  // namespace halmet
@@ -0,0 +1,131 @@
+#ifndef HALMET_SRC_HALMET_ONEWIRE_H_
+#define HALMET_SRC_HALMET_ONEWIRE_H_
+
+#include <vector>
+
+#include "ds18b20_bus.h"
+#include "sensesp/sensors/sensor.h"
+#include "sensesp/system/saveable.h"
+
+namespace halmet {
+
+class DS18B20Temperature;
+
+/**
+ * @brief All DS18B20 temperature sensors on one 1-Wire pin.
+ *
+ * Each bus runs independently, so sensors can be spread over several pins,
+ * each with its own OneWireTemperatureBus. Statistics are kept and reported
+ * per bus.
+ *
+ * Create the bus, then the sensors, then call start(). The acquisition
+ * itself is done by Ds18b20Bus, ticked from the event loop: one conversion
+ * for all sensors at once, and at most one short bus transaction per tick.
+ *
+ * The ROM codes found on the bus are cached in the bus configuration, and
+ * each sensor keeps its own address. At start(), every sensor is addressed
+ * directly, which takes a few milliseconds each. Sensors without an address
+ * are assigned the cached DS18B20s that no other sensor has claimed, and the
+ * assignment is saved. Only if a sensor doesn't answer or none is left for
+ * it is the whole bus searched before the first conversion.
+ *
+ * When the boot-time search is skipped, the bus is searched in the
+ * background after kDeferredSearchDelay instead, one device per tick, to
+ * pick up newly connected sensors.
+ */
+class OneWireTemperatureBus : public sensesp::FileSystemSaveable {
+ public:
+  OneWireTemperatureBus(int pin, unsigned int read_interval = 1000,
+                        String config_path = "",
+                        unsigned int report_interval = 60000);
+
+  void add_sensor(DS18B20Temperature* sensor) { pending_.push_back(sensor); }
+
+  void start();
+
+  int get_pin() const { return pin_; }
+  const Ds18b20Bus::Stats& get_stats() const { return bus_.get_stats(); }
+  /// DS18B20s known to be on the bus.
+  size_t get_device_count() const { return devices_.size(); }
+
+  virtual bool to_json(JsonObject& root) override;
+  virtual bool from_json(const JsonObject& config) override;
+
+ protected:
+  static const unsigned int kTickInterval = 10;             // ms
+  static const unsigned int kDeferredSearchDelay = 30000;  // ms
+
+  // Search the whole bus now, blocking
+  void search();
+  // Find one device per call in the background
+  void search_step();
+  // Add rom to the cache if it is a new DS18B20
+  bool add_device(const OneWireRom& rom);
+  bool is_claimed(const OneWireRom& rom) const;
+  // Assign unclaimed devices to sensors without an address, optionally
+  // only the ones that answer
+  void assign_unclaimed(bool verify);
+  void attach(DS18B20Temperature* sensor);
+
+  void report();
+
+  int pin_;
+  unsigned int report_interval_;
+  OneWireIo* io_;
+  Ds18b20Bus bus_;
+  // Sensor objects by their index in bus_
+  std::vector<DS18B20Temperature*> sensors_;
+  // Sensors not yet added to bus_
+  std::vector<DS18B20Temperature*> pending_;
+  // Cached ROM codes of the DS18B20s on the bus
+  std::vector<OneWireRom> devices_;
+
+  bool background_search_ = false;
+  bool search_first_ = true;
+};
+
+/**
+ * @brief Temperature of one DS18B20 on a OneWireTemperatureBus, in Kelvin.
+ *
+ * Uses the same "address" configuration key as
+ * sensesp::onewire::OneWireTemperature, so existing sensor assignments
+ * carry over.
+ */
+class DS18B20Temperature : public sensesp::FloatSensor {
+ public:
+  DS18B20Temperature(OneWireTemperatureBus* bus, String config_path = "");
+
+  bool has_address() const { return has_address_; }
+  const OneWireRom& get_address() const { return address_; }
+  void set_address(const OneWireRom& address);
+  uint8_t get_resolution() const { return resolution_; }
+
+  void update(float celsius) { this->emit(celsius + 273.15); }
+
+  virtual bool to_json(JsonObject& root) override;
+  virtual bool from_json(const JsonObject& config) override;
+
+ protected:
+  OneWireTemperatureBus* bus_;
+  bool has_address_ = false;
+  OneWireRom address_ = {};
+  uint8_t resolution_ = 12;
+};
+
+inline const String ConfigSchema(const DS18B20Temperature& obj) {
+  return R"###({
+    "type": "object",
+    "properties": {
+      "address": { "title": "Sensor address", "type": "string", "description": "ROM code of the sensor, e.g. 28:ff:12:34:56:78:9a:bc. Leave empty to pick an unassigned sensor." },
+      "resolution": { "title": "Resolution", "type": "integer", "description": "Bits of resolution, 9-12. Conversions take 94 ms at 9 bits and 750 ms at 12 bits." }
+    }
+  })###";
+}
+
+inline bool ConfigRequiresRestart(const DS18B20Temperature& obj) {
+  return true;
+}
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_HALMET_ONEWIRE_H_
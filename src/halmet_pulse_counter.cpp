@@ -0,0 +1,51 @@
+#include "halmet_pulse_counter.h"
+
+#include <algorithm>
+
+namespace halmet {
+
+// The hardware counter is 16 bits wide. When it reaches this limit, the
+// driver folds the count into its software accumulator and starts over.
+const int kPcntHighLimit = 32000;
+
+// With an 80 MHz APB clock the glitch filter can't be longer than this
+const unsigned int kMaxGlitchFilterNs = 12000;
+
+PcntUnit::PcntUnit(int pin, unsigned int glitch_filter_ns) {
+  pcnt_unit_config_t unit_config = {};
+  unit_config.low_limit = -kPcntHighLimit;
+  unit_config.high_limit = kPcntHighLimit;
+  unit_config.flags.accum_count = 1;
+  ESP_ERROR_CHECK(pcnt_new_unit(&unit_config, &unit_));
+
+  if (glitch_filter_ns > 0) {
+    pcnt_glitch_filter_config_t filter_config = {};
+    filter_config.max_glitch_ns =
+        std::min(glitch_filter_ns, kMaxGlitchFilterNs);
+    ESP_ERROR_CHECK(pcnt_unit_set_glitch_filter(unit_, &filter_config));
+  }
+
+  pcnt_chan_config_t channel_config = {};
+  channel_config.edge_gpio_num = pin;
+  channel_config.level_gpio_num = -1;
+  ESP_ERROR_CHECK(pcnt_new_channel(unit_, &channel_config, &channel_));
+  // Count rising edges only
+  ESP_ERROR_CHECK(pcnt_channel_set_edge_action(
+      channel_, PCNT_CHANNEL_EDGE_ACTION_INCREASE,
+      PCNT_CHANNEL_EDGE_ACTION_HOLD));
+
+  // Required for accum_count to catch the overflow
+  ESP_ERROR_CHECK(pcnt_unit_add_watch_point(unit_, kPcntHighLimit));
+
+  ESP_ERROR_CHECK(pcnt_unit_enable(unit_));
+  ESP_ERROR_CHECK(pcnt_unit_clear_count(unit_));
+  ESP_ERROR_CHECK(pcnt_unit_start(unit_));
+}
+
+int32_t PcntUnit::get_count() const {
+  int count = 0;
+  pcnt_unit_get_count(unit_, &count);
+  return count;
+}
+
+}  // namespace halmet
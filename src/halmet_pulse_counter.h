@@ -0,0 +1,30 @@
+#ifndef HALMET_SRC_HALMET_PULSE_COUNTER_H_
+#define HALMET_SRC_HALMET_PULSE_COUNTER_H_
+
+#include <driver/pulse_cnt.h>
+
+#include <cstdint>
+
+namespace halmet {
+
+/**
+ * @brief Rising edge counter in one ESP32 PCNT unit.
+ *
+ * Pulses shorter than the glitch filter length are ignored, and overflows of
+ * the 16-bit hardware counter are accumulated by the driver.
+ */
+class PcntUnit {
+ public:
+  PcntUnit(int pin, unsigned int glitch_filter_ns);
+
+  /// Accumulated number of pulses since startup.
+  int32_t get_count() const;
+
+ private:
+  pcnt_unit_handle_t unit_ = nullptr;
+  pcnt_channel_handle_t channel_ = nullptr;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_HALMET_PULSE_COUNTER_H_
@@ -0,0 +1,186 @@
+#include "halmet_sk_delta.h"
+
+#include <sys/time.h>
+
+#include "sensesp_app.h"
+
+namespace halmet {
+
+// System time before this counts as not set, in s since the Unix epoch
+const time_t kMinValidTime = 1700000000;
+
+SKDeltaSender* sk_delta_sender() {
+  static SKDeltaSender* sender = new SKDeltaSender();
+  return sender;
+}
+
+SKDeltaSender::SKDeltaSender(size_t capacity, unsigned int report_interval)
+    : writer_(capacity) {
+  frame_.reserve(capacity);
+  sensesp::event_loop()->onRepeat(kPollInterval, [this]() { this->poll(); });
+  if (report_interval > 0) {
+    sensesp::event_loop()->onRepeat(report_interval,
+                                    [this]() { this->report(); });
+  }
+}
+
+SKDeltaWriter::PathId SKDeltaSender::add_path(const String& path,
+                                              const String& units,
+                                              const String& display_name) {
+  meta_.push_back({path, units, display_name});
+  layout_ = Crc32(path.c_str(), path.length(), layout_);
+  return writer_.add_path(path.c_str());
+}
+
+uint64_t SKDeltaSender::now_ms() {
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  if (now.tv_sec < kMinValidTime) {
+    return 0;
+  }
+  return static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_usec / 1000;
+}
+
+void SKDeltaSender::enable_backlog(FlashLog* log) {
+  backlog_ = new SKBacklog(log, &writer_);
+  backlog_->begin(layout_);
+  if (backlog_->has_backlog()) {
+    debugI("SK backlog: values left to replay from before the restart");
+  }
+}
+
+void SKDeltaSender::set(SKDeltaWriter::PathId id, float value) {
+  if (!was_connected_ && backlog_ != nullptr) {
+    uint64_t timestamp_ms = now_ms();
+    if (timestamp_ms != 0) {
+      backlog_->record(id, value, timestamp_ms);
+      return;
+    }
+  }
+  if (writer_.get_value_count() == 0) {
+    writer_.begin();
+    writer_.begin_update(now_ms());
+  }
+  if (!writer_.add_value(id, value)) {
+    stats_.dropped++;
+  }
+}
+
+void SKDeltaSender::poll() {
+  auto ws_client = sensesp::SensESPApp::get()->get_ws_client();
+  bool connected = ws_client != nullptr && ws_client->is_connected();
+  if (connected && !was_connected_) {
+    send_meta();
+  }
+  was_connected_ = connected;
+
+  size_t values = writer_.get_value_count();
+  if (backlog_ != nullptr) {
+    unsigned long now = millis();
+    if (!connected) {
+      backlog_->flush_if_older(now_ms(), kMaxBlockAge);
+    } else if (values == 0 && now - last_replay_ >= kReplayInterval &&
+               backlog_->has_backlog()) {
+      last_replay_ = now;
+      replay();
+      return;
+    }
+  }
+
+  if (values == 0) {
+    return;
+  }
+  if (!connected) {
+    stats_.dropped += values;
+    writer_.begin();
+    return;
+  }
+
+  size_t len;
+  const char* delta = writer_.finish(&len);
+  // Copied into the existing allocation
+  frame_ = delta;
+  ws_client->sendTXT(frame_);
+  writer_.begin();
+
+  stats_.deltas++;
+  stats_.values += values;
+  if (len > stats_.max_bytes) {
+    stats_.max_bytes = len;
+  }
+}
+
+void SKDeltaSender::replay() {
+  // Runs between polls, with the live delta already sent
+  auto ws_client = sensesp::SensESPApp::get()->get_ws_client();
+  backlog_->replay_step([this, &ws_client](const char* delta, size_t len) {
+    frame_ = delta;
+    ws_client->sendTXT(frame_);
+    stats_.replayed_deltas++;
+    return ws_client->is_connected();
+  });
+}
+
+void SKDeltaSender::send_meta() {
+  // Once per connection, so built the plain way
+  JsonDocument doc;
+  JsonArray meta = doc["updates"].add<JsonObject>()["meta"].to<JsonArray>();
+  for (const auto& path_meta : meta_) {
+    if (path_meta.units.isEmpty() && path_meta.display_name.isEmpty()) {
+      continue;
+    }
+    JsonObject entry = meta.add<JsonObject>();
+    entry["path"] = path_meta.path;
+    JsonObject value = entry["value"].to<JsonObject>();
+    if (!path_meta.units.isEmpty()) {
+      value["units"] = path_meta.units;
+    }
+    if (!path_meta.display_name.isEmpty()) {
+      value["displayName"] = path_meta.display_name;
+    }
+  }
+  if (meta.size() == 0) {
+    return;
+  }
+  String message;
+  serializeJson(doc, message);
+  sensesp::SensESPApp::get()->get_ws_client()->sendTXT(message);
+}
+
+void SKDeltaSender::report() {
+  debugI("SK deltas: %u sent with %u values, %u values dropped, "
+         "largest %u bytes",
+         stats_.deltas, stats_.values, stats_.dropped, stats_.max_bytes);
+  if (backlog_ != nullptr) {
+    const SKBacklog::Stats& stats = backlog_->get_stats();
+    debugI("SK backlog: %u values recorded in %u blocks, %u blocks replayed "
+           "in %u deltas, %u skipped",
+           stats.recorded, stats.blocks, stats.replayed,
+           stats_.replayed_deltas, stats.skipped);
+    backlog_->clear_stats();
+  }
+  clear_stats();
+}
+
+SKTemplateOutputFloat::SKTemplateOutputFloat(const String& sk_path,
+                                             const String& config_path,
+                                             const String& units,
+                                             const String& display_name)
+    : sensesp::FileSystemSaveable(config_path), sk_path_{sk_path} {
+  load();
+  id_ = sk_delta_sender()->add_path(sk_path_, units, display_name);
+}
+
+bool SKTemplateOutputFloat::to_json(JsonObject& root) {
+  root["sk_path"] = sk_path_;
+  return true;
+}
+
+bool SKTemplateOutputFloat::from_json(const JsonObject& config) {
+  if (config["sk_path"].is<String>()) {
+    sk_path_ = config["sk_path"].as<String>();
+  }
+  return true;
+}
+
+}  // namespace halmet
@@ -0,0 +1,134 @@
+#ifndef HALMET_SRC_HALMET_SK_DELTA_H_
+#define HALMET_SRC_HALMET_SK_DELTA_H_
+
+#include <vector>
+
+#include "sensesp/system/saveable.h"
+#include "sensesp/system/valueconsumer.h"
+#include "sk_backlog.h"
+#include "sk_delta_writer.h"
+
+namespace halmet {
+
+/**
+ * @brief Sends Signal K deltas built by an SKDeltaWriter.
+ *
+ * Values are written into the pending delta as they arrive, and the delta
+ * is sent over the Signal K websocket connection at the next poll. Values
+ * set in the same event loop callback, such as a flush of the
+ * SKDeltaBatcher, therefore go out as one message. Path metadata is sent
+ * once whenever the connection is (re)established.
+ *
+ * Timestamps are added once the system clock has been set. While there is
+ * no connection, values are dropped, or recorded in the backlog if one has
+ * been enabled and the clock is set. Once the connection is back, the
+ * backlog is replayed one block per kReplayInterval, next to the live
+ * values.
+ */
+class SKDeltaSender {
+ public:
+  struct Stats {
+    uint32_t deltas;
+    uint32_t values;
+    // Dropped because the delta was full or there was no connection
+    uint32_t dropped;
+    uint32_t max_bytes;
+    uint32_t replayed_deltas;
+  };
+
+  SKDeltaSender(size_t capacity = 2048, unsigned int report_interval = 60000);
+
+  /// Register an output path. Call at startup only.
+  SKDeltaWriter::PathId add_path(const String& path, const String& units,
+                                 const String& display_name);
+
+  void set(SKDeltaWriter::PathId id, float value);
+
+  /**
+   * @brief Record values in log while there is no connection.
+   *
+   * Call at the end of setup, once all outputs have been created.
+   */
+  void enable_backlog(FlashLog* log);
+
+  const Stats& get_stats() const { return stats_; }
+  void clear_stats() { stats_ = {}; }
+
+ protected:
+  static const unsigned int kPollInterval = 10;      // ms
+  static const unsigned int kReplayInterval = 100;   // ms
+  static const unsigned int kMaxBlockAge = 60000;    // ms
+
+  struct PathMeta {
+    String path;
+    String units;
+    String display_name;
+  };
+
+  // Wall clock time in ms, or 0 if the clock isn't set
+  static uint64_t now_ms();
+
+  void poll();
+  void replay();
+  void send_meta();
+  void report();
+
+  SKDeltaWriter writer_;
+  // Keeps its allocation between messages
+  String frame_;
+  std::vector<PathMeta> meta_;
+  bool was_connected_ = false;
+
+  // Hash of the registered paths, identifying the backlog layout
+  uint32_t layout_ = 0;
+  SKBacklog* backlog_ = nullptr;
+  unsigned long last_replay_ = 0;
+
+  Stats stats_ = {};
+};
+
+/// Shared sender for all template outputs.
+SKDeltaSender* sk_delta_sender();
+
+/**
+ * @brief Signal K output whose delta fragment is prepared at startup.
+ *
+ * A drop-in for SKOutputFloat with the same "sk_path" configuration key.
+ * The path is fixed when the output is created, so a path change takes a
+ * restart.
+ */
+class SKTemplateOutputFloat : public sensesp::ValueConsumer<float>,
+                              public sensesp::FileSystemSaveable {
+ public:
+  SKTemplateOutputFloat(const String& sk_path, const String& config_path = "",
+                        const String& units = "",
+                        const String& display_name = "");
+
+  virtual void set(const float& value) override {
+    sk_delta_sender()->set(id_, value);
+  }
+
+  virtual bool to_json(JsonObject& root) override;
+  virtual bool from_json(const JsonObject& config) override;
+
+ protected:
+  String sk_path_;
+  SKDeltaWriter::PathId id_;
+};
+
+inline const String ConfigSchema(const SKTemplateOutputFloat& obj) {
+  return R"###({
+    "type": "object",
+    "properties": {
+      "sk_path": { "title": "Signal K Path", "type": "string" }
+    }
+  })###";
+}
+
+inline bool ConfigRequiresRestart(const SKTemplateOutputFloat& obj) {
+  return true;
+}
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_HALMET_SK_DELTA_H_
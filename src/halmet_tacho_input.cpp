@@ -0,0 +1,102 @@
+#include "halmet_tacho_input.h"
+
+#include <esp_timer.h>
+
+namespace halmet {
+
+TachoInput::TachoInput(int pin, unsigned int update_interval,
+                       float crossover_frequency, String config_path)
+    : sensesp::FloatSensor(config_path),
+      pin_{pin},
+      update_interval_{update_interval},
+      crossover_frequency_{crossover_frequency},
+      crossover_{crossover_frequency} {
+  load();
+  crossover_.set_crossover(crossover_frequency_);
+
+  pcnt_ = new PcntUnit(pin_, 1000);
+  attach_edge_interrupt();
+
+  sensesp::event_loop()->onRepeat(update_interval_,
+                                  [this]() { this->update(); });
+}
+
+void IRAM_ATTR TachoInput::edge_isr(void* arg) {
+  auto tacho = static_cast<TachoInput*>(arg);
+  uint32_t now = esp_timer_get_time();
+  portENTER_CRITICAL_ISR(&tacho->edges_mux_);
+  tacho->edges_.add_edge(now);
+  portEXIT_CRITICAL_ISR(&tacho->edges_mux_);
+}
+
+void TachoInput::attach_edge_interrupt() {
+  portENTER_CRITICAL(&edges_mux_);
+  edges_.reset();
+  portEXIT_CRITICAL(&edges_mux_);
+  attachInterruptArg(digitalPinToInterrupt(pin_), edge_isr, this, RISING);
+  edge_interrupt_attached_ = true;
+}
+
+void TachoInput::detach_edge_interrupt() {
+  detachInterrupt(digitalPinToInterrupt(pin_));
+  edge_interrupt_attached_ = false;
+}
+
+void TachoInput::update() {
+  uint64_t now = esp_timer_get_time();
+  // The PCNT unit counts all the time, so the count rate is valid as soon
+  // as the mode switches over
+  float count_frequency = count_rate_.update(pcnt_->get_count(), now);
+
+  float frequency;
+  if (is_period_mode()) {
+    portENTER_CRITICAL(&edges_mux_);
+    EdgePeriodEstimator<kEdgeHistory> edges = edges_;
+    portEXIT_CRITICAL(&edges_mux_);
+    frequency = edges.get_frequency(now, edge_timeout_ * 1000,
+                                    period_intervals_);
+  } else {
+    frequency = count_frequency;
+  }
+
+  crossover_.update(frequency);
+  if (is_period_mode() && !edge_interrupt_attached_) {
+    attach_edge_interrupt();
+  } else if (!is_period_mode() && edge_interrupt_attached_) {
+    detach_edge_interrupt();
+  }
+
+  this->emit(frequency);
+}
+
+bool TachoInput::to_json(JsonObject& root) {
+  root["update_interval"] = update_interval_;
+  root["crossover_frequency"] = crossover_frequency_;
+  root["period_intervals"] = period_intervals_;
+  root["edge_timeout"] = edge_timeout_;
+  return true;
+}
+
+bool TachoInput::from_json(const JsonObject& config) {
+  if (!config["update_interval"].is<unsigned int>() ||
+      !config["crossover_frequency"].is<float>()) {
+    return false;
+  }
+  update_interval_ = config["update_interval"];
+  if (update_interval_ < kMinUpdateInterval) {
+    update_interval_ = kMinUpdateInterval;
+  }
+  crossover_frequency_ = config["crossover_frequency"];
+  if (config["period_intervals"].is<unsigned int>()) {
+    period_intervals_ = config["period_intervals"];
+    if (period_intervals_ < 1 || period_intervals_ >= kEdgeHistory) {
+      period_intervals_ = 4;
+    }
+  }
+  if (config["edge_timeout"].is<unsigned int>()) {
+    edge_timeout_ = config["edge_timeout"];
+  }
+  return true;
+}
+
+}  // namespace halmet
@@ -0,0 +1,118 @@
+#ifndef HALMET_SRC_HALMET_TACHO_INPUT_H_
+#define HALMET_SRC_HALMET_TACHO_INPUT_H_
+
+#include "halmet_pulse_counter.h"
+#include "sensesp/sensors/sensor.h"
+#include "sensesp/transforms/linear.h"
+#include "tacho_estimator.h"
+
+namespace halmet {
+
+/**
+ * @brief Low-latency tacho frequency input.
+ *
+ * Emits the input frequency in Hz every update_interval milliseconds. Below
+ * the crossover frequency the frequency is measured from the period of the
+ * last few edges, timestamped in an edge interrupt. This resolves idle RPM
+ * precisely and reacts within one or two pulses. Above the crossover the
+ * edge interrupt is detached, and the pulses counted by the PCNT peripheral
+ * are averaged over a short sliding window instead, so high frequencies
+ * cost no CPU per pulse.
+ */
+class TachoInput : public sensesp::FloatSensor {
+ public:
+  TachoInput(int pin, unsigned int update_interval = 50,
+             float crossover_frequency = 300, String config_path = "");
+
+  bool is_period_mode() const {
+    return crossover_.get_mode() == TachoCrossover::Mode::kPeriod;
+  }
+
+  virtual bool to_json(JsonObject& root) override;
+  virtual bool from_json(const JsonObject& config) override;
+
+ protected:
+  static const size_t kEdgeHistory = 16;
+  static const size_t kCountHistory = 5;
+  // Shorter update intervals would keep the event loop busy
+  static const unsigned int kMinUpdateInterval = 10;  // ms
+
+  static void IRAM_ATTR edge_isr(void* arg);
+
+  void update();
+  void attach_edge_interrupt();
+  void detach_edge_interrupt();
+
+  int pin_;
+  unsigned int update_interval_;
+  float crossover_frequency_;
+  // Number of edge intervals averaged in period mode
+  unsigned int period_intervals_ = 4;
+  // Period mode reports zero if no edge was seen for this long
+  unsigned int edge_timeout_ = 1000;  // ms
+
+  PcntUnit* pcnt_;
+  SlidingPulseRate<kCountHistory> count_rate_;
+
+  portMUX_TYPE edges_mux_ = portMUX_INITIALIZER_UNLOCKED;
+  EdgePeriodEstimator<kEdgeHistory> edges_;
+  bool edge_interrupt_attached_ = false;
+
+  TachoCrossover crossover_;
+};
+
+inline const String ConfigSchema(const TachoInput& obj) {
+  return R"###({
+    "type": "object",
+    "properties": {
+      "update_interval": { "title": "Update interval", "type": "integer", "description": "Milliseconds between frequency updates (at least 10)" },
+      "crossover_frequency": { "title": "Crossover frequency", "type": "number", "description": "Input frequency (Hz) above which pulses are counted instead of timed" },
+      "period_intervals": { "title": "Period averaging", "type": "integer", "description": "Number of pulse intervals averaged below the crossover frequency (1-15)" },
+      "edge_timeout": { "title": "Stop timeout", "type": "integer", "description": "Report zero if no pulse has been seen for this many milliseconds" }
+    }
+  })###";
+}
+
+inline bool ConfigRequiresRestart(const TachoInput& obj) { return true; }
+
+/**
+ * @brief Scales the tacho input frequency to revolutions per second.
+ *
+ * A Linear transform that also accepts the configuration saved by the
+ * Frequency transform that used to sit on the same config path: a lone
+ * "multiplier" is taken over with an offset of 0. The next save writes both
+ * keys.
+ */
+class TachoMultiplier : public sensesp::Linear {
+ public:
+  TachoMultiplier(float multiplier, float offset, String config_path = "")
+      : sensesp::Linear(multiplier, offset, config_path) {
+    load();
+  }
+
+  virtual bool from_json(const JsonObject& config) override {
+    if (sensesp::Linear::from_json(config)) {
+      return true;
+    }
+    if (!config["multiplier"].is<float>()) {
+      return false;
+    }
+    multiplier_ = config["multiplier"];
+    offset_ = 0;
+    return true;
+  }
+};
+
+inline const String ConfigSchema(const TachoMultiplier& obj) {
+  return R"###({
+    "type": "object",
+    "properties": {
+      "multiplier": { "title": "Multiplier", "type": "number", "description": "Revolutions per input pulse" },
+      "offset": { "title": "Offset", "type": "number", "description": "Added to the scaled frequency, in Hz" }
+    }
+  })###";
+}
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_HALMET_TACHO_INPUT_H_
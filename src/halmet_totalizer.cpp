@@ -0,0 +1,75 @@
+#include "halmet_totalizer.h"
+
+#include "sensesp_base_app.h"
+
+namespace halmet {
+
+EngineTotalizer::EngineTotalizer(FlashLog* log, unsigned int persist_interval,
+                                 String config_path)
+    : sensesp::FileSystemSaveable(config_path),
+      totals_{log},
+      persist_interval_{persist_interval} {
+  // No load(): the flash log, not the configuration file, holds the totals
+  if (totals_.restore()) {
+    debugI("Restored totals: %.1f h, %.1f l", totals_.get_run_time() / 3600,
+           totals_.get_fuel_used() * 1000);
+  }
+  fuel_used_.set(totals_.get_fuel_used());
+  run_time_.set(totals_.get_run_time());
+
+  sensesp::event_loop()->onRepeat(kIntegrationInterval,
+                                  [this]() { this->integrate(); });
+  sensesp::event_loop()->onRepeat(persist_interval_,
+                                  [this]() { this->persist(); });
+}
+
+void EngineTotalizer::integrate() {
+  totals_.integrate();
+  publish();
+}
+
+void EngineTotalizer::persist() {
+  if (!totals_.persist()) {
+    debugE("Unable to save engine totals");
+  }
+}
+
+void EngineTotalizer::publish() {
+  float fuel_used = totals_.get_fuel_used();
+  if (fuel_used != fuel_used_.get()) {
+    fuel_used_.set(fuel_used);
+  }
+  float run_time = totals_.get_run_time();
+  if (run_time != run_time_.get()) {
+    run_time_.set(run_time);
+  }
+}
+
+bool EngineTotalizer::to_json(JsonObject& root) {
+  reported_hours_ = totals_.get_run_time() / 3600;
+  reported_litres_ = totals_.get_fuel_used() * 1000;
+  root["engine_hours"] = reported_hours_;
+  root["fuel_used"] = reported_litres_;
+  return true;
+}
+
+bool EngineTotalizer::from_json(const JsonObject& config) {
+  // Only values the user actually changed replace the running totals
+  if (config["engine_hours"].is<float>()) {
+    float hours = config["engine_hours"];
+    if (hours != reported_hours_) {
+      totals_.set_run_time(hours * 3600.0);
+    }
+  }
+  if (config["fuel_used"].is<float>()) {
+    float litres = config["fuel_used"];
+    if (litres != reported_litres_) {
+      totals_.set_fuel_used(litres / 1000.0);
+    }
+  }
+  publish();
+  persist();
+  return true;
+}
+
+}  // namespace halmet
@@ -0,0 +1,75 @@
+#ifndef HALMET_SRC_HALMET_TOTALIZER_H_
+#define HALMET_SRC_HALMET_TOTALIZER_H_
+
+#include "engine_totals.h"
+#include "flash_log.h"
+#include "sensesp/system/lambda_consumer.h"
+#include "sensesp/system/observablevalue.h"
+#include "sensesp/system/saveable.h"
+
+namespace halmet {
+
+/**
+ * @brief Accumulates total fuel used and engine run time.
+ *
+ * Connects an EngineTotals to the inputs, outputs and event loop.
+ *
+ * The totals are appended to a FlashLog every persist_interval milliseconds
+ * while they change, and the most recent record is restored at startup. A
+ * power cut thus loses at most persist_interval worth of running time. The
+ * log spreads the writes over its whole partition, so frequent records
+ * don't wear out any single flash sector.
+ *
+ * The totals can be set from the configuration UI, e.g. to match the
+ * engine's hour meter.
+ */
+class EngineTotalizer : public sensesp::FileSystemSaveable {
+ public:
+  EngineTotalizer(FlashLog* log, unsigned int persist_interval = 10000,
+                  String config_path = "");
+
+  sensesp::LambdaConsumer<float> fuel_rate_{
+      [this](float value) { totals_.set_fuel_rate(value); }};
+  sensesp::LambdaConsumer<float> revolutions_{
+      [this](float value) { totals_.set_revolutions(value); }};
+
+  sensesp::ObservableValue<float> fuel_used_;  // m3
+  sensesp::ObservableValue<float> run_time_;   // s
+
+  virtual bool to_json(JsonObject& root) override;
+  virtual bool from_json(const JsonObject& config) override;
+
+ protected:
+  static const unsigned int kIntegrationInterval = 1000;  // ms
+
+  void integrate();
+  void persist();
+  // Emit the totals that changed
+  void publish();
+
+  EngineTotals totals_;
+  unsigned int persist_interval_;
+
+  // Totals last shown in the configuration UI, to tell user edits apart
+  // from stale form values
+  float reported_hours_ = -1;
+  float reported_litres_ = -1;
+};
+
+inline const String ConfigSchema(const EngineTotalizer& obj) {
+  return R"###({
+    "type": "object",
+    "properties": {
+      "engine_hours": { "title": "Engine hours", "type": "number", "description": "Total engine run time, in hours. Change to set the total." },
+      "fuel_used": { "title": "Fuel used", "type": "number", "description": "Total fuel used, in litres. Change to set the total." }
+    }
+  })###";
+}
+
+inline bool ConfigRequiresRestart(const EngineTotalizer& obj) {
+  return false;
+}
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_HALMET_TOTALIZER_H_
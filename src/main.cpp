@@ -19,7 +19,6 @@
 #include "sensesp/sensors/analog_input.h"
 #include "sensesp/sensors/digital_input.h"
 #include "sensesp/sensors/sensor.h"
-#include "sensesp/signalk/signalk_output.h"
 #include "sensesp/system/lambda_consumer.h"
 #include "sensesp/system/system_status_led.h"
 #include "sensesp/transforms/lambda_transform.h"
@@ -28,26 +27,37 @@
 #include "sensesp/ui/config_item.h"
 // #include "sensesp_nmea0183/nmea0183.h"
 // #include "sensesp_nmea0183/wiring.h"
-#include "sensesp_onewire/onewire_temperature.h"
 
 #include "sensesp_app_builder.h"
 #define BUILDER_CLASS SensESPAppBuilder
 
 
 #include "Arduino.h"
-#include "NMEA2000FuelFlowRateHandler.h"
 #include "halmet_analog.h"
+#include "halmet_cranking.h"
 #include "halmet_const.h"
 #include "halmet_digital.h"
 #include "halmet_display.h"
+#include "halmet_n2k_task.h"
+#include "halmet_nmea2000.h"
+#include "n2k_pgn_dispatcher.h"
+#include "n2k_pgn_filter.h"
+#include "n2k_signalk_bridge.h"
+#include "n2k_transmit_scheduler.h"
+#include "n2k_tx_queue.h"
+#include "halmet_flash_partition.h"
+#include "halmet_onewire.h"
+#include "halmet_sk_delta.h"
 #include "halmet_serial.h"
+#include "halmet_totalizer.h"
+#include "rate_limiter.h"
+#include "sk_delta_batcher.h"
 #include "sensesp/net/http_server.h"
 #include "sensesp/net/networking.h"
 
 using namespace sensesp;
 using namespace halmet;
 // using namespace sensesp::nmea0183;
-using namespace sensesp::onewire;
 
 ///////////// GPS serial config /////////////
 constexpr int kGNSSBitRate = 9600;
@@ -56,20 +66,54 @@ constexpr int kGNSSRxPin = 13;
 constexpr int kGNSSTxPin = 15;
 
 ///////////// DS18S20  config /////////////
-const int kDQPin = 4;
+// Every pin is a separate 1-Wire bus with its own conversion cycle, so
+// sensors on one bus don't wait for the others, and a long or noisy cable
+// run only disturbs its own bus.
+const int kOneWirePins[] = {4};
 uint onewire_read_delay = 1000;
 
+struct OneWireTemperatureConfig {
+  // Index into kOneWirePins
+  size_t bus;
+  // Config path prefix and the last part of the Signal K path
+  const char* name;
+  const char* title;
+};
+
+const OneWireTemperatureConfig kOneWireTemperatures[] = {
+    {0, "exhaustTemperature1", "Exhaust Temperature 1"},
+    {0, "exhaustTemperature2", "Exhaust Temperature 2"},
+    {0, "engineTemperature1", "Engine Temperature 1"},
+    // Per-cylinder exhaust temperatures on a second bus, with GPIO 32 added
+    // to kOneWirePins:
+    // {1, "exhaustTemperatureCylinder1", "Cylinder 1 Exhaust Temperature"},
+    // {1, "exhaustTemperatureCylinder2", "Cylinder 2 Exhaust Temperature"},
+};
+
+///////////// Signal K config /////////////
+// Values that don't change by more than their deadband are repeated at
+// this interval only
+const unsigned int kDeadbandHeartbeat = 10000;  // ms
+const float kVoltageDeadband = 0.05;            // V
+const float kTemperatureDeadband = 0.2;         // K
+
 elapsedMillis n2k_time_since_rx = 0;
 elapsedMillis n2k_time_since_tx = 0;
 TwoWire* i2c;
 
 ///////////// NMEA2000 config /////////////
-tNMEA2000* nmea2000;
-NMEA2000FuelFlowRateHandler* nmea2000_handler = nullptr;
+HalmetNMEA2000* nmea2000;
+N2kReceiveTask* n2k_task = nullptr;
+N2kPgnDispatcher* n2k_dispatcher = nullptr;
+N2kTxQueue* n2k_tx_queue = nullptr;
+N2kTransmitScheduler* n2k_scheduler = nullptr;
+N2kSignalKBridge* n2k_signalk_bridge = nullptr;
 
 void NMEA2000FuelFlow();
 //void NMEAGPS();
 void OneWire();
+Deadband<float>* NewDeadband(float deadband, const char* config_path,
+                             const char* title);
 
 // Set the ADS1115 GAIN to adjust the analog input voltage range.
 // On HALMET, this refers to the voltage range of the ADS1115 input
@@ -84,6 +128,23 @@ void OneWire();
 
 const adsGain_t kADS1115Gain = GAIN_ONE;
 
+// If ENABLE_TANK_LOOKUP_TABLE is defined, the tank level curve is compiled
+// into a table indexed by ADC code, so each tank sender sample is converted
+// with a single lookup.
+#define ENABLE_TANK_LOOKUP_TABLE
+#ifdef ENABLE_TANK_LOOKUP_TABLE
+const bool kTankLookupTable = true;
+#else
+const bool kTankLookupTable = false;
+#endif
+
+// Each tank sender reading is a burst of fast conversions, to reject fuel
+// slosh without a slow moving average; the burst is set here only. The
+// voltage inputs use shorter bursts against alternator ripple; these are
+// defaults that can be changed in the web UI.
+const ADS1115Oversampling kTankOversampling = {16, 860};
+const ADS1115Oversampling kVoltageOversampling = {8, 475};
+
 /////////////////////////////////////////////////////////////////////
 // Test output pin configuration. If ENABLE_TEST_OUTPUT_PIN is defined,
 // GPIO 33 will output a pulse wave at 380 Hz with a 50% duty cycle.
@@ -97,6 +158,66 @@ const int kTestOutputPin = GPIO_NUM_33;
 const int kTestOutputFrequency = 380;
 #endif
 
+/////////////////////////////////////////////////////////////////////
+// NMEA 2000 receive path benchmarking. If ENABLE_N2K_REPLAY is defined, the
+// named candump or Actisense RAW log on SPIFFS is replayed through the
+// normal receive path instead of listening to the bus. If
+// ENABLE_N2K_CAPTURE is defined, the most recent received frames are kept
+// in RAM and dumped to the serial port in candump format once the buffer
+// has filled. Either way, receive statistics are logged periodically.
+// If ENABLE_N2K_PGN_FILTER is defined, frames of PGNs no decoder handles
+// are discarded before the library reassembles or parses them.
+// #define ENABLE_N2K_REPLAY "/n2k_replay.log"
+// #define ENABLE_N2K_CAPTURE
+#define ENABLE_N2K_PGN_FILTER
+const float kN2kReplaySpeed = 1.0;
+const size_t kN2kCaptureFrames = 2000;
+const unsigned int kN2kReportInterval = 10000;  // ms
+
+// If ENABLE_SK_BACKLOG is defined, values for the Signal K template outputs
+// are recorded in the "sflog" flash partition while the server can't be
+// reached, and sent with their original timestamps once it is back.
+#define ENABLE_SK_BACKLOG
+
+// NMEA 2000 values forwarded to Signal K. Each row maps a field of one
+// device instance to a Signal K path, with a minimum update interval in ms,
+// an optional scale and offset and an optional heartbeat interval in ms.
+const N2kSignalKMapping kN2kSignalKMappings[] = {
+    // Engine instance 0. Its run time and total fuel used come from the
+    // totalizer instead. The totalizer integrates the fuel rate and treats
+    // it as stale after a few PGN periods, so every fuel rate PGN is passed
+    // on: no minimum interval, and a heartbeat shorter than the 500 ms PGN
+    // period so that jitter doesn't suppress unchanged values either.
+    {N2kField::kFuelRate, 0, "propulsion.main.fuel.rate", "m3/s", 0, 1.0,
+     0.0, 400},
+    {N2kField::kOilPressure, 0, "propulsion.main.oilPressure", "Pa", 500},
+    {N2kField::kOilTemperature, 0, "propulsion.main.oilTemperature", "K",
+     1000},
+    {N2kField::kCoolantTemperature, 0, "propulsion.main.coolantTemperature",
+     "K", 1000},
+    {N2kField::kAlternatorVoltage, 0, "propulsion.main.alternatorVoltage", "V",
+     1000},
+    {N2kField::kEngineLoad, 0, "propulsion.main.engineLoad", "ratio", 1000},
+    {N2kField::kEngineTorque, 0, "propulsion.main.engineTorque", "ratio",
+     1000},
+    {N2kField::kTripAverageFuelRate, 0, "propulsion.main.fuel.averageRate",
+     "m3/s", 5000},
+    // Engine instance 1
+    {N2kField::kFuelRate, 1, "propulsion.secondary.fuel.rate", "m3/s", 500},
+    {N2kField::kOilPressure, 1, "propulsion.secondary.oilPressure", "Pa", 500},
+    {N2kField::kCoolantTemperature, 1,
+     "propulsion.secondary.coolantTemperature", "K", 1000},
+    {N2kField::kEngineHours, 1, "propulsion.secondary.runTime", "s", 10000},
+    {N2kField::kTripFuelUsed, 1, "propulsion.secondary.fuel.used", "m3", 5000},
+    // Further examples:
+    // {N2kField::kEngineSpeed, 1, "propulsion.secondary.revolutions", "Hz",
+    //  250},
+    // {N2kField::kFluidLevel, 1, "tanks.freshWater.0.currentLevel", "ratio",
+    //  2000},
+    // {N2kField::kBatteryVoltage, 0, "electrical.batteries.house.voltage",
+    //  "V", 1000},
+};
+
 /////////////////////////////////////////////////////////////////////
 // The setup function performs one-time application initialization.
 void setup() {
@@ -123,6 +244,13 @@ void setup() {
                     //->enable_ota("my_ota_password")
                     ->get_app();
 
+  // Signal K outputs are held back and sent together once per window, so
+  // one websocket frame carries all values that changed in the window
+  ConfigItem(sk_delta_batcher())
+      ->set_title("Signal K Batch Window")
+      ->set_description("Time over which Signal K values are collected into "
+                        "one delta");
+
   // Setup GPS serial port
   //NMEAGPS();
 
@@ -141,20 +269,89 @@ void setup() {
   bool ads_initialized = ads1115->begin(kADS1115Address, i2c);
   debugD("ADS1115 initialized: %d", ads_initialized);
 
-  // Read the voltage level of analog input A2
-  auto tank_a1_volume = ConnectTankSender(ads1115, 0, "Fuel", "fuel.main", 3000,true); //tank / PINK
-  auto a2_voltage = new ADS1115VoltageInput(ads1115, 1, "/Voltage A2"); //trim / BROWN/WHITE
-  auto a3_voltage = new ADS1115VoltageInput(ads1115, 2, "/Voltage A3"); //Oil pressure LT BLUE
-  auto a4_voltage = new ADS1115VoltageInput(ads1115, 3, "/Voltage A4"); //bat voltage RED
+  // All ADS1115 inputs share one non-blocking conversion scheduler
+  auto ads1115_scanner = new ADS1115Scanner(ads1115);
 
-
-tank_a1_volume->connect_to(new SKOutputFloat("tanks.fuel.0.currentVolume", "/sensors.tank_a1.volume", new SKMetadata("Fuel Volume", "m3")));
-a2_voltage->connect_to(new SKOutputFloat("electrical.sensors.analog.2.voltage", "/sensors.a2.voltage",new SKMetadata("Analog Voltage Trim", "V")));
-a3_voltage->connect_to(new SKOutputFloat("electrical.sensors.analog.3.voltage", "/sensors.a3.voltage",new SKMetadata("Analog Voltage Oil pressure", "V")));
-a4_voltage->connect_to(new SKOutputFloat("electrical.sensors.analog.4.voltage", "/sensors.a4.voltage",new SKMetadata("Analog Voltage Battery", "V")));
+  // Read the voltage level of analog input A2
+  auto tank_a1_volume = ConnectTankSender(ads1115_scanner, 0, "Fuel", "fuel.main", 3000,true, kTankLookupTable, kTankOversampling); //tank / PINK
+  auto a2_voltage = new ADS1115VoltageInput(ads1115_scanner, 1, "/Voltage A2", 1000, 1.0, kVoltageOversampling); //trim / BROWN/WHITE
+  auto a3_voltage = new ADS1115VoltageInput(ads1115_scanner, 2, "/Voltage A3", 1000, 1.0, kVoltageOversampling); //Oil pressure LT BLUE
+  auto a4_voltage = new ADS1115VoltageInput(ads1115_scanner, 3, "/Voltage A4", 1000, 1.0, kVoltageOversampling); //bat voltage RED
+  ConfigItem(a2_voltage)
+      ->set_title("Voltage A2")
+      ->set_description("Read interval, calibration and oversampling of A2");
+  ConfigItem(a3_voltage)
+      ->set_title("Voltage A3")
+      ->set_description("Read interval, calibration and oversampling of A3");
+  ConfigItem(a4_voltage)
+      ->set_title("Voltage A4")
+      ->set_description("Read interval, calibration and oversampling of A4");
+
+
+tank_a1_volume->connect_to(NewDeadband(0.002, "/sensors.tank_a1.deadband", "Tank A1 Deadband"))->connect_to(Batched(new SKTemplateOutputFloat("tanks.fuel.0.currentVolume", "/sensors.tank_a1.volume", "m3", "Fuel Volume")));
+a2_voltage->connect_to(NewDeadband(kVoltageDeadband, "/Voltage A2/Deadband", "Voltage A2 Deadband"))->connect_to(Batched(new SKTemplateOutputFloat("electrical.sensors.analog.2.voltage", "/sensors.a2.voltage", "V", "Analog Voltage Trim")));
+a3_voltage->connect_to(NewDeadband(kVoltageDeadband, "/Voltage A3/Deadband", "Voltage A3 Deadband"))->connect_to(Batched(new SKTemplateOutputFloat("electrical.sensors.analog.3.voltage", "/sensors.a3.voltage", "V", "Analog Voltage Oil pressure")));
+a4_voltage->connect_to(NewDeadband(kVoltageDeadband, "/Voltage A4/Deadband", "Voltage A4 Deadband"))->connect_to(Batched(new SKTemplateOutputFloat("electrical.sensors.analog.4.voltage", "/sensors.a4.voltage", "V", "Analog Voltage Battery")));
 
 auto tacho_d1_frequency = ConnectTachoSender(kDigitalInputPin1, "main");
 
+  // Start battery voltage dip, captured at the full ADS1115 rate while the
+  // engine is cranked
+  auto cranking = new CrankingCapture(a4_voltage, "/Battery start/Cranking");
+  ConfigItem(cranking)
+      ->set_title("Start Battery Cranking Capture")
+      ->set_description("Triggers and length of the cranking voltage capture");
+  tacho_d1_frequency->connect_to(&cranking->revolutions_);
+  cranking->minimum_voltage_.connect_to(Batched(new SKTemplateOutputFloat(
+      "electrical.batteries.start.cranking.minimumVoltage",
+      "/sensors.battery_start.cranking_minimum", "V",
+      "Cranking Minimum Voltage")));
+  cranking->recovery_time_.connect_to(Batched(new SKTemplateOutputFloat(
+      "electrical.batteries.start.cranking.recoveryTime",
+      "/sensors.battery_start.cranking_recovery", "s",
+      "Cranking Recovery Time")));
+  cranking->sag_integral_.connect_to(Batched(new SKTemplateOutputFloat(
+      "electrical.batteries.start.cranking.sagIntegral",
+      "/sensors.battery_start.cranking_sag", "V s", "Cranking Voltage Sag")));
+
+  // Total fuel used and engine run time, persisted in the "totals" flash
+  // partition. The engine counts as running while the tacho sees pulses.
+  // They go to Signal K only: PGN 127489 for engine instance 0, which
+  // carries the fuel rate integrated here, is sent by the engine itself.
+  auto totals_flash = new FlashPartition("totals");
+  FlashLog* totals_log = nullptr;
+  if (totals_flash->is_valid()) {
+    totals_log = new FlashLog(totals_flash);
+    totals_log->begin();
+  }
+  auto totalizer = new EngineTotalizer(totals_log, 10000, "/Engine main/Totals");
+  ConfigItem(totalizer)
+      ->set_title("Engine main Totals")
+      ->set_description("Total engine hours and fuel used");
+  tacho_d1_frequency->connect_to(&totalizer->revolutions_);
+  auto fuel_rate = n2k_signalk_bridge->get_output(N2kField::kFuelRate, 0);
+  if (fuel_rate != nullptr) {
+    fuel_rate->connect_to(&totalizer->fuel_rate_);
+  }
+  totalizer->run_time_.connect_to(Batched(new SKTemplateOutputFloat(
+      "propulsion.main.runTime", "/sensors.engine_main.run_time",
+      "s", "Engine Hours")));
+  totalizer->fuel_used_.connect_to(Batched(new SKTemplateOutputFloat(
+      "propulsion.main.fuel.used", "/sensors.engine_main.fuel_used",
+      "m3", "Fuel Used")));
+
+#ifdef ENABLE_SK_BACKLOG
+  // After all outputs, so the backlog knows their paths
+  auto backlog_flash = new FlashPartition("sflog");
+  if (backlog_flash->is_valid()) {
+    auto backlog_log = new FlashLog(backlog_flash);
+    backlog_log->begin();
+    sk_delta_sender()->enable_backlog(backlog_log);
+  } else {
+    debugW("No sflog partition, Signal K backlog disabled");
+  }
+#endif
+
   // To avoid garbage collecting all shared pointers created in setup(),
   // loop from here.
   while (true) {
@@ -163,39 +360,51 @@ auto tacho_d1_frequency = ConnectTachoSender(kDigitalInputPin1, "main");
 }
 
 static void NMEA2000StaticHandler(const tN2kMsg& N2kMsg) {
-  if (nmea2000_handler) {
-    switch (N2kMsg.PGN) {
-      case 127489L:
-        nmea2000_handler->EngineDynamicParameters(N2kMsg);
-        break;
-      case 127497L:
-        nmea2000_handler->TripFuelConsumption(N2kMsg);
-        break;
-      default:
-        break;
-    }
-  }
+  n2k_dispatcher->dispatch(N2kMsg);
 }
 
 void NMEA2000FuelFlow() {
   /////////////////////////////////////////////////////////////////////
   // Initialize NMEA 2000 functionality
-  nmea2000 = new tNMEA2000_esp32(kCANTxPin, kCANRxPin);
+  nmea2000 = new HalmetNMEA2000(kCANTxPin, kCANRxPin);
+
+#ifdef ENABLE_N2K_REPLAY
+  nmea2000->enable_replay(ENABLE_N2K_REPLAY, kN2kReplaySpeed);
+#endif
+#ifdef ENABLE_N2K_CAPTURE
+  nmea2000->enable_capture(kN2kCaptureFrames, &Serial);
+#endif
 
-  SKOutputFloat*  fuel_rate_sk_output = new SKOutputFloat("propulsion.engine.fuel.rate", "Fuel Rate", "m3/s");
+  // Decoders register the PGNs they handle with the dispatcher
+  n2k_dispatcher = new N2kPgnDispatcher();
 
-  nmea2000_handler = new NMEA2000FuelFlowRateHandler();
+  n2k_signalk_bridge = new N2kSignalKBridge(
+      kN2kSignalKMappings,
+      sizeof(kN2kSignalKMappings) / sizeof(kN2kSignalKMappings[0]));
+  n2k_signalk_bridge->register_handlers(n2k_dispatcher);
 
-  // Reserve enough buffer for sending all messages.
-  nmea2000->SetN2kCANSendFrameBufSize(250);
+  // Keep the driver's FIFO short: outgoing messages wait in the priority
+  // queue instead, where rapid PGNs can overtake slow ones and superseded
+  // messages are coalesced. 32 frames is about 16 ms of bus time.
+  nmea2000->SetN2kCANSendFrameBufSize(32);
   nmea2000->SetN2kCANReceiveFrameBufSize(250);
 
-  // Send messages to NMEA2000FuelFlowRateHandler
-  nmea2000->SetMsgHandler(NMEA2000StaticHandler);
+  // Send messages to the dispatcher
+  nmea2000->set_timed_msg_handler(NMEA2000StaticHandler);
+
+  // NMEA 2000 messages are received and decoded in a dedicated task on the
+  // other core. Decoded values reach the event loop through its queue.
+  n2k_task = new N2kReceiveTask(nmea2000, kN2kReportInterval);
+
+  // Periodic PGN senders register with the scheduler, which puts their
+  // messages into the transmit queue drained by the NMEA 2000 task
+  n2k_tx_queue = new N2kTxQueue();
+  n2k_task->set_tx_queue(n2k_tx_queue);
+  n2k_scheduler = new N2kTransmitScheduler(n2k_tx_queue);
+
+  // Create the Signal K outputs of the bridge
+  n2k_signalk_bridge->connect(n2k_task);
 
-nmea2000_handler->setSignalKSender([fuel_rate_sk_output](const std::string& path, float value) {
-        fuel_rate_sk_output->set(value);
-});
   // Setup the signalK output
 
   // Set Product information
@@ -216,12 +425,21 @@ nmea2000_handler->setSignalKSender([fuel_rate_sk_output](const std::string& path
 
   nmea2000->SetMode(tNMEA2000::N2km_NodeOnly,71);  // Default N2k node address
   nmea2000->EnableForward(false);
+
+  // All decoders are registered; build the PGN lookup tables
+  n2k_dispatcher->finalize();
+
+#ifdef ENABLE_N2K_PGN_FILTER
+  N2kPgnFilter pgn_filter;
+  pgn_filter.allow_all(n2k_dispatcher->get_pgns());
+  nmea2000->enable_pgn_filter(pgn_filter);
+#endif
+
   nmea2000->Open();
 
-  // No need to parse the messages at every single loop iteration; 1 ms will do
-  event_loop()->onRepeat(1, []() {
-    nmea2000->ParseMessages();
-  });
+  // From here on, the receive task owns nmea2000
+  n2k_task->start();
+  n2k_scheduler->start();
 }
 
 // void NMEAGPS() {
@@ -232,38 +450,60 @@ nmea2000_handler->setSignalKSender([fuel_rate_sk_output](const std::string& path
 // }
 
 void OneWire() {
-  // Setup dallas temperature sensors
-  DallasTemperatureSensors* dts = new DallasTemperatureSensors(kDQPin);
-  // Measure exhaust temperature 1
-  auto* exhaust_temp = new OneWireTemperature(dts, onewire_read_delay,
-                                              "/exhaustTemperature1/oneWire");
-  auto* exhaust_temp_calibration =
-      new Linear(1.0, 0.0, "/exhaustTemperature1/linear");
-  auto* exhaust_temp_sk_output = new SKOutputFloat(
-      "propulsion.main.exhaustTemperature1", "/exhaustTemperature1/skPath");
-
-  exhaust_temp->connect_to(exhaust_temp_calibration)
-      ->connect_to(exhaust_temp_sk_output);
-
-  // Measure exhaust temperature 2
-  auto* exhaust_temp2 = new OneWireTemperature(dts, onewire_read_delay,
-                                               "/exhaustTemperature2/oneWire");
-  auto* exhaust_temp_calibration2 =
-      new Linear(1.0, 0.0, "/exhaustTemperature2/linear");
-  auto* exhaust_temp_sk_output2 = new SKOutputFloat(
-      "propulsion.main.exhaustTemperature2", "/exhaustTemperature2/skPath");
-  exhaust_temp2->connect_to(exhaust_temp_calibration2)
-      ->connect_to(exhaust_temp_sk_output2);
-
-  // Measure engine temperature 3
-  auto* engine_temp = new OneWireTemperature(dts, onewire_read_delay,
-                                             "/engineTemperature1/oneWire");
-  auto* engine_temp_calibration =
-      new Linear(1.0, 0.0, "/engineTemperature1/linear");
-  auto* engine_temp_sk_output = new SKOutputFloat(
-      "propulsion.main.engineTemperature1", "/engineTemperature1/skPath");
-  engine_temp->connect_to(engine_temp_calibration)
-      ->connect_to(engine_temp_sk_output);
+  // All DS18B20 sensors on a bus convert at once; the buses are serviced
+  // from the event loop without waiting for the conversions. The ROM codes
+  // on each bus are cached, so the buses aren't searched at every boot.
+  constexpr size_t num_buses = sizeof(kOneWirePins) / sizeof(kOneWirePins[0]);
+  OneWireTemperatureBus* buses[num_buses];
+  for (size_t i = 0; i < num_buses; i++) {
+    char config_path[40];
+    snprintf(config_path, sizeof(config_path), "/oneWire/gpio%d",
+             kOneWirePins[i]);
+    buses[i] = new OneWireTemperatureBus(kOneWirePins[i], onewire_read_delay,
+                                         config_path);
+  }
+
+  for (const auto& config : kOneWireTemperatures) {
+    char config_path[80];
+    char title[80];
+    char sk_path[80];
+
+    snprintf(config_path, sizeof(config_path), "/%s/oneWire", config.name);
+    auto* temperature =
+        new DS18B20Temperature(buses[config.bus], config_path);
+    snprintf(title, sizeof(title), "%s Sensor", config.title);
+    ConfigItem(temperature)->set_title(title);
+
+    snprintf(config_path, sizeof(config_path), "/%s/linear", config.name);
+    auto* calibration = new Linear(1.0, 0.0, config_path);
+
+    snprintf(config_path, sizeof(config_path), "/%s/skPath", config.name);
+    snprintf(sk_path, sizeof(sk_path), "propulsion.main.%s", config.name);
+    auto* sk_output = new SKTemplateOutputFloat(sk_path, config_path, "K");
+
+    snprintf(config_path, sizeof(config_path), "/%s/deadband", config.name);
+    snprintf(title, sizeof(title), "%s Deadband", config.title);
+    auto* deadband = NewDeadband(kTemperatureDeadband, config_path, title);
+
+    temperature->connect_to(calibration)
+        ->connect_to(deadband)
+        ->connect_to(Batched(sk_output));
+  }
+
+  for (auto bus : buses) {
+    bus->start();
+  }
+}
+
+// Report-by-exception stage for a Signal K output
+Deadband<float>* NewDeadband(float deadband, const char* config_path,
+                             const char* title) {
+  auto* deadband_transform =
+      new Deadband<float>(deadband, kDeadbandHeartbeat, config_path);
+  ConfigItem(deadband_transform)
+      ->set_title(title)
+      ->set_description("Minimum change that is sent to Signal K");
+  return deadband_transform;
 }
 
 void loop() { event_loop()->tick(); }
@@ -0,0 +1,252 @@
+#include "n2k_frame_log.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace halmet {
+
+namespace {
+
+const int kMaxTokens = 14;
+
+// Parse up to eight whitespace separated hex bytes
+uint8_t ParseHexBytes(char** tokens, int num_tokens, uint8_t* data) {
+  uint8_t len = 0;
+  for (int i = 0; i < num_tokens && len < 8; i++) {
+    char* end;
+    unsigned long byte = strtoul(tokens[i], &end, 16);
+    if (end == tokens[i] || *end != '\0' || byte > 0xFF) {
+      break;
+    }
+    data[len++] = byte;
+  }
+  return len;
+}
+
+// Parse candump's compact "09F80100#FFFF7FFF" notation
+bool ParseCompactFrame(char* token, N2kCanFrame* frame) {
+  char* hash = strchr(token, '#');
+  *hash = '\0';
+  char* end;
+  frame->id = strtoul(token, &end, 16);
+  if (end == token || *end != '\0') {
+    return false;
+  }
+  char* hex = hash + 1;
+  size_t hex_len = strlen(hex);
+  if (hex_len % 2 != 0 || hex_len > 16) {
+    return false;
+  }
+  frame->len = hex_len / 2;
+  for (int i = 0; i < frame->len; i++) {
+    char byte_str[3] = {hex[2 * i], hex[2 * i + 1], '\0'};
+    frame->data[i] = strtoul(byte_str, nullptr, 16);
+  }
+  return true;
+}
+
+}  // namespace
+
+bool ParseN2kLogLine(const char* line, N2kCanFrame* frame) {
+  char buf[160];
+  strncpy(buf, line, sizeof(buf) - 1);
+  buf[sizeof(buf) - 1] = '\0';
+
+  char* tokens[kMaxTokens];
+  int num_tokens = 0;
+  char* save;
+  for (char* tok = strtok_r(buf, " \t\r\n", &save);
+       tok != nullptr && num_tokens < kMaxTokens;
+       tok = strtok_r(nullptr, " \t\r\n", &save)) {
+    tokens[num_tokens++] = tok;
+  }
+  if (num_tokens < 2) {
+    return false;
+  }
+
+  frame->timestamp_us = 0;
+  int first = 0;
+
+  // candump timestamp: "(1436509052.249713)"
+  if (tokens[0][0] == '(') {
+    frame->timestamp_us =
+        static_cast<uint64_t>(strtod(tokens[0] + 1, nullptr) * 1e6);
+    first = 1;
+  }
+
+  // Actisense/Yacht Devices RAW: "17:33:21.107 R 09F80100 FF FF ..."
+  if (first == 0 && strchr(tokens[0], ':') != nullptr) {
+    unsigned int hours, minutes;
+    double seconds;
+    if (sscanf(tokens[0], "%u:%u:%lf", &hours, &minutes, &seconds) != 3 ||
+        num_tokens < 3) {
+      return false;
+    }
+    frame->timestamp_us = static_cast<uint64_t>(
+        ((hours * 60 + minutes) * 60 + seconds) * 1e6);
+    char* end;
+    frame->id = strtoul(tokens[2], &end, 16);
+    if (end == tokens[2] || *end != '\0') {
+      return false;
+    }
+    frame->len = ParseHexBytes(tokens + 3, num_tokens - 3, frame->data);
+    return true;
+  }
+
+  // candump: the first remaining token is the interface name
+  if (num_tokens - first < 2) {
+    return false;
+  }
+  char* id_token = tokens[first + 1];
+  if (strchr(id_token, '#') != nullptr) {
+    return ParseCompactFrame(id_token, frame);
+  }
+
+  char* end;
+  frame->id = strtoul(id_token, &end, 16);
+  if (end == id_token || *end != '\0') {
+    return false;
+  }
+  int data_start = first + 2;
+  if (data_start < num_tokens && tokens[data_start][0] == '[') {
+    data_start++;
+  }
+  frame->len = ParseHexBytes(tokens + data_start, num_tokens - data_start,
+                             frame->data);
+  return true;
+}
+
+bool N2kFrameRing::push(const N2kCanFrame& frame, bool overwrite) {
+  if (frames_.empty()) {
+    return false;
+  }
+  if (full()) {
+    if (!overwrite) {
+      return false;
+    }
+    head_ = (head_ + 1) % frames_.size();
+    size_--;
+    overwritten_++;
+  }
+  frames_[(head_ + size_) % frames_.size()] = frame;
+  size_++;
+  return true;
+}
+
+bool N2kFrameRing::pop(N2kCanFrame* frame) {
+  if (size_ == 0) {
+    return false;
+  }
+  *frame = frames_[head_];
+  head_ = (head_ + 1) % frames_.size();
+  size_--;
+  return true;
+}
+
+N2kFrameReplayer::N2kFrameReplayer(LineSource source, float speed,
+                                   size_t rx_buffer_frames)
+    : source_{source}, speed_{speed}, rx_queue_{rx_buffer_frames} {}
+
+bool N2kFrameReplayer::load_pending() {
+  if (have_pending_) {
+    return true;
+  }
+  char line[160];
+  while (!source_done_) {
+    if (!source_(line, sizeof(line))) {
+      source_done_ = true;
+      break;
+    }
+    if (ParseN2kLogLine(line, &pending_)) {
+      have_pending_ = true;
+      advance_log_time(pending_.timestamp_us);
+      break;
+    }
+  }
+  return have_pending_;
+}
+
+void N2kFrameReplayer::advance_log_time(uint64_t timestamp_us) {
+  if (!log_started_) {
+    log_started_ = true;
+  } else if (timestamp_us >= last_log_us_) {
+    log_elapsed_us_ += timestamp_us - last_log_us_;
+  } else if (last_log_us_ - timestamp_us > kDay / 2) {
+    // A time of day log passing midnight
+    log_elapsed_us_ += timestamp_us + kDay - last_log_us_;
+  }
+  // Anything else going backwards is due right after the previous frame
+  last_log_us_ = timestamp_us;
+}
+
+bool N2kFrameReplayer::next(uint64_t now_us, N2kCanFrame* frame) {
+  if (!started_) {
+    if (!load_pending()) {
+      return false;
+    }
+    replay_start_us_ = now_us;
+    started_ = true;
+  }
+
+  if (speed_ <= 0) {
+    // Flat out: hand over frames one at a time, never drop
+    if (!load_pending()) {
+      return false;
+    }
+    *frame = pending_;
+    frame->timestamp_us = now_us;
+    have_pending_ = false;
+    replayed_++;
+    return true;
+  }
+
+  // Move every frame that has become due into the receive queue
+  while (load_pending()) {
+    uint64_t offset_us = static_cast<uint64_t>(log_elapsed_us_ / speed_);
+    uint64_t due_us = replay_start_us_ + offset_us;
+    if (due_us > now_us) {
+      break;
+    }
+    pending_.timestamp_us = due_us;
+    if (!rx_queue_.push(pending_)) {
+      dropped_++;
+    }
+    have_pending_ = false;
+  }
+
+  if (rx_queue_.pop(frame)) {
+    replayed_++;
+    return true;
+  }
+  return false;
+}
+
+void N2kPgnStats::record(uint32_t pgn, uint32_t handler_us) {
+  size_t capacity = entries_.size();
+  size_t index = (pgn * 2654435761u) % capacity;
+  for (size_t probe = 0; probe < capacity; probe++) {
+    Entry& entry = entries_[(index + probe) % capacity];
+    if (entry.pgn == kEmpty) {
+      entry.pgn = pgn;
+    }
+    if (entry.pgn == pgn) {
+      entry.count++;
+      entry.total_us += handler_us;
+      if (handler_us > entry.max_us) {
+        entry.max_us = handler_us;
+      }
+      return;
+    }
+  }
+  overflow_++;
+}
+
+void N2kPgnStats::clear() {
+  for (auto& entry : entries_) {
+    entry = {kEmpty, 0, 0, 0};
+  }
+  overflow_ = 0;
+}
+
+}  // namespace halmet
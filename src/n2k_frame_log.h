@@ -0,0 +1,171 @@
+#ifndef HALMET_SRC_N2K_FRAME_LOG_H_
+#define HALMET_SRC_N2K_FRAME_LOG_H_
+
+// Framework-independent building blocks for capturing and replaying raw
+// NMEA 2000 CAN frames. Nothing in here depends on Arduino or the NMEA 2000
+// library, so the same code runs on the device and in the native test
+// environment.
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace halmet {
+
+// NMEA 2000 bit rate, in bit/s
+const uint32_t kN2kBitRate = 250000;
+
+struct N2kCanFrame {
+  uint64_t timestamp_us;
+  uint32_t id;  // 29-bit extended CAN identifier
+  uint8_t len;
+  uint8_t data[8];
+};
+
+/// Extract the PGN from a 29-bit NMEA 2000 CAN identifier.
+inline uint32_t N2kCanIdToPgn(uint32_t id) {
+  uint32_t pgn = (id >> 8) & 0x3FFFF;
+  // PDU1 (PF < 240): the PS field is a destination address, not part of
+  // the PGN
+  if (((pgn >> 8) & 0xFF) < 240) {
+    pgn &= 0x3FF00;
+  }
+  return pgn;
+}
+
+/// Number of bits an extended data frame occupies on the bus, including
+/// worst-case bit stuffing and the interframe space.
+inline uint32_t N2kFrameBits(uint8_t len) {
+  return 67 + 8 * len + (54 + 8 * len - 1) / 4;
+}
+
+/**
+ * @brief Parse one line of a CAN log into a frame.
+ *
+ * Understands the candump formats ("(1436509052.249713) can0
+ * 09F80100#FFFF7FFF", and "can0 09F80100 [8] FF FF ..." with or without a
+ * leading timestamp) and the Actisense/Yacht Devices RAW ASCII format
+ * ("17:33:21.107 R 09F80100 FF FF 7F FF"). Lines without a timestamp get
+ * timestamp_us = 0.
+ *
+ * @return true if the line contained a frame
+ */
+bool ParseN2kLogLine(const char* line, N2kCanFrame* frame);
+
+/**
+ * @brief Fixed-capacity frame FIFO. The storage is allocated once in the
+ * constructor.
+ */
+class N2kFrameRing {
+ public:
+  explicit N2kFrameRing(size_t capacity) : frames_(capacity) {}
+
+  /// Append a frame. When the ring is full, the oldest frame is overwritten
+  /// if overwrite is set; otherwise the new frame is rejected.
+  bool push(const N2kCanFrame& frame, bool overwrite = false);
+  bool pop(N2kCanFrame* frame);
+  const N2kCanFrame& at(size_t index) const {
+    return frames_[(head_ + index) % frames_.size()];
+  }
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return frames_.size(); }
+  bool full() const { return size_ == frames_.size(); }
+  uint32_t get_overwritten() const { return overwritten_; }
+
+ private:
+  std::vector<N2kCanFrame> frames_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+  uint32_t overwritten_ = 0;
+};
+
+/**
+ * @brief Feeds logged frames back at their original pace, scaled by a speed
+ * factor.
+ *
+ * Frames that become due are held in a queue the size of the CAN receive
+ * buffer. If the consumer doesn't drain it fast enough, newly due frames
+ * are dropped exactly like a receive buffer overrun would drop them on the
+ * real bus. A speed of 0 replays as fast as the consumer can take frames
+ * and never drops.
+ *
+ * The pace follows the time between consecutive frames of the log. A time
+ * of day log that passes midnight continues across it; a frame whose
+ * timestamp otherwise goes backwards is due right after the previous one.
+ */
+class N2kFrameReplayer {
+ public:
+  /// Reads the next line of the log into buf. Returns false at end of log.
+  using LineSource = std::function<bool(char* buf, size_t size)>;
+
+  N2kFrameReplayer(LineSource source, float speed, size_t rx_buffer_frames);
+
+  /// Get the next frame that is due at now_us. The returned frame's
+  /// timestamp is rebased to the replay clock.
+  bool next(uint64_t now_us, N2kCanFrame* frame);
+
+  bool finished() const { return source_done_ && rx_queue_.size() == 0; }
+  uint32_t get_replayed() const { return replayed_; }
+  uint32_t get_dropped() const { return dropped_; }
+
+ private:
+  static const uint64_t kDay = 86400000000ULL;  // us
+
+  bool load_pending();
+  // Account for the log time between the previous frame and timestamp_us
+  void advance_log_time(uint64_t timestamp_us);
+
+  LineSource source_;
+  float speed_;
+  N2kFrameRing rx_queue_;
+
+  N2kCanFrame pending_;
+  bool have_pending_ = false;
+  bool source_done_ = false;
+  bool started_ = false;
+  bool log_started_ = false;
+  uint64_t last_log_us_ = 0;
+  // Log time from the first frame to pending_
+  uint64_t log_elapsed_us_ = 0;
+  uint64_t replay_start_us_ = 0;
+
+  uint32_t replayed_ = 0;
+  uint32_t dropped_ = 0;
+};
+
+/**
+ * @brief Per-PGN frame counts and handler cost.
+ *
+ * A small open-addressed table: recording is O(1) and allocation-free after
+ * construction. PGNs beyond the table capacity are lumped into an overflow
+ * counter.
+ */
+class N2kPgnStats {
+ public:
+  struct Entry {
+    uint32_t pgn;
+    uint32_t count;
+    uint64_t total_us;
+    uint32_t max_us;
+  };
+
+  explicit N2kPgnStats(size_t capacity = 64) : entries_(capacity) { clear(); }
+
+  void record(uint32_t pgn, uint32_t handler_us);
+  void clear();
+
+  const std::vector<Entry>& entries() const { return entries_; }
+  uint32_t get_overflow() const { return overflow_; }
+
+  static const uint32_t kEmpty = 0xFFFFFFFF;
+
+ private:
+  std::vector<Entry> entries_;
+  uint32_t overflow_ = 0;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_N2K_FRAME_LOG_H_
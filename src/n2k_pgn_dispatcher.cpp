@@ -0,0 +1,67 @@
+#include "n2k_pgn_dispatcher.h"
+
+#include <algorithm>
+
+namespace halmet {
+
+void N2kPgnDispatcher::add_handler(unsigned long pgn, Handler handler) {
+  registrations_.push_back({pgn, handler});
+  finalized_ = false;
+}
+
+void N2kPgnDispatcher::finalize() {
+  // Stable sort keeps handlers for the same PGN in registration order
+  std::stable_sort(registrations_.begin(), registrations_.end(),
+                   [](const Registration& a, const Registration& b) {
+                     return a.pgn < b.pgn;
+                   });
+
+  pgns_.clear();
+  first_handler_.clear();
+  handlers_.clear();
+
+  for (const auto& registration : registrations_) {
+    // Registrations are sorted, so a new PGN goes to the end of the table
+    if (pgns_.insert(registration.pgn)) {
+      first_handler_.push_back(handlers_.size());
+    }
+    handlers_.push_back(registration.handler);
+  }
+  first_handler_.push_back(handlers_.size());
+
+  pgns_.shrink_to_fit();
+  first_handler_.shrink_to_fit();
+  handlers_.shrink_to_fit();
+  finalized_ = true;
+}
+
+void N2kPgnDispatcher::dispatch(const tN2kMsg& msg) {
+  if (!finalized_) {
+    finalize();
+  }
+  int index = pgns_.find(msg.PGN);
+  if (index < 0) {
+    rejected_++;
+    return;
+  }
+  dispatched_++;
+  for (size_t i = first_handler_[index]; i < first_handler_[index + 1]; i++) {
+    handlers_[i](msg);
+  }
+}
+
+bool N2kPgnDispatcher::handles(unsigned long pgn) {
+  if (!finalized_) {
+    finalize();
+  }
+  return pgns_.contains(pgn);
+}
+
+const std::vector<uint32_t>& N2kPgnDispatcher::get_pgns() {
+  if (!finalized_) {
+    finalize();
+  }
+  return pgns_.get_pgns();
+}
+
+}  // namespace halmet
@@ -0,0 +1,67 @@
+#ifndef HALMET_SRC_N2K_PGN_DISPATCHER_H_
+#define HALMET_SRC_N2K_PGN_DISPATCHER_H_
+
+#include <N2kMsg.h>
+
+#include <functional>
+#include <vector>
+
+#include "pgn_set.h"
+
+namespace halmet {
+
+/**
+ * @brief Maps PGNs to the handlers interested in them.
+ *
+ * Decoders register their handlers at startup with add_handler(). The first
+ * dispatch (or an explicit call to finalize()) compacts the registrations
+ * into a PgnSet, a sorted PGN table with a hashed presence bitmap. After
+ * that:
+ *
+ *  - a PGN nobody registered for is usually rejected with a single bitmap
+ *    test, before any parsing happens;
+ *  - a registered PGN is found by binary search over the sorted table, so
+ *    the cost per frame stays flat as decoders are added.
+ */
+class N2kPgnDispatcher {
+ public:
+  using Handler = std::function<void(const tN2kMsg&)>;
+
+  void add_handler(unsigned long pgn, Handler handler);
+
+  /// Build the lookup tables. Called automatically on the first dispatch.
+  void finalize();
+
+  /// Run all handlers registered for the message's PGN.
+  void dispatch(const tN2kMsg& msg);
+
+  /// True if at least one handler is registered for pgn.
+  bool handles(unsigned long pgn);
+
+  /// The sorted list of PGNs that have handlers.
+  const std::vector<uint32_t>& get_pgns();
+
+  uint32_t get_dispatched() const { return dispatched_; }
+  uint32_t get_rejected() const { return rejected_; }
+
+ protected:
+  struct Registration {
+    unsigned long pgn;
+    Handler handler;
+  };
+  std::vector<Registration> registrations_;
+  bool finalized_ = false;
+
+  PgnSet pgns_;
+  // Handlers for the i-th PGN in pgns_ are handlers_[first_handler_[i]] up to, but not
+  // including, handlers_[first_handler_[i + 1]]
+  std::vector<size_t> first_handler_;
+  std::vector<Handler> handlers_;
+
+  uint32_t dispatched_ = 0;
+  uint32_t rejected_ = 0;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_N2K_PGN_DISPATCHER_H_
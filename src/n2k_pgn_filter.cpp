@@ -0,0 +1,72 @@
+#include "n2k_pgn_filter.h"
+
+#include <cmath>
+
+#include "n2k_frame_log.h"
+
+namespace halmet {
+
+// PGNs the library needs for network management and device information
+static const uint32_t kSystemPgns[] = {
+    59392,   // ISO Acknowledgement
+    59904,   // ISO Request
+    60160,   // ISO Transport Protocol, Data Transfer
+    60416,   // ISO Transport Protocol, Connection Management
+    60928,   // ISO Address Claim
+    65240,   // ISO Commanded Address
+    126208,  // Group Function
+    126464,  // PGN List
+    126993,  // Heartbeat
+    126996,  // Product Information
+    126998,  // Configuration Information
+};
+
+// CAN ID bits: priority (26-28), PGN incl. DP and PS (8-25), source (0-7)
+const uint32_t kCanIdPriorityBits = 0x1C000000;
+const uint32_t kCanIdPgnBits = 0x03FFFF00;
+const uint32_t kCanIdPsBits = 0x0000FF00;
+const uint32_t kCanIdSourceBits = 0x000000FF;
+
+float CanAcceptanceFilter::pgn_pass_ratio() const {
+  uint32_t dont_care = mask & kCanIdPgnBits;
+  int bits = 0;
+  while (dont_care) {
+    bits += dont_care & 1;
+    dont_care >>= 1;
+  }
+  return std::ldexp(1.0f, bits - 18);
+}
+
+N2kPgnFilter::N2kPgnFilter() {
+  for (uint32_t pgn : kSystemPgns) {
+    allow(pgn);
+  }
+}
+
+void N2kPgnFilter::allow(uint32_t pgn) { pgns_.insert(pgn); }
+
+bool N2kPgnFilter::accepts(uint32_t can_id) const {
+  return pgns_.contains(N2kCanIdToPgn(can_id));
+}
+
+CanAcceptanceFilter N2kPgnFilter::get_acceptance_filter() const {
+  CanAcceptanceFilter result = {0, kCanIdPriorityBits | kCanIdSourceBits};
+  bool first = true;
+  for (uint32_t pgn : pgns_.get_pgns()) {
+    uint32_t id = pgn << 8;
+    uint32_t dont_care = 0;
+    // PDU1: the PS field carries the destination address
+    if (((pgn >> 8) & 0xFF) < 240) {
+      dont_care |= kCanIdPsBits;
+    }
+    if (first) {
+      result.code = id;
+      first = false;
+    }
+    result.mask |= dont_care | (result.code ^ id);
+  }
+  result.code &= ~result.mask;
+  return result;
+}
+
+}  // namespace halmet
@@ -0,0 +1,62 @@
+#ifndef HALMET_SRC_N2K_PGN_FILTER_H_
+#define HALMET_SRC_N2K_PGN_FILTER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "pgn_set.h"
+
+namespace halmet {
+
+/// Acceptance code and mask for a CAN controller filter on the 29-bit ID.
+/// Mask bits set to 1 are "don't care".
+struct CanAcceptanceFilter {
+  uint32_t code;
+  uint32_t mask;
+
+  /// Fraction of all PGNs that pass the filter, 0...1.
+  float pgn_pass_ratio() const;
+};
+
+/**
+ * @brief PGN allow-list checked against the raw 29-bit CAN ID.
+ *
+ * Frames of PGNs that are not on the list can be discarded as soon as they
+ * are read from the controller, before the NMEA 2000 library spends any
+ * time on them: no fast-packet reassembly buffer is allocated and no
+ * message is parsed.
+ *
+ * The network management PGNs the library itself relies on (address
+ * claiming, ISO requests, transport protocol, product and configuration
+ * information and so on) are always allowed.
+ */
+class N2kPgnFilter {
+ public:
+  N2kPgnFilter();
+
+  void allow(uint32_t pgn);
+
+  template <typename Container>
+  void allow_all(const Container& pgns) {
+    for (auto pgn : pgns) {
+      allow(pgn);
+    }
+  }
+
+  /// True if frames with this CAN ID should be processed.
+  bool accepts(uint32_t can_id) const;
+
+  /// The sorted list of allowed PGNs.
+  const std::vector<uint32_t>& get_pgns() const { return pgns_.get_pgns(); }
+
+  /// The narrowest single code/mask hardware filter that passes every
+  /// allowed PGN from any source and at any priority.
+  CanAcceptanceFilter get_acceptance_filter() const;
+
+ protected:
+  PgnSet pgns_;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_N2K_PGN_FILTER_H_
@@ -4,13 +4,60 @@
 #include <N2kMessages.h>
 #include <NMEA2000.h>
 
+#include <type_traits>
+
+#include "n2k_transmit_scheduler.h"
+#include "packed_fields.h"
+#include "sensesp/system/observablevalue.h"
 #include "sensesp/system/saveable.h"
+#include "sensesp/system/valueconsumer.h"
 #include "sensesp/transforms/lambda_transform.h"
-#include "sensesp/transforms/repeat.h"
 #include "sensesp_base_app.h"
 
 namespace halmet {
 
+/**
+ * @brief Connectable input that stores into a field of a packed value
+ * table and stamps the field's update time.
+ *
+ * The input itself is a small member of the sender that owns the table, so
+ * connecting a producer allocates nothing and registers no timer.
+ */
+template <typename T>
+class PackedFieldInput : public sensesp::ValueConsumer<T> {
+ public:
+  PackedFieldInput(T* field, unsigned long* last_update)
+      : field_{field}, last_update_{last_update} {}
+
+  virtual void set(const T& value) override {
+    *field_ = value;
+    *last_update_ = millis();
+  }
+
+ private:
+  T* field_;
+  unsigned long* last_update_;
+};
+
+/**
+ * @brief Connectable input for a single bit of a packed status word.
+ */
+class PackedBitInput : public sensesp::ValueConsumer<bool> {
+ public:
+  PackedBitInput(uint32_t* bits, uint8_t bit, unsigned long* last_update)
+      : bits_{bits}, bit_{bit}, last_update_{last_update} {}
+
+  virtual void set(const bool& value) override {
+    SetBit(bits_, bit_, value);
+    *last_update_ = millis();
+  }
+
+ private:
+  uint32_t* bits_;
+  uint8_t bit_;
+  unsigned long* last_update_;
+};
+
 /**
  * @brief Transmit NMEA 2000 PGN 127488: Engine Parameters, Rapid Update
  *
@@ -18,28 +65,30 @@ namespace halmet {
 class N2kEngineParameterRapidSender : public sensesp::FileSystemSaveable {
  public:
   N2kEngineParameterRapidSender(String config_path, uint8_t engine_instance,
-                                tNMEA2000* nmea2000)
+                                N2kTransmitScheduler* scheduler)
       : sensesp::FileSystemSaveable{config_path},
         engine_instance_{engine_instance},
-        nmea2000_{nmea2000},
         repeat_interval_{100},  // In ms. Dictated by NMEA 2000 standard!
         expiry_{1000}           // In ms. When the inputs expire.
   {
-    this->initialize_members(repeat_interval_, expiry_);
-    sensesp::event_loop()->onRepeat(repeat_interval_, [this]() {
-      tN2kMsg N2kMsg;
-      // At the moment, the PGN is sent regardless of whether all the values
-      // are invalid or not.
+    scheduler->add(127488L, repeat_interval_, [this](tN2kMsg& N2kMsg) {
+      unsigned long now = millis();
+      bool speed_fresh = IsFresh(value_updated_[kEngineSpeed], now, expiry_);
+      bool boost_fresh =
+          IsFresh(value_updated_[kEngineBoostPressure], now, expiry_);
+      bool trim_fresh = IsFresh(value_updated_[kEngineTiltTrim], now, expiry_);
       SetN2kEngineParamRapid(
-          N2kMsg, this->engine_instance_, this->engine_speed_rpm_->get(),
-          this->engine_boost_pressure_->get(), this->engine_tilt_trim_->get());
-      this->nmea2000_->SendMsg(N2kMsg);
-    });
+          N2kMsg, this->engine_instance_,
+          speed_fresh ? values_.engine_speed_rpm : N2kDoubleNA,
+          boost_fresh ? values_.engine_boost_pressure : N2kDoubleNA,
+          trim_fresh ? values_.engine_tilt_trim : N2kInt8NA);
+      return speed_fresh || boost_fresh || trim_fresh;
+    }, N2kTxClass::kRapid);
 
     engine_speed_
         .connect_to(new sensesp::LambdaTransform<double, double>(
             [](double value) { return 60 * value; }))
-        ->connect_to(engine_speed_rpm_);
+        ->connect_to(&engine_speed_rpm_);
   }
 
   virtual bool from_json(const JsonObject& config) override {
@@ -57,28 +106,34 @@ class N2kEngineParameterRapidSender : public sensesp::FileSystemSaveable {
 
   sensesp::ObservableValue<double>
       engine_speed_;  // Connected to engine_speed_rpm_
-  std::shared_ptr<sensesp::RepeatExpiring<double>> engine_boost_pressure_;
-  std::shared_ptr<sensesp::RepeatExpiring<int8_t>> engine_tilt_trim_;
+  PackedFieldInput<double> engine_boost_pressure_{
+      &values_.engine_boost_pressure, &value_updated_[kEngineBoostPressure]};
+  PackedFieldInput<int8_t> engine_tilt_trim_{&values_.engine_tilt_trim,
+                                             &value_updated_[kEngineTiltTrim]};
 
  protected:
+  enum ValueField {
+    kEngineSpeed,
+    kEngineBoostPressure,
+    kEngineTiltTrim,
+    kNumValueFields
+  };
+
+  struct Values {
+    double engine_speed_rpm = N2kDoubleNA;
+    double engine_boost_pressure = N2kDoubleNA;
+    int8_t engine_tilt_trim = N2kInt8NA;
+  };
+
   unsigned int repeat_interval_;
   unsigned int expiry_;
-  tNMEA2000* nmea2000_;
 
-  std::shared_ptr<sensesp::RepeatExpiring<double>> engine_speed_rpm_;
+  Values values_;
+  unsigned long value_updated_[kNumValueFields] = {};
+  PackedFieldInput<double> engine_speed_rpm_{&values_.engine_speed_rpm,
+                                             &value_updated_[kEngineSpeed]};
 
   uint8_t engine_instance_ = 0;
-
- private:
-  void initialize_members(unsigned int repeat_interval, unsigned int expiry) {
-    // Initialize the RepeatExpiring objects
-    engine_boost_pressure_ = std::make_shared<sensesp::RepeatExpiring<double>>(
-        repeat_interval, expiry);
-    engine_tilt_trim_ = std::make_shared<sensesp::RepeatExpiring<int8_t>>(
-        repeat_interval, expiry);
-    engine_speed_rpm_ = std::make_shared<sensesp::RepeatExpiring<double>>(
-        repeat_interval, expiry);
-  }
 };
 
 const String ConfigSchema(const N2kEngineParameterRapidSender& obj) {
@@ -93,70 +148,92 @@ const String ConfigSchema(const N2kEngineParameterRapidSender& obj) {
 /**
  * @brief Transmit NMEA 2000 PGN 127489: Engine Parameters, Dynamic
  *
+ * The numeric fields live in one contiguous struct and the status flags in
+ * a single bit word, each with a per-field update timestamp. A field that
+ * hasn't been updated within the expiry time is transmitted as "not
+ * available" (numeric) or cleared (flag). The sender has no timers of its
+ * own; the transmit scheduler calls it when the PGN is due.
  */
 class N2kEngineParameterDynamicSender : public sensesp::FileSystemSaveable {
  public:
   N2kEngineParameterDynamicSender(String config_path, uint8_t engine_instance,
-                                  tNMEA2000* nmea2000)
+                                  N2kTransmitScheduler* scheduler)
       : sensesp::FileSystemSaveable{config_path},
         engine_instance_{engine_instance},
-        nmea2000_{nmea2000},
         repeat_interval_{500},  // In ms. Dictated by NMEA 2000 standard!
         expiry_{5000}           // In ms. When the inputs expire.
   {
-    this->initialize_members(repeat_interval_, expiry_);
-
-    sensesp::event_loop()->onRepeat(repeat_interval_, [this]() {
-      tN2kMsg N2kMsg;
+    scheduler->add(127489L, repeat_interval_, [this](tN2kMsg& N2kMsg) {
+      unsigned long now = millis();
       SetN2kEngineDynamicParam(
-          N2kMsg, this->engine_instance_, this->oil_pressure_->get(),
-          this->oil_temperature_->get(), this->temperature_->get(),
-          this->alternator_potential_->get(), this->fuel_rate_->get(),
-          this->total_engine_hours_->get(), this->coolant_pressure_->get(),
-          this->fuel_pressure_->get(), this->engine_load_->get(),
-          this->engine_torque_->get(), this->get_engine_status_1(),
-          this->get_engine_status_2());
-      this->nmea2000_->SendMsg(N2kMsg);
-    });
+          N2kMsg, this->engine_instance_,
+          this->get(values_.oil_pressure, kOilPressure, now, N2kDoubleNA),
+          this->get(values_.oil_temperature, kOilTemperature, now, N2kDoubleNA),
+          this->get(values_.temperature, kTemperature, now, N2kDoubleNA),
+          this->get(values_.alternator_potential, kAlternatorPotential, now,
+                    N2kDoubleNA),
+          this->get(values_.fuel_rate, kFuelRate, now, N2kDoubleNA),
+          this->get(values_.total_engine_hours, kTotalEngineHours, now,
+                    N2kUInt32NA),
+          this->get(values_.coolant_pressure, kCoolantPressure, now,
+                    N2kDoubleNA),
+          this->get(values_.fuel_pressure, kFuelPressure, now, N2kDoubleNA),
+          this->get(values_.engine_load, kEngineLoad, now, N2kInt8NA),
+          this->get(values_.engine_torque, kEngineTorque, now, N2kInt8NA),
+          this->get_engine_status_1(now), this->get_engine_status_2(now));
+      return this->any_fresh(now);
+    }, N2kTxClass::kDynamic);
   }
 
   // Data to be transmitted
-  std::shared_ptr<sensesp::RepeatExpiring<double>> oil_pressure_;
-  std::shared_ptr<sensesp::RepeatExpiring<double>> oil_temperature_;
-  std::shared_ptr<sensesp::RepeatExpiring<double>> temperature_;
-  std::shared_ptr<sensesp::RepeatExpiring<double>> alternator_potential_;
-  std::shared_ptr<sensesp::RepeatExpiring<double>> fuel_rate_;
-  std::shared_ptr<sensesp::RepeatExpiring<uint32_t>> total_engine_hours_;
-  std::shared_ptr<sensesp::RepeatExpiring<double>> coolant_pressure_;
-  std::shared_ptr<sensesp::RepeatExpiring<double>> fuel_pressure_;
-  std::shared_ptr<sensesp::RepeatExpiring<int>> engine_load_;
-  std::shared_ptr<sensesp::RepeatExpiring<int>> engine_torque_;
+  PackedFieldInput<double> oil_pressure_{&values_.oil_pressure,
+                                         &value_updated_[kOilPressure]};
+  PackedFieldInput<double> oil_temperature_{&values_.oil_temperature,
+                                            &value_updated_[kOilTemperature]};
+  PackedFieldInput<double> temperature_{&values_.temperature,
+                                        &value_updated_[kTemperature]};
+  PackedFieldInput<double> alternator_potential_{
+      &values_.alternator_potential, &value_updated_[kAlternatorPotential]};
+  PackedFieldInput<double> fuel_rate_{&values_.fuel_rate,
+                                      &value_updated_[kFuelRate]};
+  PackedFieldInput<uint32_t> total_engine_hours_{
+      &values_.total_engine_hours, &value_updated_[kTotalEngineHours]};
+  PackedFieldInput<double> coolant_pressure_{&values_.coolant_pressure,
+                                             &value_updated_[kCoolantPressure]};
+  PackedFieldInput<double> fuel_pressure_{&values_.fuel_pressure,
+                                          &value_updated_[kFuelPressure]};
+  PackedFieldInput<int> engine_load_{&values_.engine_load,
+                                     &value_updated_[kEngineLoad]};
+  PackedFieldInput<int> engine_torque_{&values_.engine_torque,
+                                       &value_updated_[kEngineTorque]};
   // Engine status 1 fields
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> check_engine_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> over_temperature_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> low_oil_pressure_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> low_oil_level_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> low_fuel_pressure_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> low_system_voltage_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> low_coolant_level_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> water_flow_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> water_in_fuel_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> charge_indicator_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> preheat_indicator_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> high_boost_pressure_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> rev_limit_exceeded_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> egr_system_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> throttle_position_sensor_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> emergency_stop_;
+  PackedBitInput check_engine_ = bit_input(kCheckEngine);
+  PackedBitInput over_temperature_ = bit_input(kOverTemperature);
+  PackedBitInput low_oil_pressure_ = bit_input(kLowOilPressure);
+  PackedBitInput low_oil_level_ = bit_input(kLowOilLevel);
+  PackedBitInput low_fuel_pressure_ = bit_input(kLowFuelPressure);
+  PackedBitInput low_system_voltage_ = bit_input(kLowSystemVoltage);
+  PackedBitInput low_coolant_level_ = bit_input(kLowCoolantLevel);
+  PackedBitInput water_flow_ = bit_input(kWaterFlow);
+  PackedBitInput water_in_fuel_ = bit_input(kWaterInFuel);
+  PackedBitInput charge_indicator_ = bit_input(kChargeIndicator);
+  PackedBitInput preheat_indicator_ = bit_input(kPreheatIndicator);
+  PackedBitInput high_boost_pressure_ = bit_input(kHighBoostPressure);
+  PackedBitInput rev_limit_exceeded_ = bit_input(kRevLimitExceeded);
+  PackedBitInput egr_system_ = bit_input(kEGRSystem);
+  PackedBitInput throttle_position_sensor_ =
+      bit_input(kThrottlePositionSensor);
+  PackedBitInput emergency_stop_ = bit_input(kEmergencyStop);
   // Engine status 2 fields
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> warning_level_1_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> warning_level_2_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> power_reduction_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> maintenance_needed_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> engine_comm_error_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> sub_or_secondary_throttle_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> neutral_start_protect_;
-  std::shared_ptr<sensesp::RepeatExpiring<bool>> engine_shutting_down_;
+  PackedBitInput warning_level_1_ = bit_input(kWarningLevel1);
+  PackedBitInput warning_level_2_ = bit_input(kWarningLevel2);
+  PackedBitInput power_reduction_ = bit_input(kPowerReduction);
+  PackedBitInput maintenance_needed_ = bit_input(kMaintenanceNeeded);
+  PackedBitInput engine_comm_error_ = bit_input(kEngineCommError);
+  PackedBitInput sub_or_secondary_throttle_ =
+      bit_input(kSubOrSecondaryThrottle);
+  PackedBitInput neutral_start_protect_ = bit_input(kNeutralStartProtect);
+  PackedBitInput engine_shutting_down_ = bit_input(kEngineShuttingDown);
 
   virtual bool from_json(const JsonObject& config) override {
     if (!config["engine_instance"].is<int>()) {
@@ -172,132 +249,103 @@ class N2kEngineParameterDynamicSender : public sensesp::FileSystemSaveable {
   }
 
  protected:
-  tN2kEngineDiscreteStatus1 get_engine_status_1() {
-    tN2kEngineDiscreteStatus1 status = 0;
-
-    // Get the status from each of the sensor checks
-    status.Bits.OverTemperature = over_temperature_->get();
-    status.Bits.LowOilPressure = low_oil_pressure_->get();
-    status.Bits.LowOilLevel = low_oil_level_->get();
-    status.Bits.LowFuelPressure = low_fuel_pressure_->get();
-    status.Bits.LowSystemVoltage = low_system_voltage_->get();
-    status.Bits.LowCoolantLevel = low_coolant_level_->get();
-    status.Bits.WaterFlow = water_flow_->get();
-    status.Bits.WaterInFuel = water_in_fuel_->get();
-    status.Bits.ChargeIndicator = charge_indicator_->get();
-    status.Bits.PreheatIndicator = preheat_indicator_->get();
-    status.Bits.HighBoostPressure = high_boost_pressure_->get();
-    status.Bits.RevLimitExceeded = rev_limit_exceeded_->get();
-    status.Bits.EGRSystem = egr_system_->get();
-    status.Bits.ThrottlePositionSensor = throttle_position_sensor_->get();
-    status.Bits.EngineEmergencyStopMode = emergency_stop_->get();
-
-    // Set CheckEngine if any other status bit is set
-    status.Bits.CheckEngine =
-        status.Bits.OverTemperature || status.Bits.LowOilPressure ||
-        status.Bits.LowOilLevel || status.Bits.LowFuelPressure ||
-        status.Bits.LowSystemVoltage || status.Bits.LowCoolantLevel ||
-        status.Bits.WaterFlow || status.Bits.WaterInFuel ||
-        status.Bits.ChargeIndicator || status.Bits.PreheatIndicator ||
-        status.Bits.HighBoostPressure || status.Bits.RevLimitExceeded ||
-        status.Bits.EGRSystem || status.Bits.ThrottlePositionSensor ||
-        status.Bits.EngineEmergencyStopMode;
-
-    return status;
+  enum ValueField {
+    kOilPressure,
+    kOilTemperature,
+    kTemperature,
+    kAlternatorPotential,
+    kFuelRate,
+    kTotalEngineHours,
+    kCoolantPressure,
+    kFuelPressure,
+    kEngineLoad,
+    kEngineTorque,
+    kNumValueFields
+  };
+
+  // Bit positions match the NMEA 2000 layout: status 1 in bits 0-15,
+  // status 2 in bits 16-23
+  enum StatusBit {
+    kCheckEngine,
+    kOverTemperature,
+    kLowOilPressure,
+    kLowOilLevel,
+    kLowFuelPressure,
+    kLowSystemVoltage,
+    kLowCoolantLevel,
+    kWaterFlow,
+    kWaterInFuel,
+    kChargeIndicator,
+    kPreheatIndicator,
+    kHighBoostPressure,
+    kRevLimitExceeded,
+    kEGRSystem,
+    kThrottlePositionSensor,
+    kEmergencyStop,
+    kWarningLevel1,
+    kWarningLevel2,
+    kPowerReduction,
+    kMaintenanceNeeded,
+    kEngineCommError,
+    kSubOrSecondaryThrottle,
+    kNeutralStartProtect,
+    kEngineShuttingDown,
+    kNumStatusBits
+  };
+
+  struct Values {
+    double oil_pressure = N2kDoubleNA;
+    double oil_temperature = N2kDoubleNA;
+    double temperature = N2kDoubleNA;
+    double alternator_potential = N2kDoubleNA;
+    double fuel_rate = N2kDoubleNA;
+    uint32_t total_engine_hours = N2kUInt32NA;
+    double coolant_pressure = N2kDoubleNA;
+    double fuel_pressure = N2kDoubleNA;
+    int engine_load = N2kInt8NA;
+    int engine_torque = N2kInt8NA;
+  };
+
+  template <typename T>
+  T get(T value, ValueField field, unsigned long now,
+        typename std::common_type<T>::type not_available) const {
+    return IsFresh(value_updated_[field], now, expiry_) ? value
+                                                         : not_available;
+  }
+
+  // Status bits that are set and haven't expired
+  uint32_t get_status_bits(unsigned long now) const {
+    return FreshBits(status_bits_, status_updated_, kNumStatusBits, now,
+                     expiry_);
   }
 
-  tN2kEngineDiscreteStatus2 get_engine_status_2() {
-    tN2kEngineDiscreteStatus2 status = 0;
-    status.Bits.WarningLevel1 = warning_level_1_->get();
-    status.Bits.WarningLevel2 = warning_level_2_->get();
-    status.Bits.LowOiPowerReduction = power_reduction_->get();
-    status.Bits.MaintenanceNeeded = maintenance_needed_->get();
-    status.Bits.EngineCommError = engine_comm_error_->get();
-    status.Bits.SubOrSecondaryThrottle = sub_or_secondary_throttle_->get();
-    status.Bits.NeutralStartProtect = neutral_start_protect_->get();
-    status.Bits.EngineShuttingDown = engine_shutting_down_->get();
-    return status;
+  // True if at least one field or flag hasn't expired
+  bool any_fresh(unsigned long now) const {
+    return AnyFresh(value_updated_, kNumValueFields, now, expiry_) ||
+           AnyFresh(status_updated_, kNumStatusBits, now, expiry_);
+  }
+
+  tN2kEngineDiscreteStatus1 get_engine_status_1(unsigned long now) const {
+    return EngineStatus1(get_status_bits(now));
+  }
+
+  tN2kEngineDiscreteStatus2 get_engine_status_2(unsigned long now) const {
+    return EngineStatus2(get_status_bits(now));
+  }
+
+  PackedBitInput bit_input(StatusBit bit) {
+    return PackedBitInput(&status_bits_, bit, &status_updated_[bit]);
   }
 
   unsigned int repeat_interval_;
   unsigned int expiry_;
-  tNMEA2000* nmea2000_;
 
   uint8_t engine_instance_;
 
- private:
-  void initialize_members(uint32_t repeat_interval_, uint32_t expiry_) {
-    // Initialize all RepeatExpiring members
-    oil_pressure_ = std::make_shared<sensesp::RepeatExpiring<double>>(
-        repeat_interval_, expiry_);
-    oil_temperature_ = std::make_shared<sensesp::RepeatExpiring<double>>(
-        repeat_interval_, expiry_);
-    temperature_ = std::make_shared<sensesp::RepeatExpiring<double>>(
-        repeat_interval_, expiry_);
-    alternator_potential_ = std::make_shared<sensesp::RepeatExpiring<double>>(
-        repeat_interval_, expiry_);
-    fuel_rate_ = std::make_shared<sensesp::RepeatExpiring<double>>(
-        repeat_interval_, expiry_);
-    total_engine_hours_ = std::make_shared<sensesp::RepeatExpiring<uint32_t>>(
-        repeat_interval_, expiry_);
-    coolant_pressure_ = std::make_shared<sensesp::RepeatExpiring<double>>(
-        repeat_interval_, expiry_);
-    fuel_pressure_ = std::make_shared<sensesp::RepeatExpiring<double>>(
-        repeat_interval_, expiry_);
-    engine_load_ = std::make_shared<sensesp::RepeatExpiring<int>>(
-        repeat_interval_, expiry_);
-    engine_torque_ = std::make_shared<sensesp::RepeatExpiring<int>>(
-        repeat_interval_, expiry_);
-    check_engine_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    over_temperature_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    low_oil_pressure_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    low_oil_level_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    low_fuel_pressure_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    low_system_voltage_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    low_coolant_level_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    water_flow_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    water_in_fuel_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    charge_indicator_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    preheat_indicator_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    high_boost_pressure_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    rev_limit_exceeded_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    egr_system_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    throttle_position_sensor_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    emergency_stop_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    warning_level_1_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    warning_level_2_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    power_reduction_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    maintenance_needed_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    engine_comm_error_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    sub_or_secondary_throttle_ =
-        std::make_shared<sensesp::RepeatExpiring<bool>>(repeat_interval_,
-                                                        expiry_);
-    neutral_start_protect_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-    engine_shutting_down_ = std::make_shared<sensesp::RepeatExpiring<bool>>(
-        repeat_interval_, expiry_);
-  }
+  Values values_;
+  unsigned long value_updated_[kNumValueFields] = {};
+  uint32_t status_bits_ = 0;
+  unsigned long status_updated_[kNumStatusBits] = {};
 };
 
 const String ConfigSchema(const N2kEngineParameterDynamicSender& obj) {
@@ -317,12 +365,11 @@ class N2kFluidLevelSender : public sensesp::FileSystemSaveable {
  public:
   N2kFluidLevelSender(String config_path, uint8_t tank_instance,
                       tN2kFluidType tank_type, double tank_capacity,
-                      tNMEA2000* nmea2000)
+                      N2kTransmitScheduler* scheduler)
       : sensesp::FileSystemSaveable{config_path},
         tank_instance_{tank_instance},
         tank_type_{tank_type},
         tank_capacity_{tank_capacity},
-        nmea2000_{nmea2000},
         repeat_interval_{2500},  // In ms. Dictated by NMEA 2000 standard!
         expiry_{10000}           // In ms. When the inputs expire.
   {
@@ -331,14 +378,13 @@ class N2kFluidLevelSender : public sensesp::FileSystemSaveable {
             [this](double value) { return 100 * value; }))
         ->connect_to(&tank_level_percent_);
 
-    sensesp::event_loop()->onRepeat(repeat_interval_, [this]() {
-      tN2kMsg N2kMsg;
-      // At the moment, the PGN is sent regardless of whether all the values
-      // are invalid or not.
+    scheduler->add(127505L, repeat_interval_, [this](tN2kMsg& N2kMsg) {
+      bool fresh = IsFresh(level_updated_, millis(), expiry_);
       SetN2kFluidLevel(N2kMsg, this->tank_instance_, this->tank_type_,
-                       this->tank_level_percent_.get(), this->tank_capacity_);
-      this->nmea2000_->SendMsg(N2kMsg);
-    });
+                       fresh ? level_percent_ : N2kDoubleNA,
+                       this->tank_capacity_);
+      return fresh;
+    }, N2kTxClass::kSlow);
   }
 
   virtual bool from_json(const JsonObject& config) override {
@@ -368,13 +414,15 @@ class N2kFluidLevelSender : public sensesp::FileSystemSaveable {
  protected:
   unsigned int repeat_interval_;
   unsigned int expiry_;
-  tNMEA2000* nmea2000_;
 
   uint8_t tank_instance_;
   tN2kFluidType tank_type_;
   double tank_capacity_;  // in liters
-  sensesp::RepeatExpiring<double> tank_level_percent_{repeat_interval_,
-                                                      expiry_};
+
+  double level_percent_ = N2kDoubleNA;
+  unsigned long level_updated_ = 0;
+  PackedFieldInput<double> tank_level_percent_{&level_percent_,
+                                               &level_updated_};
 };
 
 const String ConfigSchema(const N2kFluidLevelSender& obj) {
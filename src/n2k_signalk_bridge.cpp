@@ -0,0 +1,236 @@
+#include "n2k_signalk_bridge.h"
+
+#include <N2kMessages.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "sensesp.h"
+#include "halmet_sk_delta.h"
+#include "sensesp/ui/config_item.h"
+#include "sk_delta_batcher.h"
+
+namespace halmet {
+
+// Web UI position of the bridge outputs, after the local inputs
+const int kN2kSortOrder = 5000;
+
+unsigned long N2kFieldPgn(N2kField field) {
+  if (field <= N2kField::kEngineTiltTrim) {
+    return 127488;
+  } else if (field <= N2kField::kEngineTorque) {
+    return 127489;
+  } else if (field <= N2kField::kTripEconomyFuelRate) {
+    return 127497;
+  } else if (field <= N2kField::kFluidCapacity) {
+    return 127505;
+  }
+  return 127508;
+}
+
+static void Store(float* values, N2kField field, double value) {
+  values[static_cast<int>(field)] = N2kIsNA(value) ? NAN : value;
+}
+
+static void StorePercent(float* values, N2kField field, int8_t percent) {
+  values[static_cast<int>(field)] =
+      percent == N2kInt8NA ? NAN : percent / 100.0f;
+}
+
+// l/h to m3/s
+static double LitresPerHour(double value) {
+  return N2kIsNA(value) ? value : value / 3600.0 * 0.001;
+}
+
+N2kSignalKBridge::N2kSignalKBridge(const N2kSignalKMapping* mappings,
+                                   size_t num_mappings,
+                                   unsigned int heartbeat_interval)
+    : mappings_(mappings, mappings + num_mappings),
+      outputs_(num_mappings, {NAN, 0}),
+      heartbeat_interval_{heartbeat_interval} {}
+
+void N2kSignalKBridge::register_handlers(N2kPgnDispatcher* dispatcher) {
+  std::vector<unsigned long> pgns;
+  for (const auto& mapping : mappings_) {
+    pgns.push_back(N2kFieldPgn(mapping.field));
+  }
+  std::sort(pgns.begin(), pgns.end());
+  pgns.erase(std::unique(pgns.begin(), pgns.end()), pgns.end());
+
+  for (unsigned long pgn : pgns) {
+    dispatcher->add_handler(pgn,
+                            [this](const tN2kMsg& msg) { this->handle(msg); });
+  }
+}
+
+void N2kSignalKBridge::connect(N2kReceiveTask* task) {
+  task_ = task;
+  for (size_t i = 0; i < mappings_.size(); i++) {
+    const N2kSignalKMapping& mapping = mappings_[i];
+    // Keyed by the default path, so renaming the output in the web UI
+    // keeps its config
+    char config_path[80];
+    char config_title[80];
+    snprintf(config_path, sizeof(config_path), "/NMEA 2000/%s/SK Path",
+             mapping.sk_path);
+    snprintf(config_title, sizeof(config_title), "NMEA 2000 %s",
+             mapping.sk_path);
+    auto output =
+        new SKTemplateOutputFloat(mapping.sk_path, config_path, mapping.units);
+    sensesp::ConfigItem(output)
+        ->set_title(config_title)
+        ->set_description("Signal K path of a value forwarded from NMEA 2000")
+        ->set_sort_order(kN2kSortOrder + i);
+    auto value = new sensesp::ObservableValue<float>();
+    value->connect_to(Batched(output));
+    values_.push_back(value);
+    task->bind(static_cast<OutputId>(i), value);
+  }
+}
+
+sensesp::ObservableValue<float>* N2kSignalKBridge::get_output(
+    N2kField field, uint8_t instance) {
+  for (size_t i = 0; i < values_.size(); i++) {
+    if (mappings_[i].field == field && mappings_[i].instance == instance) {
+      return values_[i];
+    }
+  }
+  return nullptr;
+}
+
+bool N2kSignalKBridge::decode(const tN2kMsg& msg, uint8_t* instance,
+                              float* values) {
+  unsigned char parsed_instance;
+
+  switch (msg.PGN) {
+    case 127488: {
+      double speed, boost;
+      int8_t trim;
+      if (!ParseN2kEngineParamRapid(msg, parsed_instance, speed, boost,
+                                    trim)) {
+        return false;
+      }
+      // Signal K wants revolutions per second
+      Store(values, N2kField::kEngineSpeed,
+            N2kIsNA(speed) ? speed : speed / 60);
+      Store(values, N2kField::kEngineBoostPressure, boost);
+      StorePercent(values, N2kField::kEngineTiltTrim, trim);
+      break;
+    }
+    case 127489: {
+      double oil_pressure, oil_temperature, coolant_temperature,
+          alternator_voltage, fuel_rate, engine_hours, coolant_pressure,
+          fuel_pressure;
+      int8_t load, torque;
+      tN2kEngineDiscreteStatus1 status1;
+      tN2kEngineDiscreteStatus2 status2;
+      if (!ParseN2kEngineDynamicParam(
+              msg, parsed_instance, oil_pressure, oil_temperature,
+              coolant_temperature, alternator_voltage, fuel_rate,
+              engine_hours, coolant_pressure, fuel_pressure, load, torque,
+              status1, status2)) {
+        return false;
+      }
+      Store(values, N2kField::kOilPressure, oil_pressure);
+      Store(values, N2kField::kOilTemperature, oil_temperature);
+      Store(values, N2kField::kCoolantTemperature, coolant_temperature);
+      Store(values, N2kField::kAlternatorVoltage, alternator_voltage);
+      Store(values, N2kField::kFuelRate, LitresPerHour(fuel_rate));
+      Store(values, N2kField::kEngineHours, engine_hours);
+      Store(values, N2kField::kCoolantPressure, coolant_pressure);
+      Store(values, N2kField::kFuelPressure, fuel_pressure);
+      StorePercent(values, N2kField::kEngineLoad, load);
+      StorePercent(values, N2kField::kEngineTorque, torque);
+      break;
+    }
+    case 127497: {
+      double fuel_used, average_rate, economy_rate, instantaneous_economy;
+      if (!ParseN2kEngineTripParameters(msg, parsed_instance, fuel_used,
+                                        average_rate, economy_rate,
+                                        instantaneous_economy)) {
+        return false;
+      }
+      Store(values, N2kField::kTripFuelUsed,
+            N2kIsNA(fuel_used) ? fuel_used : fuel_used * 0.001);
+      Store(values, N2kField::kTripAverageFuelRate,
+            LitresPerHour(average_rate));
+      Store(values, N2kField::kTripEconomyFuelRate,
+            LitresPerHour(economy_rate));
+      break;
+    }
+    case 127505: {
+      tN2kFluidType fluid_type;
+      double level, capacity;
+      if (!ParseN2kFluidLevel(msg, parsed_instance, fluid_type, level,
+                              capacity)) {
+        return false;
+      }
+      Store(values, N2kField::kFluidLevel,
+            N2kIsNA(level) ? level : level / 100);
+      Store(values, N2kField::kFluidCapacity,
+            N2kIsNA(capacity) ? capacity : capacity * 0.001);
+      break;
+    }
+    case 127508: {
+      double voltage, current, temperature;
+      unsigned char sid;
+      if (!ParseN2kDCBatStatus(msg, parsed_instance, voltage, current,
+                               temperature, sid)) {
+        return false;
+      }
+      Store(values, N2kField::kBatteryVoltage, voltage);
+      Store(values, N2kField::kBatteryCurrent, current);
+      Store(values, N2kField::kBatteryTemperature, temperature);
+      break;
+    }
+    default:
+      return false;
+  }
+
+  *instance = parsed_instance;
+  return true;
+}
+
+void N2kSignalKBridge::handle(const tN2kMsg& msg) {
+  float values[kNumN2kFields];
+  uint8_t instance;
+  if (!decode(msg, &instance, values)) {
+    debugD("Failed to parse PGN: %lu", msg.PGN);
+    return;
+  }
+
+  unsigned long now = millis();
+  for (size_t i = 0; i < mappings_.size(); i++) {
+    const N2kSignalKMapping& mapping = mappings_[i];
+    if (mapping.instance != instance ||
+        N2kFieldPgn(mapping.field) != msg.PGN) {
+      continue;
+    }
+    float value = values[static_cast<int>(mapping.field)];
+    if (std::isnan(value)) {
+      continue;
+    }
+    value = value * mapping.scale + mapping.offset;
+
+    OutputState& output = outputs_[i];
+    unsigned long elapsed = now - output.last_sent;
+    unsigned long heartbeat_interval = mapping.heartbeat_interval > 0
+                                           ? mapping.heartbeat_interval
+                                           : heartbeat_interval_;
+    bool sent_before = !std::isnan(output.last_value);
+    if (sent_before && (elapsed < mapping.min_interval ||
+                        (value == output.last_value &&
+                         elapsed < heartbeat_interval))) {
+      suppressed_++;
+      continue;
+    }
+    output.last_value = value;
+    output.last_sent = now;
+    if (task_ != nullptr) {
+      task_->post(static_cast<OutputId>(i), value);
+      posted_++;
+    }
+  }
+}
+
+}  // namespace halmet
@@ -0,0 +1,133 @@
+#ifndef HALMET_SRC_N2K_SIGNALK_BRIDGE_H_
+#define HALMET_SRC_N2K_SIGNALK_BRIDGE_H_
+
+#include <N2kMsg.h>
+
+#include <vector>
+
+#include "halmet_n2k_task.h"
+#include "n2k_pgn_dispatcher.h"
+#include "sensesp/system/observablevalue.h"
+
+namespace halmet {
+
+/// NMEA 2000 fields the bridge can decode, grouped by PGN. Values are
+/// converted to Signal K units as noted.
+enum class N2kField : uint8_t {
+  // 127488 Engine Parameters, Rapid Update (instance: engine)
+  kEngineSpeed,           // Hz
+  kEngineBoostPressure,   // Pa
+  kEngineTiltTrim,        // ratio
+  // 127489 Engine Parameters, Dynamic (instance: engine)
+  kOilPressure,           // Pa
+  kOilTemperature,        // K
+  kCoolantTemperature,    // K
+  kAlternatorVoltage,     // V
+  kFuelRate,              // m3/s
+  kEngineHours,           // s
+  kCoolantPressure,       // Pa
+  kFuelPressure,          // Pa
+  kEngineLoad,            // ratio
+  kEngineTorque,          // ratio
+  // 127497 Trip Parameters, Engine (instance: engine)
+  kTripFuelUsed,          // m3
+  kTripAverageFuelRate,   // m3/s
+  kTripEconomyFuelRate,   // m3/s
+  // 127505 Fluid Level (instance: tank)
+  kFluidLevel,            // ratio
+  kFluidCapacity,         // m3
+  // 127508 Battery Status (instance: battery)
+  kBatteryVoltage,        // V
+  kBatteryCurrent,        // A
+  kBatteryTemperature,    // K
+};
+
+const int kNumN2kFields = static_cast<int>(N2kField::kBatteryTemperature) + 1;
+
+/// PGN that carries field.
+unsigned long N2kFieldPgn(N2kField field);
+
+/**
+ * @brief One row of the bridge's mapping table.
+ *
+ * The value of field in messages with the given instance is multiplied by
+ * scale, offset is added, and the result is sent to sk_path no more often
+ * than every min_interval milliseconds. An unchanged value is repeated
+ * every heartbeat_interval milliseconds; 0 uses the bridge's default.
+ */
+struct N2kSignalKMapping {
+  N2kField field;
+  uint8_t instance;
+  const char* sk_path;
+  const char* units;
+  unsigned int min_interval;
+  float scale = 1.0;
+  float offset = 0.0;
+  unsigned int heartbeat_interval = 0;
+};
+
+/**
+ * @brief Table-driven NMEA 2000 to Signal K gateway.
+ *
+ * The bridge registers a handler for each PGN that appears in its mapping
+ * table. Every message is decoded once into all fields of its PGN, and the
+ * result feeds all mappings for that PGN and instance.
+ *
+ * Before a value is posted to the event loop it is rate-limited to the
+ * mapping's min_interval, and repeats of an unchanged value are suppressed
+ * until heartbeat_interval has passed. This happens in the receive task, so
+ * suppressed values never reach the queue or the Signal K connection.
+ */
+class N2kSignalKBridge {
+ public:
+  N2kSignalKBridge(const N2kSignalKMapping* mappings, size_t num_mappings,
+                   unsigned int heartbeat_interval = 10000);
+
+  /// Register a handler for every mapped PGN.
+  void register_handlers(N2kPgnDispatcher* dispatcher);
+
+  /// Create an SKTemplateOutputFloat for every mapping and bind it to the
+  /// values posted through task. Each output's path can be changed in the
+  /// web UI; its config lives at "/NMEA 2000/<default path>/SK Path".
+  void connect(N2kReceiveTask* task);
+
+  /// The value stream of the first mapping for field and instance, for
+  /// connecting further consumers. Null if there is no such mapping or
+  /// connect() hasn't been called.
+  sensesp::ObservableValue<float>* get_output(N2kField field,
+                                              uint8_t instance);
+
+  /// Last value sent for mapping index, or NaN.
+  float get_value(size_t index) const { return outputs_[index].last_value; }
+
+  uint32_t get_posted() const { return posted_; }
+  uint32_t get_suppressed() const { return suppressed_; }
+
+ protected:
+  // Value IDs posted to the receive task are mapping indices
+  enum class OutputId : uint16_t {};
+
+  struct OutputState {
+    float last_value;
+    unsigned long last_sent;
+  };
+
+  void handle(const tN2kMsg& msg);
+
+  // Decode all fields of msg into values, indexed by N2kField. Fields that
+  // are not available are NaN.
+  static bool decode(const tN2kMsg& msg, uint8_t* instance, float* values);
+
+  std::vector<N2kSignalKMapping> mappings_;
+  std::vector<OutputState> outputs_;
+  std::vector<sensesp::ObservableValue<float>*> values_;
+  unsigned int heartbeat_interval_;
+  N2kReceiveTask* task_ = nullptr;
+
+  uint32_t posted_ = 0;
+  uint32_t suppressed_ = 0;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_N2K_SIGNALK_BRIDGE_H_
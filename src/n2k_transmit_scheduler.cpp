@@ -0,0 +1,65 @@
+#include "n2k_transmit_scheduler.h"
+
+#include "sensesp_base_app.h"
+
+namespace halmet {
+
+N2kTransmitScheduler::N2kTransmitScheduler(N2kTxQueue* tx_queue,
+                                           unsigned int tick_interval,
+                                           unsigned int report_interval)
+    : tx_queue_{tx_queue},
+      tick_interval_{tick_interval},
+      report_interval_{report_interval},
+      plan_{tick_interval} {}
+
+void N2kTransmitScheduler::add(unsigned long pgn, unsigned int period,
+                               Builder builder, N2kTxClass tx_class,
+                               unsigned int stale_divider) {
+  plan_.add(period, stale_divider);
+  entries_.push_back({pgn, tx_class, builder, {0, 0, 0}});
+}
+
+void N2kTransmitScheduler::start() {
+  plan_.assign_phases();
+  last_report_ = millis();
+  sensesp::event_loop()->onRepeat(tick_interval_, [this]() { this->tick(); });
+}
+
+void N2kTransmitScheduler::tick() {
+  for (size_t i = 0; i < entries_.size(); i++) {
+    if (!plan_.is_due(i, tick_count_)) {
+      continue;
+    }
+
+    Entry& entry = entries_[i];
+    tN2kMsg msg;
+    if (!plan_.should_send(i, entry.builder(msg))) {
+      entry.stats.stale_skipped++;
+      continue;
+    }
+
+    if (tx_queue_->enqueue(msg, entry.tx_class, i)) {
+      entry.stats.sent++;
+    } else {
+      entry.stats.queue_dropped++;
+    }
+  }
+  tick_count_++;
+
+  if (report_interval_ > 0 && millis() - last_report_ >= report_interval_) {
+    report();
+  }
+}
+
+void N2kTransmitScheduler::report() {
+  float elapsed_s = (millis() - last_report_) / 1000.0;
+  last_report_ = millis();
+  for (auto& entry : entries_) {
+    debugI("N2K tx PGN %lu: %.1f msg/s, %.1f stale skips/s, %u dropped",
+           entry.pgn, entry.stats.sent / elapsed_s,
+           entry.stats.stale_skipped / elapsed_s, entry.stats.queue_dropped);
+    entry.stats = {0, 0, 0};
+  }
+}
+
+}  // namespace halmet
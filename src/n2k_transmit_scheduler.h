@@ -0,0 +1,83 @@
+#ifndef HALMET_SRC_N2K_TRANSMIT_SCHEDULER_H_
+#define HALMET_SRC_N2K_TRANSMIT_SCHEDULER_H_
+
+#include <N2kMsg.h>
+
+#include <functional>
+#include <vector>
+
+#include "n2k_tx_queue.h"
+#include "transmit_plan.h"
+
+namespace halmet {
+
+/**
+ * @brief Transmits all periodic NMEA 2000 PGNs from a single timer.
+ *
+ * Senders register a message builder and a period instead of running their
+ * own repeat timers. When start() is called, each PGN gets a phase offset
+ * within its period so that transmissions are spread as evenly as possible
+ * over the scheduler ticks: a 100 ms and a 500 ms PGN no longer go out in
+ * the same tick every 500 ms. The timing itself is a TransmitPlan.
+ *
+ * A builder returns false when all of its inputs have expired. Such a PGN
+ * is then only sent on every stale_divider-th period as a heartbeat, or not
+ * at all if stale_divider is 0.
+ *
+ * Built messages are not sent directly but handed to a priority transmit
+ * queue, keyed by their scheduler entry, so a message that is still waiting
+ * when the next one of the same PGN is built gets replaced.
+ */
+class N2kTransmitScheduler {
+ public:
+  /// Fill in msg. Return false if none of the values are available.
+  using Builder = std::function<bool(tN2kMsg& msg)>;
+
+  struct Stats {
+    uint32_t sent;
+    uint32_t stale_skipped;
+    uint32_t queue_dropped;
+  };
+
+  N2kTransmitScheduler(N2kTxQueue* tx_queue, unsigned int tick_interval = 10,
+                       unsigned int report_interval = 60000);
+
+  /**
+   * @brief Register a periodic PGN.
+   *
+   * @param pgn PGN number, for reporting
+   * @param period Transmit interval, in ms
+   * @param builder Fills in the message to send
+   * @param tx_class Transmit queue priority class
+   * @param stale_divider Heartbeat divider while all inputs are expired
+   */
+  void add(unsigned long pgn, unsigned int period, Builder builder,
+           N2kTxClass tx_class, unsigned int stale_divider = 10);
+
+  /// Assign the phase offsets and start transmitting.
+  void start();
+
+ protected:
+  // Indexed like the plan's messages
+  struct Entry {
+    unsigned long pgn;
+    N2kTxClass tx_class;
+    Builder builder;
+    Stats stats;
+  };
+
+  void tick();
+  void report();
+
+  N2kTxQueue* tx_queue_;
+  unsigned int tick_interval_;
+  unsigned int report_interval_;
+  TransmitPlan plan_;
+  std::vector<Entry> entries_;
+  uint32_t tick_count_ = 0;
+  unsigned long last_report_ = 0;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_N2K_TRANSMIT_SCHEDULER_H_
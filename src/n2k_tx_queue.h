@@ -0,0 +1,15 @@
+#ifndef HALMET_SRC_N2K_TX_QUEUE_H_
+#define HALMET_SRC_N2K_TX_QUEUE_H_
+
+#include <N2kMsg.h>
+
+#include "priority_tx_queue.h"
+
+namespace halmet {
+
+/// Transmit queue for NMEA 2000 messages; see PriorityTxQueue.
+using N2kTxQueue = PriorityTxQueue<tN2kMsg>;
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_N2K_TX_QUEUE_H_
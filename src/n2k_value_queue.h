@@ -0,0 +1,81 @@
+#ifndef HALMET_SRC_N2K_VALUE_QUEUE_H_
+#define HALMET_SRC_N2K_VALUE_QUEUE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "spsc_queue.h"
+
+namespace halmet {
+
+/// A decoded value travelling from the NMEA 2000 task to the event loop.
+struct N2kValue {
+  uint16_t id;
+  float value;
+};
+
+/**
+ * @brief Hands decoded values from the NMEA 2000 task to the consumers
+ * bound to their IDs.
+ *
+ * The producer posts (ID, value) pairs into a bounded single-producer/
+ * single-consumer queue; the consumer side drains it and calls set() on
+ * the consumer bound to each ID. IDs are enum values, so they are fixed at
+ * compile time. Bindings live in a flat table indexed by ID that is filled
+ * at setup; after that, neither side allocates or builds strings.
+ *
+ * @tparam Consumer Anything with a set(float) method, typically a
+ * sensesp::ValueConsumer<float>
+ * @tparam N Queue capacity; must be a power of two
+ */
+template <typename Consumer, size_t N>
+class N2kValueQueue {
+ public:
+  /// Producer side. Returns false if the queue is full.
+  template <typename IdEnum>
+  bool post(IdEnum id, float value) {
+    static_assert(std::is_enum<IdEnum>::value, "Value IDs must be enums");
+    return queue_.push({static_cast<uint16_t>(id), value});
+  }
+
+  /// Deliver the values posted with id to consumer. Call before values are
+  /// posted.
+  template <typename IdEnum>
+  void bind(IdEnum id, Consumer* consumer) {
+    static_assert(std::is_enum<IdEnum>::value, "Value IDs must be enums");
+    size_t index = static_cast<uint16_t>(id);
+    if (bindings_.size() <= index) {
+      bindings_.resize(index + 1, nullptr);
+    }
+    bindings_[index] = consumer;
+  }
+
+  /// Consumer side: deliver all queued values.
+  void drain() {
+    N2kValue value;
+    while (queue_.pop(&value)) {
+      if (value.id < bindings_.size() && bindings_[value.id] != nullptr) {
+        bindings_[value.id]->set(value.value);
+      } else {
+        unbound_++;
+      }
+    }
+  }
+
+  size_t size() const { return queue_.size(); }
+  static constexpr size_t capacity() { return N; }
+  size_t get_high_water() const { return queue_.get_high_water(); }
+  uint32_t get_dropped() const { return queue_.get_dropped(); }
+  uint32_t get_unbound() const { return unbound_; }
+
+ private:
+  SpscQueue<N2kValue, N> queue_;
+  std::vector<Consumer*> bindings_;
+  uint32_t unbound_ = 0;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_N2K_VALUE_QUEUE_H_
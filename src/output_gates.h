@@ -0,0 +1,86 @@
+#ifndef HALMET_SRC_OUTPUT_GATES_H_
+#define HALMET_SRC_OUTPUT_GATES_H_
+
+// Framework-independent decisions behind RateLimiter and Deadband. Times
+// are in milliseconds, as returned by ClockMillis(), and may wrap.
+
+#include <cmath>
+#include <cstdint>
+
+namespace halmet {
+
+/// Passes at most one value per min_interval. The first value always
+/// passes.
+class MinIntervalGate {
+ public:
+  explicit MinIntervalGate(unsigned long min_interval)
+      : min_interval_{min_interval} {}
+
+  bool pass(unsigned long now) {
+    if (passed_before_ && now - last_passed_ < min_interval_) {
+      return false;
+    }
+    passed_before_ = true;
+    last_passed_ = now;
+    return true;
+  }
+
+ private:
+  unsigned long min_interval_;
+  bool passed_before_ = false;
+  unsigned long last_passed_ = 0;
+};
+
+/**
+ * @brief Report-by-exception decision.
+ *
+ * A value passes if it differs from the last value passed by more than the
+ * deadband, or if the heartbeat interval has passed since. Changes to or
+ * from NaN always pass.
+ */
+template <typename T>
+class DeadbandGate {
+ public:
+  DeadbandGate(T deadband, unsigned long heartbeat_interval)
+      : deadband_{deadband}, heartbeat_interval_{heartbeat_interval} {}
+
+  bool pass(T value, unsigned long now) {
+    bool changed = !passed_before_ ||
+                   std::isnan(value) != std::isnan(last_value_) ||
+                   std::abs(value - last_value_) > deadband_;
+    if (!changed && now - last_passed_ < heartbeat_interval_) {
+      suppressed_++;
+      return false;
+    }
+    passed_before_ = true;
+    last_value_ = value;
+    last_passed_ = now;
+    passed_++;
+    return true;
+  }
+
+  T get_deadband() const { return deadband_; }
+  void set_deadband(T deadband) { deadband_ = deadband; }
+  unsigned long get_heartbeat_interval() const { return heartbeat_interval_; }
+  void set_heartbeat_interval(unsigned long heartbeat_interval) {
+    heartbeat_interval_ = heartbeat_interval;
+  }
+
+  uint32_t get_passed() const { return passed_; }
+  uint32_t get_suppressed() const { return suppressed_; }
+
+ private:
+  T deadband_;
+  unsigned long heartbeat_interval_;
+
+  bool passed_before_ = false;
+  T last_value_{};
+  unsigned long last_passed_ = 0;
+
+  uint32_t passed_ = 0;
+  uint32_t suppressed_ = 0;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_OUTPUT_GATES_H_
@@ -0,0 +1,68 @@
+#ifndef HALMET_SRC_PACKED_FIELDS_H_
+#define HALMET_SRC_PACKED_FIELDS_H_
+
+// Framework-independent expiry rules of the packed value tables in the
+// NMEA 2000 senders. Times are in milliseconds and may wrap.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace halmet {
+
+/// True if a field stamped at last_update is no older than expiry. A field
+/// that was never stamped (0) is not fresh.
+inline bool IsFresh(unsigned long last_update, unsigned long now,
+                    unsigned long expiry) {
+  return last_update != 0 && now - last_update <= expiry;
+}
+
+/// True if at least one of count fields is fresh.
+inline bool AnyFresh(const unsigned long* last_updates, size_t count,
+                     unsigned long now, unsigned long expiry) {
+  for (size_t i = 0; i < count; i++) {
+    if (IsFresh(last_updates[i], now, expiry)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline void SetBit(uint32_t* bits, uint8_t bit, bool value) {
+  if (value) {
+    *bits |= 1UL << bit;
+  } else {
+    *bits &= ~(1UL << bit);
+  }
+}
+
+/// bits with every flag cleared whose update time in last_updates has
+/// expired.
+inline uint32_t FreshBits(uint32_t bits, const unsigned long* last_updates,
+                          size_t count, unsigned long now,
+                          unsigned long expiry) {
+  for (size_t bit = 0; bit < count; bit++) {
+    if (!IsFresh(last_updates[bit], now, expiry)) {
+      bits &= ~(1UL << bit);
+    }
+  }
+  return bits;
+}
+
+/// Engine discrete status 1 (PGN 127489) from status bits 0-15. Check
+/// Engine (bit 0) is set whenever any other flag is.
+inline uint16_t EngineStatus1(uint32_t bits) {
+  uint16_t status = static_cast<uint16_t>(bits & 0xFFFF);
+  if (status & ~1U) {
+    status |= 1;
+  }
+  return status;
+}
+
+/// Engine discrete status 2 (PGN 127489) from status bits 16-23.
+inline uint16_t EngineStatus2(uint32_t bits) {
+  return static_cast<uint16_t>((bits >> 16) & 0xFF);
+}
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_PACKED_FIELDS_H_
@@ -0,0 +1,33 @@
+#include "pgn_set.h"
+
+#include <algorithm>
+
+namespace halmet {
+
+bool PgnSet::insert(uint32_t pgn) {
+  auto it = std::lower_bound(pgns_.begin(), pgns_.end(), pgn);
+  if (it != pgns_.end() && *it == pgn) {
+    return false;
+  }
+  pgns_.insert(it, pgn);
+  filter_.set(filter_slot(pgn));
+  return true;
+}
+
+void PgnSet::clear() {
+  filter_.reset();
+  pgns_.clear();
+}
+
+int PgnSet::find(uint32_t pgn) const {
+  if (!filter_.test(filter_slot(pgn))) {
+    return -1;
+  }
+  auto it = std::lower_bound(pgns_.begin(), pgns_.end(), pgn);
+  if (it == pgns_.end() || *it != pgn) {
+    return -1;
+  }
+  return it - pgns_.begin();
+}
+
+}  // namespace halmet
@@ -0,0 +1,54 @@
+#ifndef HALMET_SRC_PGN_SET_H_
+#define HALMET_SRC_PGN_SET_H_
+
+// Framework-independent PGN lookup shared by the receive filter and the
+// dispatcher.
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace halmet {
+
+/**
+ * @brief Sorted set of PGNs with a hashed presence bitmap in front.
+ *
+ * A PGN that is not in the set is usually rejected with a single bitmap
+ * test. Otherwise it is looked up by binary search over the sorted list,
+ * so the cost of a lookup stays flat as PGNs are added.
+ */
+class PgnSet {
+ public:
+  /// Add pgn. Returns false if it was already in the set.
+  bool insert(uint32_t pgn);
+
+  void clear();
+
+  /// Index of pgn in get_pgns(), or -1.
+  int find(uint32_t pgn) const;
+
+  bool contains(uint32_t pgn) const { return find(pgn) >= 0; }
+
+  /// The sorted list of PGNs in the set.
+  const std::vector<uint32_t>& get_pgns() const { return pgns_; }
+
+  size_t size() const { return pgns_.size(); }
+
+  void shrink_to_fit() { pgns_.shrink_to_fit(); }
+
+ protected:
+  static const int kFilterBits = 1024;
+
+  // Fibonacci hash: the top 10 bits of pgn * 2^32 / phi
+  static uint32_t filter_slot(uint32_t pgn) {
+    return (pgn * 2654435761u) >> 22;
+  }
+
+  std::bitset<kFilterBits> filter_;
+  std::vector<uint32_t> pgns_;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_PGN_SET_H_
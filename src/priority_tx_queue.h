@@ -0,0 +1,233 @@
+#ifndef HALMET_SRC_PRIORITY_TX_QUEUE_H_
+#define HALMET_SRC_PRIORITY_TX_QUEUE_H_
+
+// Framework-independent core of N2kTxQueue. The message type is a template
+// parameter, so the queueing rules can be tested on the host without the
+// NMEA 2000 library.
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "halmet_clock.h"
+
+namespace halmet {
+
+/// Transmit priority classes, highest priority first.
+enum class N2kTxClass : uint8_t { kRapid, kDynamic, kSlow };
+
+const int kNumN2kTxClasses = 3;
+
+/**
+ * @brief Bounded transmit queue with priority classes and coalescing.
+ *
+ * Messages are dequeued highest class first, oldest first within a class.
+ * Each message carries a key identifying the stream it belongs to (for
+ * example one periodic PGN of one sender). Enqueueing a message whose key
+ * is already pending replaces the pending message in place, so a congested
+ * bus never carries superseded values.
+ *
+ * When the queue is full, the oldest message of the lowest class below the
+ * new message's class is evicted. If there is none, the new message is
+ * dropped.
+ *
+ * The queue is safe to use from two tasks: typically the event loop
+ * enqueues and the NMEA 2000 task dequeues and sends.
+ *
+ * @tparam Message Copyable message type
+ */
+template <typename Message>
+class PriorityTxQueue {
+ public:
+  struct ClassStats {
+    uint32_t enqueued;
+    uint32_t coalesced;
+    uint32_t dropped;
+    uint32_t sent;
+    uint32_t max_latency_ms;
+  };
+
+  explicit PriorityTxQueue(size_t capacity = 16) : slots_(capacity) {
+    for (auto& slot : slots_) {
+      slot.used = false;
+    }
+  }
+
+  /// Queue a message. Returns false if the message was dropped.
+  bool enqueue(const Message& msg, N2kTxClass tx_class, uint32_t key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ClassStats& stats = stats_[static_cast<int>(tx_class)];
+    stats.enqueued++;
+
+    // A pending message of the same stream is superseded: replace it, but
+    // keep its place in the queue
+    int index = find_key(key);
+    if (index >= 0) {
+      Slot& slot = slots_[index];
+      stats_[static_cast<int>(slot.tx_class)].coalesced++;
+      slot.tx_class = tx_class;
+      slot.msg = msg;
+      return true;
+    }
+
+    // Find a free slot, or else the oldest message of the lowest class
+    // below the new one
+    int victim = -1;
+    for (size_t i = 0; i < slots_.size(); i++) {
+      const Slot& slot = slots_[i];
+      if (!slot.used) {
+        victim = i;
+        break;
+      }
+      if (slot.tx_class <= tx_class) {
+        continue;
+      }
+      if (victim < 0 || slot.tx_class > slots_[victim].tx_class ||
+          (slot.tx_class == slots_[victim].tx_class &&
+           static_cast<int32_t>(slot.sequence - slots_[victim].sequence) <
+               0)) {
+        victim = i;
+      }
+    }
+    if (victim < 0) {
+      stats.dropped++;
+      return false;
+    }
+
+    Slot& slot = slots_[victim];
+    if (slot.used) {
+      stats_[static_cast<int>(slot.tx_class)].dropped++;
+    }
+    slot.used = true;
+    slot.tx_class = tx_class;
+    slot.key = key;
+    slot.sequence = next_sequence_++;
+    slot.enqueue_time = ClockMillis();
+    slot.msg = msg;
+    return true;
+  }
+
+  /**
+   * @brief Send queued messages in priority order.
+   *
+   * @param send Attempts to send a message; returns false if the driver has
+   *   no room for it, in which case the message stays queued
+   * @return Number of messages sent
+   */
+  template <typename SendFunction>
+  int drain(SendFunction send) {
+    int sent = 0;
+    Slot slot;
+    while (take_next(&slot)) {
+      if (!send(slot.msg)) {
+        put_back(slot);
+        break;
+      }
+      record_sent(slot);
+      sent++;
+    }
+    return sent;
+  }
+
+  ClassStats get_stats(N2kTxClass tx_class) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_[static_cast<int>(tx_class)];
+  }
+
+  void clear_stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& stats : stats_) {
+      stats = {0, 0, 0, 0, 0};
+    }
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t used = 0;
+    for (const auto& slot : slots_) {
+      used += slot.used;
+    }
+    return used;
+  }
+
+ protected:
+  struct Slot {
+    bool used;
+    N2kTxClass tx_class;
+    uint32_t key;
+    uint32_t sequence;
+    unsigned long enqueue_time;
+    Message msg;
+  };
+
+  bool take_next(Slot* slot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int next = -1;
+    for (size_t i = 0; i < slots_.size(); i++) {
+      const Slot& candidate = slots_[i];
+      if (!candidate.used) {
+        continue;
+      }
+      if (next < 0 || candidate.tx_class < slots_[next].tx_class ||
+          (candidate.tx_class == slots_[next].tx_class &&
+           static_cast<int32_t>(candidate.sequence - slots_[next].sequence) <
+               0)) {
+        next = i;
+      }
+    }
+    if (next < 0) {
+      return false;
+    }
+    *slot = slots_[next];
+    slots_[next].used = false;
+    return true;
+  }
+
+  void put_back(const Slot& slot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // A newer message of the same stream was queued while this one was out
+    if (find_key(slot.key) >= 0) {
+      stats_[static_cast<int>(slot.tx_class)].coalesced++;
+      return;
+    }
+    // The slot we took it from may have been reused; any free slot will
+    // do, since the sequence number keeps its place in the queue
+    for (auto& free_slot : slots_) {
+      if (!free_slot.used) {
+        free_slot = slot;
+        return;
+      }
+    }
+    stats_[static_cast<int>(slot.tx_class)].dropped++;
+  }
+
+  void record_sent(const Slot& slot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ClassStats& stats = stats_[static_cast<int>(slot.tx_class)];
+    stats.sent++;
+    uint32_t latency = ClockMillis() - slot.enqueue_time;
+    if (latency > stats.max_latency_ms) {
+      stats.max_latency_ms = latency;
+    }
+  }
+
+  // Index of the pending slot with the given key, or -1
+  int find_key(uint32_t key) const {
+    for (size_t i = 0; i < slots_.size(); i++) {
+      if (slots_[i].used && slots_[i].key == key) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  std::mutex mutex_;
+  std::vector<Slot> slots_;
+  uint32_t next_sequence_ = 0;
+  ClassStats stats_[kNumN2kTxClasses] = {};
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_PRIORITY_TX_QUEUE_H_
@@ -1,6 +1,8 @@
 #ifndef HALMET_SRC_RATE_LIMITER_H_
 #define HALMET_SRC_RATE_LIMITER_H_
 
+#include "halmet_clock.h"
+#include "output_gates.h"
 #include "sensesp/transforms/transform.h"
 
 namespace sensesp {
@@ -14,21 +16,82 @@ template <typename T>
 class RateLimiter : public Transform<T, T> {
  public:
   RateLimiter(unsigned int min_delay_ms, String config_path = "")
-      : Transform<T, T>(config_path), min_delay_ms_{min_delay_ms} {}
+      : Transform<T, T>(config_path), gate_{min_delay_ms} {}
 
-  virtual void set_input(T input, uint8_t input_channel = 0) override {
-    unsigned long current_time = millis();
-    if (current_time - last_output_time_ > min_delay_ms_) {
+  virtual void set(const T& input) override {
+    if (gate_.pass(halmet::ClockMillis())) {
       this->emit(input);
-      last_output_time_ = current_time;
     }
   }
 
  private:
-  unsigned int min_delay_ms_;
-  unsigned long last_output_time_ = 0;
+  halmet::MinIntervalGate gate_;
 };
 
+/**
+ * @brief Report-by-exception transform.
+ *
+ * A value is passed on only if it differs from the last value passed on by
+ * more than the deadband, or if the heartbeat interval has passed since;
+ * see halmet::DeadbandGate. Counts of passed and suppressed values are
+ * shown in the configuration.
+ *
+ * @tparam T Numeric type
+ */
+template <typename T>
+class Deadband : public Transform<T, T> {
+ public:
+  Deadband(T deadband, unsigned int heartbeat_interval,
+           String config_path = "")
+      : Transform<T, T>(config_path), gate_{deadband, heartbeat_interval} {
+    this->load();
+  }
+
+  virtual void set(const T& input) override {
+    if (gate_.pass(input, halmet::ClockMillis())) {
+      this->emit(input);
+    }
+  }
+
+  uint32_t get_sent() const { return gate_.get_passed(); }
+  uint32_t get_suppressed() const { return gate_.get_suppressed(); }
+
+  virtual bool to_json(JsonObject& root) override {
+    root["deadband"] = gate_.get_deadband();
+    root["heartbeat_interval"] = gate_.get_heartbeat_interval();
+    root["sent"] = gate_.get_passed();
+    root["suppressed"] = gate_.get_suppressed();
+    return true;
+  }
+
+  virtual bool from_json(const JsonObject& config) override {
+    if (config["deadband"].is<T>()) {
+      gate_.set_deadband(config["deadband"].as<T>());
+    }
+    if (config["heartbeat_interval"].is<unsigned int>()) {
+      gate_.set_heartbeat_interval(
+          config["heartbeat_interval"].as<unsigned int>());
+    }
+    return true;
+  }
+
+ protected:
+  halmet::DeadbandGate<T> gate_;
+};
+
+template <typename T>
+const String ConfigSchema(const Deadband<T>& obj) {
+  return R"###({
+    "type": "object",
+    "properties": {
+      "deadband": { "title": "Deadband", "type": "number", "description": "Send a new value only if it differs from the last one sent by more than this" },
+      "heartbeat_interval": { "title": "Heartbeat interval", "type": "integer", "description": "Send the value anyway after this many milliseconds" },
+      "sent": { "title": "Values sent", "type": "integer", "readOnly": true },
+      "suppressed": { "title": "Values suppressed", "type": "integer", "readOnly": true }
+    }
+  })###";
+}
+
 }  // namespace sensesp
 
 #endif /* HALMET_SRC_RATE_LIMITER_H_ */
@@ -0,0 +1,264 @@
+#include "sk_backlog.h"
+
+#include <cstring>
+
+namespace halmet {
+
+static size_t WriteVarint(uint8_t* p, uint32_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    p[n++] = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  p[n++] = static_cast<uint8_t>(value);
+  return n;
+}
+
+static bool ReadVarint(const uint8_t* data, size_t len, size_t* pos,
+                       uint32_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 35 && *pos < len; shift += 7) {
+    uint8_t byte = data[(*pos)++];
+    *value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void WriteLE(uint8_t* p, uint64_t value, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    p[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+static uint64_t ReadLE(const uint8_t* p, size_t len) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < len; i++) {
+    value |= static_cast<uint64_t>(p[i]) << (8 * i);
+  }
+  return value;
+}
+
+SKBacklog::SKBacklog(FlashLog* log, SKDeltaWriter* writer)
+    : log_{log}, writer_{writer} {}
+
+void SKBacklog::begin(uint32_t layout) {
+  layout_ = layout;
+  previous_.assign(writer_->get_path_count(), 0);
+
+  // The newest marker tells where the replay stopped. Without one,
+  // everything in the log is new.
+  replay_from_ = 0;
+  block_sent_ = 0;
+  FlashLog::Cursor cursor = log_->oldest();
+  uint8_t record[FlashLog::kMaxPayload];
+  size_t len;
+  uint32_t sequence;
+  bool found = false;
+  uint32_t oldest = 0;
+  while (log_->read_next(&cursor, record, sizeof(record), &len, &sequence)) {
+    if (!found) {
+      found = true;
+      oldest = sequence;
+      replay_from_ = oldest;
+    }
+    if (len >= 5 && record[0] == kReplayed) {
+      replay_from_ = ReadLE(record + 1, 4);
+      // Markers without the count are from before it was recorded
+      block_sent_ = len >= kMarkerSize ? ReadLE(record + 5, 2) : 0;
+    }
+  }
+  if (found && static_cast<int32_t>(replay_from_ - oldest) < 0) {
+    // The partly sent block has been overwritten
+    replay_from_ = oldest;
+    block_sent_ = 0;
+  }
+}
+
+void SKBacklog::start_block(uint64_t timestamp_ms) {
+  block_[0] = kBlock;
+  WriteLE(block_ + 1, layout_, 4);
+  WriteLE(block_ + 5, timestamp_ms, 8);
+  block_len_ = kBlockHeader;
+  block_start_ = timestamp_ms;
+  last_timestamp_ = timestamp_ms;
+  previous_.assign(previous_.size(), 0);
+}
+
+void SKBacklog::record(SKDeltaWriter::PathId id, float value,
+                       uint64_t timestamp_ms) {
+  if (replaying_) {
+    // Lost the connection during the replay
+    mark_replayed(false);
+    replaying_ = false;
+  }
+  if (id >= previous_.size()) {
+    return;
+  }
+  if (block_len_ > 0 &&
+      (timestamp_ms < last_timestamp_ ||
+       timestamp_ms - last_timestamp_ > UINT32_MAX ||
+       block_len_ + kMaxSample > sizeof(block_))) {
+    flush();
+  }
+  if (block_len_ == 0) {
+    start_block(timestamp_ms);
+  }
+
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  int32_t diff = static_cast<int32_t>(bits - previous_[id]);
+  uint32_t zigzag = (static_cast<uint32_t>(diff) << 1) ^
+                    static_cast<uint32_t>(diff >> 31);
+  block_len_ += WriteVarint(block_ + block_len_, id);
+  block_len_ +=
+      WriteVarint(block_ + block_len_, timestamp_ms - last_timestamp_);
+  block_len_ += WriteVarint(block_ + block_len_, zigzag);
+  previous_[id] = bits;
+  last_timestamp_ = timestamp_ms;
+  stats_.recorded++;
+}
+
+void SKBacklog::flush() {
+  if (block_len_ == 0) {
+    return;
+  }
+  if (log_->append(block_, block_len_)) {
+    stats_.blocks++;
+  }
+  block_len_ = 0;
+}
+
+void SKBacklog::flush_if_older(uint64_t now_ms, uint32_t max_age_ms) {
+  if (block_len_ > 0 && now_ms - block_start_ >= max_age_ms) {
+    flush();
+  }
+}
+
+void SKBacklog::mark_replayed(bool complete) {
+  if (replay_marked_) {
+    return;
+  }
+  if (complete) {
+    // Covers the marker itself
+    replay_from_ = log_->get_next_sequence() + 1;
+    block_sent_ = 0;
+  }
+  uint8_t marker[kMarkerSize];
+  marker[0] = kReplayed;
+  WriteLE(marker + 1, replay_from_, 4);
+  WriteLE(marker + 5, block_sent_, 2);
+  log_->append(marker, sizeof(marker));
+  replay_marked_ = true;
+}
+
+bool SKBacklog::send_block(const uint8_t* block, size_t len,
+                           const SendCallback& send) {
+  if (ReadLE(block + 1, 4) != layout_) {
+    stats_.skipped++;
+    return true;
+  }
+  uint64_t timestamp = ReadLE(block + 5, 8);
+  previous_.assign(previous_.size(), 0);
+  // Sent by an earlier attempt; decoded for their deltas only
+  uint32_t skip = block_sent_;
+  uint32_t index = 0;
+
+  auto send_delta = [&]() {
+    size_t values = writer_->get_value_count();
+    size_t delta_len;
+    const char* delta = writer_->finish(&delta_len);
+    if (!send(delta, delta_len)) {
+      return false;
+    }
+    block_sent_ += values;
+    replay_marked_ = false;
+    return true;
+  };
+
+  writer_->begin();
+  bool in_update = false;
+  uint64_t update_timestamp = 0;
+  size_t pos = kBlockHeader;
+  while (pos < len) {
+    uint32_t id, elapsed, zigzag;
+    if (!ReadVarint(block, len, &pos, &id) ||
+        !ReadVarint(block, len, &pos, &elapsed) ||
+        !ReadVarint(block, len, &pos, &zigzag)) {
+      break;
+    }
+    timestamp += elapsed;
+    if (id >= previous_.size()) {
+      break;
+    }
+    int32_t diff = static_cast<int32_t>(zigzag >> 1) ^
+                   -static_cast<int32_t>(zigzag & 1);
+    uint32_t bits = previous_[id] + static_cast<uint32_t>(diff);
+    previous_[id] = bits;
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    if (index++ < skip) {
+      continue;
+    }
+
+    // One update per timestamp; a full delta is sent and a new one started
+    bool added = (in_update && timestamp == update_timestamp) ||
+                 writer_->begin_update(timestamp);
+    added = added && writer_->add_value(id, value);
+    if (!added) {
+      if (!send_delta()) {
+        return false;
+      }
+      writer_->begin();
+      writer_->begin_update(timestamp);
+      writer_->add_value(id, value);
+    }
+    in_update = true;
+    update_timestamp = timestamp;
+  }
+  return writer_->get_value_count() == 0 || send_delta();
+}
+
+bool SKBacklog::replay_step(const SendCallback& send) {
+  if (!replaying_) {
+    flush();
+    if (!has_backlog()) {
+      return false;
+    }
+    cursor_ = log_->oldest();
+    replaying_ = true;
+  }
+
+  uint8_t block[FlashLog::kMaxPayload];
+  size_t len;
+  uint32_t sequence;
+  while (log_->read_next(&cursor_, block, sizeof(block), &len, &sequence)) {
+    if (static_cast<int32_t>(sequence - replay_from_) < 0 ||
+        len < kBlockHeader || block[0] != kBlock) {
+      continue;
+    }
+    bool sent = send_block(block, len, send);
+    writer_->begin();
+    if (!sent) {
+      // block_sent_ counts the values of this block
+      replay_from_ = sequence;
+      mark_replayed(false);
+      replaying_ = false;
+      return false;
+    }
+    replay_from_ = sequence + 1;
+    block_sent_ = 0;
+    replay_marked_ = false;
+    stats_.replayed++;
+    return true;
+  }
+
+  replaying_ = false;
+  replay_marked_ = false;
+  mark_replayed(true);
+  return false;
+}
+
+}  // namespace halmet
@@ -0,0 +1,140 @@
+#ifndef HALMET_SRC_SK_BACKLOG_H_
+#define HALMET_SRC_SK_BACKLOG_H_
+
+// Store-and-forward log of Signal K values on a FlashLog. Framework
+// independent: on the host, it runs on RamFlashStorage.
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "flash_log.h"
+#include "sk_delta_writer.h"
+
+namespace halmet {
+
+/**
+ * @brief Signal K values recorded while the server is unreachable.
+ *
+ * Values are collected in a block in RAM and written to the log as one
+ * record when the block is full or old enough, so the flash is written in
+ * record-sized pieces no matter how fast values arrive, and each sector is
+ * erased once per trip around the ring. When the ring is full, the oldest
+ * values are lost.
+ *
+ * Within a block, each sample is the output ID, the time since the previous
+ * sample and the difference of the float bit pattern to the previous value
+ * of the same output, all as varints. A slowly changing value thus takes
+ * three or four bytes.
+ *
+ * Once the connection is back, replay_step() sends one block at a time as
+ * deltas with the original timestamps. A block can take several deltas;
+ * the number of its values already sent is kept, so after another outage
+ * during the replay, the replay resumes with the first delta that wasn't
+ * sent. The progress is written to the log as a marker when the replay
+ * stops or completes, so it also survives a restart after that. If the
+ * device resets during the replay before a marker is written, the blocks
+ * since the last marker are sent again. A delta counts as sent once send
+ * returns true.
+ *
+ * Blocks are tagged with the output layout: a hash of the registered
+ * paths. Blocks recorded by firmware with other outputs are skipped, as
+ * their IDs would map to the wrong paths.
+ */
+class SKBacklog {
+ public:
+  /// Sends a delta. Returns false if it couldn't be sent.
+  using SendCallback = std::function<bool(const char* delta, size_t len)>;
+
+  struct Stats {
+    uint32_t recorded;
+    uint32_t blocks;
+    // Blocks sent or skipped
+    uint32_t replayed;
+    // Blocks skipped because of a different output layout
+    uint32_t skipped;
+  };
+
+  /**
+   * @param log Log to record to, on its own storage
+   * @param writer Writer with the output paths registered, used for the
+   *   replay only
+   */
+  SKBacklog(FlashLog* log, SKDeltaWriter* writer);
+
+  /**
+   * @brief Find what hasn't been replayed yet. Call once, after log->begin()
+   * and once all paths are registered.
+   *
+   * @param layout Hash of the registered output paths
+   */
+  void begin(uint32_t layout);
+
+  void record(SKDeltaWriter::PathId id, float value, uint64_t timestamp_ms);
+
+  /// Write the open block.
+  void flush();
+  /// Write the open block if its first sample is older than max_age_ms.
+  void flush_if_older(uint64_t now_ms, uint32_t max_age_ms);
+
+  /// Anything left to replay.
+  bool has_backlog() const {
+    return static_cast<int32_t>(log_->get_next_sequence() - replay_from_) >
+               0 ||
+           block_len_ > 0;
+  }
+
+  /**
+   * @brief Send the next block.
+   *
+   * @return false if there is nothing left or send failed
+   */
+  bool replay_step(const SendCallback& send);
+
+  const Stats& get_stats() const { return stats_; }
+  void clear_stats() { stats_ = {}; }
+
+ protected:
+  enum RecordType : uint8_t { kBlock = 1, kReplayed = 2 };
+
+  static const size_t kBlockHeader = 13;
+  // Largest encoded sample: 3 + 5 + 5 bytes of varints
+  static const size_t kMaxSample = 13;
+
+  // Marker: type, replay_from_, block_sent_
+  static const size_t kMarkerSize = 7;
+
+  void start_block(uint64_t timestamp_ms);
+  bool send_block(const uint8_t* block, size_t len,
+                  const SendCallback& send);
+  // Record that everything before replay_from_ and the first block_sent_
+  // values of block replay_from_ have been sent, or everything in the log
+  // if complete
+  void mark_replayed(bool complete);
+
+  FlashLog* log_;
+  SKDeltaWriter* writer_;
+  uint32_t layout_ = 0;
+
+  uint8_t block_[FlashLog::kMaxPayload];
+  size_t block_len_ = 0;
+  uint64_t block_start_ = 0;
+  uint64_t last_timestamp_ = 0;
+  // Previous value bits per output, for the open block
+  std::vector<uint32_t> previous_;
+
+  // Sequence of the first record not replayed yet
+  uint32_t replay_from_ = 0;
+  // Values of that record sent by an earlier, interrupted attempt
+  uint32_t block_sent_ = 0;
+  bool replay_marked_ = true;
+  bool replaying_ = false;
+  FlashLog::Cursor cursor_ = {};
+
+  Stats stats_ = {};
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_SK_BACKLOG_H_
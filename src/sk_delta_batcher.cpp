@@ -0,0 +1,78 @@
+#include "sk_delta_batcher.h"
+
+#include "sensesp_base_app.h"
+
+namespace halmet {
+
+SKDeltaBatcher* sk_delta_batcher() {
+  static SKDeltaBatcher* batcher =
+      new SKDeltaBatcher(200, 60000, "/Signal K/Batch Window");
+  return batcher;
+}
+
+SKDeltaBatcher::SKDeltaBatcher(unsigned int window,
+                               unsigned int report_interval,
+                               String config_path)
+    : sensesp::FileSystemSaveable(config_path), window_{window} {
+  load();
+  window_start_ = millis();
+  sensesp::event_loop()->onRepeat(kPollInterval, [this]() {
+    unsigned long now = millis();
+    if (now - window_start_ >= window_) {
+      window_start_ = now;
+      this->flush();
+    }
+  });
+  if (report_interval > 0) {
+    sensesp::event_loop()->onRepeat(report_interval,
+                                    [this]() { this->report(); });
+  }
+}
+
+void SKDeltaBatcher::add_pending(BatchedValueBase* value) {
+  pending_.push_back(value);
+}
+
+void SKDeltaBatcher::flush() {
+  if (pending_.empty()) {
+    return;
+  }
+  stats_.windows++;
+  stats_.values_out += pending_.size();
+  if (pending_.size() > stats_.max_values_per_window) {
+    stats_.max_values_per_window = pending_.size();
+  }
+  // Values set while flushing go into the next window
+  flushing_.swap(pending_);
+  for (auto value : flushing_) {
+    value->flush();
+  }
+  flushing_.clear();
+}
+
+void SKDeltaBatcher::report() {
+  debugI("SK batching: %u windows, %u values in, %u sent, max %u per window",
+         stats_.windows, stats_.values_in, stats_.values_out,
+         stats_.max_values_per_window);
+  clear_stats();
+}
+
+bool SKDeltaBatcher::to_json(JsonObject& root) {
+  root["window"] = window_;
+  return true;
+}
+
+bool SKDeltaBatcher::from_json(const JsonObject& config) {
+  if (config["window"].is<int>()) {
+    int window = config["window"];
+    if (window < static_cast<int>(kMinWindow)) {
+      window = kMinWindow;
+    } else if (window > static_cast<int>(kMaxWindow)) {
+      window = kMaxWindow;
+    }
+    window_ = window;
+  }
+  return true;
+}
+
+}  // namespace halmet
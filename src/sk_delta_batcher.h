@@ -0,0 +1,147 @@
+#ifndef HALMET_SRC_SK_DELTA_BATCHER_H_
+#define HALMET_SRC_SK_DELTA_BATCHER_H_
+
+#include <vector>
+
+#include "sensesp/system/saveable.h"
+#include "sensesp/system/valueconsumer.h"
+#include "sensesp/transforms/transform.h"
+
+namespace halmet {
+
+class SKDeltaBatcher;
+
+/// Value held back by an SKDeltaBatcher until the end of the window.
+class BatchedValueBase {
+ public:
+  virtual ~BatchedValueBase() {}
+  virtual void flush() = 0;
+};
+
+/**
+ * @brief Collects Signal K output values into windows of fixed length.
+ *
+ * Every value that is passed through a BatchedValue is held until the end
+ * of the current window. All values changed in the window are then emitted
+ * together from one event loop callback, so they end up in the same delta
+ * queue flush and go out as one multi-value delta in one websocket frame.
+ * If an output gets several values within one window, only the last one is
+ * sent.
+ *
+ * The window length is configurable between kMinWindow and kMaxWindow.
+ * Alarms and other outputs whose latency matters should not be batched.
+ *
+ * Use sk_delta_batcher() for the shared instance and Batched() to put an
+ * output behind it.
+ */
+class SKDeltaBatcher : public sensesp::FileSystemSaveable {
+ public:
+  struct Stats {
+    // Windows in which at least one value was sent
+    uint32_t windows;
+    uint32_t values_in;
+    uint32_t values_out;
+    uint32_t max_values_per_window;
+  };
+
+  // Limits of the configured window
+  static const unsigned int kMinWindow = 100;  // ms
+  static const unsigned int kMaxWindow = 250;  // ms
+
+  SKDeltaBatcher(unsigned int window = 200,
+                 unsigned int report_interval = 60000,
+                 String config_path = "");
+
+  /// Window length in ms. Zero passes all values through immediately.
+  void set_window(unsigned int window) { window_ = window; }
+  unsigned int get_window() const { return window_; }
+
+  void add_pending(BatchedValueBase* value);
+  void count_input() { stats_.values_in++; }
+
+  const Stats& get_stats() const { return stats_; }
+  void clear_stats() { stats_ = {}; }
+
+  virtual bool to_json(JsonObject& root) override;
+  virtual bool from_json(const JsonObject& config) override;
+
+ protected:
+  // Polled at a fine grain, so the window can be changed at any time
+  static const unsigned int kPollInterval = 10;  // ms
+
+  void flush();
+  void report();
+
+  unsigned int window_;
+  unsigned long window_start_ = 0;
+  std::vector<BatchedValueBase*> pending_;
+  // Swapped with pending_ while flushing, to keep both allocations
+  std::vector<BatchedValueBase*> flushing_;
+  Stats stats_ = {};
+};
+
+inline const String ConfigSchema(const SKDeltaBatcher& obj) {
+  return R"###({
+    "type": "object",
+    "properties": {
+      "window": { "title": "Window", "type": "integer", "minimum": 100, "maximum": 250, "description": "Signal K values that change within this time are sent together in one delta, in ms (100 to 250)" }
+    }
+  })###";
+}
+
+inline bool ConfigRequiresRestart(const SKDeltaBatcher& obj) {
+  return false;
+}
+
+/// Shared batcher for all Signal K outputs, configured at
+/// "/Signal K/Batch Window".
+SKDeltaBatcher* sk_delta_batcher();
+
+/**
+ * @brief Transform that holds its input until the batcher's window ends.
+ */
+template <typename T>
+class BatchedValue : public sensesp::SymmetricTransform<T>,
+                     public BatchedValueBase {
+ public:
+  explicit BatchedValue(SKDeltaBatcher* batcher) : batcher_{batcher} {}
+
+  virtual void set(const T& value) override {
+    batcher_->count_input();
+    value_ = value;
+    if (batcher_->get_window() == 0) {
+      flush();
+      return;
+    }
+    if (!pending_) {
+      pending_ = true;
+      batcher_->add_pending(this);
+    }
+  }
+
+  virtual void flush() override {
+    pending_ = false;
+    this->emit(value_);
+  }
+
+ protected:
+  SKDeltaBatcher* batcher_;
+  T value_{};
+  bool pending_ = false;
+};
+
+/**
+ * @brief Put output behind the shared batcher.
+ *
+ * @return The consumer to connect the output's producer to
+ */
+template <typename T>
+sensesp::ValueConsumer<T>* Batched(sensesp::ValueConsumer<T>* output) {
+  auto batched = new BatchedValue<T>(sk_delta_batcher());
+  batched->connect_to(output);
+  return batched;
+}
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_SK_DELTA_BATCHER_H_
@@ -0,0 +1,225 @@
+#include "sk_delta_writer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace halmet {
+
+static const char kDeltaStart[] = "{\"updates\":[";
+static const char kDeltaEnd[] = "]}";
+static const char kUpdateEnd[] = "]}";
+static const char kTimestampStart[] = "{\"timestamp\":\"";
+static const char kTimestampEnd[] = "\",\"values\":[";
+static const char kValuesStart[] = "{\"values\":[";
+
+static const uint64_t kPow10[] = {1,         10,         100,
+                                  1000,      10000,      100000,
+                                  1000000,   10000000,   100000000,
+                                  1000000000};
+
+// Write value with exactly width digits, or all its digits if width is 0
+static char* WriteDigits(char* p, uint64_t value, int width) {
+  char digits[20];
+  int n = 0;
+  do {
+    digits[n++] = '0' + value % 10;
+    value /= 10;
+  } while (value > 0 || n < width);
+  while (n > 0) {
+    *p++ = digits[--n];
+  }
+  return p;
+}
+
+size_t FormatSKNumber(float value, char* buf) {
+  if (!std::isfinite(value)) {
+    memcpy(buf, "null", 4);
+    return 4;
+  }
+  char* p = buf;
+  double v = value;
+  if (v < 0) {
+    *p++ = '-';
+    v = -v;
+  }
+  if (v >= 1e9 || (v != 0 && v < 1e-4)) {
+    // Out of the fixed point range; rare enough for snprintf
+    return (p - buf) + snprintf(p, 20, "%.6g", v);
+  }
+
+  // Six significant digits: a float carries a little more than that
+  int decimals = 5;
+  for (double limit = 10; v >= limit; limit *= 10) {
+    decimals--;
+  }
+  if (v != 0) {
+    for (double scaled = v; scaled < 1 && decimals < 9; scaled *= 10) {
+      decimals++;
+    }
+  }
+  if (decimals < 0) {
+    decimals = 0;
+  }
+
+  uint64_t scaled = static_cast<uint64_t>(v * kPow10[decimals] + 0.5);
+  uint64_t integer = scaled / kPow10[decimals];
+  uint64_t fraction = scaled % kPow10[decimals];
+  p = WriteDigits(p, integer, 0);
+  if (fraction != 0) {
+    while (fraction % 10 == 0) {
+      fraction /= 10;
+      decimals--;
+    }
+    *p++ = '.';
+    p = WriteDigits(p, fraction, decimals);
+  }
+  return p - buf;
+}
+
+size_t FormatSKTimestamp(uint64_t timestamp_ms, char* buf) {
+  uint64_t seconds = timestamp_ms / 1000;
+  int64_t days = seconds / 86400;
+  uint32_t second_of_day = seconds % 86400;
+
+  // Civil date from days since 1970-01-01 (Howard Hinnant's algorithm)
+  days += 719468;
+  int64_t era = days / 146097;
+  uint32_t day_of_era = days - era * 146097;
+  uint32_t year_of_era = (day_of_era - day_of_era / 1460 +
+                          day_of_era / 36524 - day_of_era / 146096) /
+                         365;
+  uint32_t day_of_year =
+      day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  uint32_t mp = (5 * day_of_year + 2) / 153;
+  uint32_t day = day_of_year - (153 * mp + 2) / 5 + 1;
+  uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+  uint64_t year = year_of_era + era * 400 + (month <= 2);
+
+  char* p = buf;
+  p = WriteDigits(p, year, 4);
+  *p++ = '-';
+  p = WriteDigits(p, month, 2);
+  *p++ = '-';
+  p = WriteDigits(p, day, 2);
+  *p++ = 'T';
+  p = WriteDigits(p, second_of_day / 3600, 2);
+  *p++ = ':';
+  p = WriteDigits(p, second_of_day / 60 % 60, 2);
+  *p++ = ':';
+  p = WriteDigits(p, second_of_day % 60, 2);
+  *p++ = '.';
+  p = WriteDigits(p, timestamp_ms % 1000, 3);
+  *p++ = 'Z';
+  return p - buf;
+}
+
+SKDeltaWriter::SKDeltaWriter(size_t capacity)
+    : buffer_(capacity), fragment_offsets_{0} {
+  begin();
+}
+
+SKDeltaWriter::PathId SKDeltaWriter::add_path(const char* path) {
+  static const char kPathStart[] = "{\"path\":\"";
+  static const char kPathEnd[] = "\",\"value\":";
+  fragments_.insert(fragments_.end(), kPathStart,
+                    kPathStart + sizeof(kPathStart) - 1);
+  // Signal K paths are plain identifiers; drop anything that would need
+  // escaping
+  for (const char* c = path; *c != '\0'; c++) {
+    if (*c != '"' && *c != '\\' && *c >= ' ') {
+      fragments_.push_back(*c);
+    }
+  }
+  fragments_.insert(fragments_.end(), kPathEnd,
+                    kPathEnd + sizeof(kPathEnd) - 1);
+  fragment_offsets_.push_back(fragments_.size());
+  return get_path_count() - 1;
+}
+
+bool SKDeltaWriter::append(const char* data, size_t len) {
+  if (pos_ + len + kClosing > buffer_.size()) {
+    return false;
+  }
+  memcpy(&buffer_[pos_], data, len);
+  pos_ += len;
+  return true;
+}
+
+void SKDeltaWriter::begin() {
+  pos_ = 0;
+  updates_ = 0;
+  values_ = 0;
+  update_values_ = 0;
+  in_update_ = false;
+  append(kDeltaStart, sizeof(kDeltaStart) - 1);
+}
+
+bool SKDeltaWriter::begin_update(uint64_t timestamp_ms) {
+  size_t start = pos_;
+  bool ok = true;
+  if (in_update_) {
+    ok = append(kUpdateEnd, sizeof(kUpdateEnd) - 1);
+  }
+  if (ok && updates_ > 0) {
+    ok = append(",", 1);
+  }
+  if (ok && timestamp_ms != 0) {
+    char timestamp[28];
+    size_t len = FormatSKTimestamp(timestamp_ms, timestamp);
+    ok = append(kTimestampStart, sizeof(kTimestampStart) - 1) &&
+         append(timestamp, len) &&
+         append(kTimestampEnd, sizeof(kTimestampEnd) - 1);
+  } else if (ok) {
+    ok = append(kValuesStart, sizeof(kValuesStart) - 1);
+  }
+  if (!ok) {
+    pos_ = start;
+    return false;
+  }
+  in_update_ = true;
+  updates_++;
+  update_values_ = 0;
+  return true;
+}
+
+bool SKDeltaWriter::add_value(PathId id, float value) {
+  if (id >= get_path_count()) {
+    return false;
+  }
+  if (!in_update_ && !begin_update()) {
+    return false;
+  }
+  const char* fragment = &fragments_[fragment_offsets_[id]];
+  size_t fragment_len = fragment_offsets_[id + 1] - fragment_offsets_[id];
+  // Separator, fragment, number and closing brace
+  if (pos_ + 1 + fragment_len + 24 + 1 + kClosing > buffer_.size()) {
+    return false;
+  }
+  if (update_values_ > 0) {
+    buffer_[pos_++] = ',';
+  }
+  memcpy(&buffer_[pos_], fragment, fragment_len);
+  pos_ += fragment_len;
+  pos_ += FormatSKNumber(value, &buffer_[pos_]);
+  buffer_[pos_++] = '}';
+  update_values_++;
+  values_++;
+  return true;
+}
+
+const char* SKDeltaWriter::finish(size_t* len) {
+  // kClosing is always kept free for this
+  if (in_update_) {
+    memcpy(&buffer_[pos_], kUpdateEnd, sizeof(kUpdateEnd) - 1);
+    pos_ += sizeof(kUpdateEnd) - 1;
+    in_update_ = false;
+  }
+  memcpy(&buffer_[pos_], kDeltaEnd, sizeof(kDeltaEnd) - 1);
+  pos_ += sizeof(kDeltaEnd) - 1;
+  buffer_[pos_] = '\0';
+  *len = pos_;
+  return buffer_.data();
+}
+
+}  // namespace halmet
@@ -0,0 +1,82 @@
+#ifndef HALMET_SRC_SK_DELTA_WRITER_H_
+#define HALMET_SRC_SK_DELTA_WRITER_H_
+
+// Framework-independent Signal K delta serialisation into a fixed buffer.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace halmet {
+
+/**
+ * @brief Writes Signal K delta messages from precompiled path fragments.
+ *
+ * Every output path is registered once at startup, which prepares its
+ * `{"path":"...","value":` fragment. A delta is then assembled by copying
+ * fragments and formatting numbers straight into a buffer allocated in the
+ * constructor: no JSON document is built and nothing is allocated per
+ * value or per message.
+ *
+ * A delta holds one or more updates, each with an optional timestamp, so
+ * values recorded at different times can share a message.
+ */
+class SKDeltaWriter {
+ public:
+  using PathId = uint16_t;
+
+  explicit SKDeltaWriter(size_t capacity = 1024);
+
+  /// Register a path. Call at startup only.
+  PathId add_path(const char* path);
+  size_t get_path_count() const { return fragment_offsets_.size() - 1; }
+
+  /// Start a new delta, discarding anything written before.
+  void begin();
+
+  /**
+   * @brief Start a new update in the current delta.
+   *
+   * @param timestamp_ms Time of the values, in ms since the Unix epoch, or 0
+   *   to leave the timestamp to the server
+   */
+  bool begin_update(uint64_t timestamp_ms = 0);
+
+  /// Add a value to the current update. Returns false if the buffer is full.
+  bool add_value(PathId id, float value);
+
+  /// Close the delta. Returns the NUL terminated message.
+  const char* finish(size_t* len);
+
+  /// Number of values in the current delta.
+  size_t get_value_count() const { return values_; }
+
+ protected:
+  bool append(const char* data, size_t len);
+  // Room needed after the current position to close the delta
+  static const size_t kClosing = 5;
+
+  std::vector<char> buffer_;
+  size_t pos_ = 0;
+  size_t updates_ = 0;
+  size_t values_ = 0;
+  size_t update_values_ = 0;
+  bool in_update_ = false;
+
+  // Path fragments, back to back
+  std::vector<char> fragments_;
+  std::vector<uint32_t> fragment_offsets_;
+};
+
+/// Format value as a JSON number with six significant digits, or null if it
+/// isn't finite. buf needs room for 24 characters. Returns the length.
+size_t FormatSKNumber(float value, char* buf);
+
+/// Format an ISO 8601 UTC timestamp with milliseconds, e.g.
+/// 2024-06-01T12:34:56.789Z. buf needs room for 25 characters. Returns the
+/// length.
+size_t FormatSKTimestamp(uint64_t timestamp_ms, char* buf);
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_SK_DELTA_WRITER_H_
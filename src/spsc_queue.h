@@ -0,0 +1,82 @@
+#ifndef HALMET_SRC_SPSC_QUEUE_H_
+#define HALMET_SRC_SPSC_QUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace halmet {
+
+/**
+ * @brief Bounded, lock-free single-producer/single-consumer queue.
+ *
+ * One task may call push() and one other task may call pop() concurrently
+ * without any locking. The queue never allocates; a push to a full queue
+ * fails and is counted as a drop.
+ *
+ * @tparam T Item type; should be small and trivially copyable
+ * @tparam N Capacity; must be a power of two
+ */
+template <typename T, size_t N>
+class SpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0,
+                "SpscQueue capacity must be a power of two");
+
+ public:
+  /// Producer side. Returns false and counts a drop if the queue is full.
+  bool push(const T& item) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    if (head - tail >= N) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    items_[head & (N - 1)] = item;
+    head_.store(head + 1, std::memory_order_release);
+
+    size_t depth = head + 1 - tail;
+    if (depth > high_water_.load(std::memory_order_relaxed)) {
+      high_water_.store(depth, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  /// Consumer side. Returns false if the queue is empty.
+  bool pop(T* item) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    if (tail == head) {
+      return false;
+    }
+    *item = items_[tail & (N - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t size() const {
+    return head_.load(std::memory_order_acquire) -
+           tail_.load(std::memory_order_acquire);
+  }
+  static constexpr size_t capacity() { return N; }
+
+  size_t get_high_water() const {
+    return high_water_.load(std::memory_order_relaxed);
+  }
+  uint32_t get_dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::array<T, N> items_;
+  // Free-running counters; only the low bits index into items_
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+
+  std::atomic<size_t> high_water_{0};
+  std::atomic<uint32_t> dropped_{0};
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_SPSC_QUEUE_H_
@@ -0,0 +1,144 @@
+#ifndef HALMET_SRC_TACHO_ESTIMATOR_H_
+#define HALMET_SRC_TACHO_ESTIMATOR_H_
+
+// Framework-independent pulse-to-frequency logic for the tacho inputs. The
+// hardware-facing code feeds these with counter readings and timestamps, so
+// the same arithmetic can be driven by a simulated pulse train on the host.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace halmet {
+
+/**
+ * @brief Frequency from counter readings over a sliding window of the last
+ * M readings.
+ *
+ * Gives a new value on every reading while averaging over M - 1 read
+ * intervals, which keeps the quantization error of pure pulse counting
+ * acceptable at high frequencies.
+ */
+template <size_t M>
+class SlidingPulseRate {
+ public:
+  float update(int32_t count, uint64_t now_us) {
+    size_t index = readings_ % M;
+    counts_[index] = count;
+    times_us_[index] = now_us;
+    readings_++;
+
+    size_t available = readings_ < M ? readings_ : M;
+    if (available < 2) {
+      return 0;
+    }
+    size_t oldest = (readings_ - available) % M;
+    uint32_t pulses = static_cast<uint32_t>(count) -
+                      static_cast<uint32_t>(counts_[oldest]);
+    uint64_t elapsed_us = now_us - times_us_[oldest];
+    return elapsed_us > 0 ? pulses * 1e6f / elapsed_us : 0;
+  }
+
+ private:
+  int32_t counts_[M];
+  uint64_t times_us_[M];
+  size_t readings_ = 0;
+};
+
+/**
+ * @brief Frequency from the timestamps of the most recent edges.
+ *
+ * Measuring the period instead of counting pulses gives a fresh, precise
+ * value after every edge even at very low frequencies. When the edges stop
+ * coming, the estimate decays as 1 / (time since the last edge) and drops to
+ * zero after the timeout, so a stopping engine is reported without delay.
+ *
+ * @tparam N Number of edge timestamps kept
+ */
+template <size_t N>
+class EdgePeriodEstimator {
+ public:
+  /// Record an edge. Timestamps are free-running 32-bit microseconds.
+  void add_edge(uint32_t timestamp_us) {
+    timestamps_us_[edges_ % N] = timestamp_us;
+    edges_++;
+  }
+
+  void reset() { edges_ = 0; }
+
+  /**
+   * @brief Estimate the frequency.
+   *
+   * @param now_us Current time, on the same clock as the edge timestamps
+   * @param timeout_us Report zero if no edge was seen for this long
+   * @param intervals Number of edge intervals to average over (< N)
+   * @return Frequency in Hz
+   */
+  float get_frequency(uint32_t now_us, uint32_t timeout_us,
+                      size_t intervals) const {
+    size_t available = edges_ < N ? edges_ : N;
+    if (available < 2) {
+      return 0;
+    }
+    uint32_t last = timestamps_us_[(edges_ - 1) % N];
+    uint32_t since_last = now_us - last;
+    if (since_last > timeout_us) {
+      return 0;
+    }
+    if (intervals > available - 1) {
+      intervals = available - 1;
+    }
+    uint32_t first = timestamps_us_[(edges_ - 1 - intervals) % N];
+    uint32_t span = last - first;
+    if (span == 0) {
+      return 0;
+    }
+    float frequency = intervals * 1e6f / span;
+    // No edge for longer than one period: the signal is slowing down
+    if (since_last * frequency > 1e6f) {
+      frequency = 1e6f / since_last;
+    }
+    return frequency;
+  }
+
+ private:
+  uint32_t timestamps_us_[N];
+  uint32_t edges_ = 0;
+};
+
+/**
+ * @brief Chooses between period measurement and pulse counting.
+ *
+ * Period measurement needs an interrupt per edge, so it is only used below
+ * the crossover frequency. The hysteresis band keeps the mode from
+ * flapping around the crossover point.
+ */
+class TachoCrossover {
+ public:
+  enum class Mode { kPeriod, kCount };
+
+  TachoCrossover(float crossover_hz, float hysteresis = 0.1)
+      : crossover_hz_{crossover_hz}, hysteresis_{hysteresis} {}
+
+  Mode update(float frequency) {
+    if (mode_ == Mode::kPeriod &&
+        frequency > crossover_hz_ * (1 + hysteresis_)) {
+      mode_ = Mode::kCount;
+    } else if (mode_ == Mode::kCount &&
+               frequency < crossover_hz_ * (1 - hysteresis_)) {
+      mode_ = Mode::kPeriod;
+    }
+    return mode_;
+  }
+
+  Mode get_mode() const { return mode_; }
+  void set_crossover(float crossover_hz) { crossover_hz_ = crossover_hz; }
+
+ private:
+  float crossover_hz_;
+  float hysteresis_;
+  Mode mode_ = Mode::kPeriod;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_TACHO_ESTIMATOR_H_
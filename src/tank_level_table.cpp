@@ -0,0 +1,62 @@
+#include "tank_level_table.h"
+
+#include <cmath>
+
+namespace halmet {
+
+float TankLevelTable::interpolate(const std::vector<Point>& curve,
+                                  float resistance, size_t* segment) {
+  // Resistances only grow while the table is built, so the search carries on
+  // from the previous segment
+  while (*segment < curve.size() && resistance > curve[*segment].resistance) {
+    (*segment)++;
+  }
+  if (*segment == curve.size()) {
+    return curve.back().level;
+  }
+  float x0 = 0;
+  float y0 = 0;
+  if (*segment > 0) {
+    x0 = curve[*segment - 1].resistance;
+    y0 = curve[*segment - 1].level;
+  }
+  float x1 = curve[*segment].resistance;
+  float y1 = curve[*segment].level;
+  if (x1 == x0) {
+    return y1;
+  }
+  return (y0 * (x1 - resistance) + y1 * (resistance - x0)) / (x1 - x0);
+}
+
+void TankLevelTable::build(const std::vector<Point>& curve,
+                           float ohms_per_code) {
+  table_.clear();
+  shift_ = 0;
+  max_code_ = 0;
+  last_level_ = 0;
+  if (curve.empty() || ohms_per_code <= 0) {
+    return;
+  }
+
+  last_level_ = curve.back().level;
+  float max_codes = std::ceil(curve.back().resistance / ohms_per_code);
+  max_code_ = max_codes < INT16_MAX ? static_cast<int32_t>(max_codes)
+                                    : INT16_MAX;
+  if (max_code_ < 1) {
+    max_code_ = 0;
+    return;
+  }
+  while ((static_cast<size_t>(max_code_) >> shift_) + 1 >= kMaxEntries) {
+    shift_++;
+  }
+
+  size_t entries = (max_code_ >> shift_) + 2;
+  table_.resize(entries);
+  size_t segment = 0;
+  for (size_t i = 0; i < entries; i++) {
+    float resistance = static_cast<float>(i << shift_) * ohms_per_code;
+    table_[i] = interpolate(curve, resistance, &segment);
+  }
+}
+
+}  // namespace halmet
@@ -0,0 +1,76 @@
+#ifndef HALMET_SRC_TANK_LEVEL_TABLE_H_
+#define HALMET_SRC_TANK_LEVEL_TABLE_H_
+
+// Framework-independent lookup from a raw ADC code to a tank level.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace halmet {
+
+/**
+ * @brief Tank level curve compiled into a table indexed by ADC code.
+ *
+ * The level curve maps sender resistance to level through piecewise linear
+ * interpolation, with the same semantics as sensesp::CurveInterpolator: an
+ * implicit (0, 0) point before the first sample and a constant level past
+ * the last one. build() evaluates the curve once for every ADC code (or,
+ * for a very wide resistance range, every 2^n codes) up to the last sample,
+ * so the cost per conversion is one table access no matter how many points
+ * the curve has.
+ *
+ * Negative codes count as zero resistance.
+ */
+class TankLevelTable {
+ public:
+  struct Point {
+    float resistance;  // ohms
+    float level;       // ratio
+  };
+
+  static const size_t kMaxEntries = 2048;
+
+  /**
+   * @brief Compile the curve.
+   *
+   * @param curve Curve points, sorted by resistance
+   * @param ohms_per_code Sender resistance corresponding to one ADC code
+   */
+  void build(const std::vector<Point>& curve, float ohms_per_code);
+
+  float level(int16_t code) const {
+    if (code < 0) {
+      code = 0;
+    }
+    if (code >= max_code_) {
+      return last_level_;
+    }
+    size_t index = code >> shift_;
+    uint32_t frac = code & ((1 << shift_) - 1);
+    if (frac == 0) {
+      return table_[index];
+    }
+    // Between two entries of a strided table
+    float step = table_[index + 1] - table_[index];
+    return table_[index] + step * frac / (1 << shift_);
+  }
+
+  size_t size() const { return table_.size(); }
+  bool empty() const { return table_.empty(); }
+
+ protected:
+  // Curve value at resistance
+  static float interpolate(const std::vector<Point>& curve, float resistance,
+                           size_t* segment);
+
+  std::vector<float> table_;
+  // Codes per entry, as a power of two
+  int shift_ = 0;
+  int32_t max_code_ = 0;
+  float last_level_ = 0;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_TANK_LEVEL_TABLE_H_
@@ -0,0 +1,77 @@
+#include "transmit_plan.h"
+
+#include <algorithm>
+#include <climits>
+
+namespace halmet {
+
+// Upper bound for the phase planning cycle, in ticks
+const unsigned int kMaxCycleTicks = 10000;
+
+static unsigned int Gcd(unsigned int a, unsigned int b) {
+  while (b != 0) {
+    unsigned int t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+size_t TransmitPlan::add(unsigned int period, unsigned int stale_divider) {
+  unsigned int period_ticks = std::max(1U, period / tick_interval_);
+  entries_.push_back({period_ticks, 0, stale_divider, 0});
+  return entries_.size() - 1;
+}
+
+void TransmitPlan::assign_phases() {
+  // Plan over the least common multiple of all periods, so that every
+  // collision between two messages shows up in the occupancy table
+  unsigned int cycle = 1;
+  for (const auto& entry : entries_) {
+    unsigned int lcm = cycle / Gcd(cycle, entry.period_ticks) *
+                       entry.period_ticks;
+    cycle = std::min(lcm, kMaxCycleTicks);
+  }
+  std::vector<uint8_t> occupancy(cycle, 0);
+
+  // Place the most frequent messages first; they are the hardest to fit
+  std::vector<Entry*> order;
+  for (auto& entry : entries_) {
+    order.push_back(&entry);
+  }
+  std::stable_sort(order.begin(), order.end(), [](Entry* a, Entry* b) {
+    return a->period_ticks < b->period_ticks;
+  });
+
+  for (Entry* entry : order) {
+    unsigned int best_phase = 0;
+    unsigned int best_cost = UINT_MAX;
+    for (unsigned int phase = 0; phase < entry->period_ticks; phase++) {
+      unsigned int cost = 0;
+      for (unsigned int t = phase; t < cycle; t += entry->period_ticks) {
+        cost += occupancy[t];
+      }
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_phase = phase;
+      }
+    }
+    entry->phase_ticks = best_phase;
+    for (unsigned int t = best_phase; t < cycle; t += entry->period_ticks) {
+      occupancy[t]++;
+    }
+  }
+}
+
+bool TransmitPlan::should_send(size_t index, bool fresh) {
+  Entry& entry = entries_[index];
+  if (fresh) {
+    entry.stale_count = 0;
+    return true;
+  }
+  // All inputs expired: only send an occasional heartbeat
+  return entry.stale_divider != 0 &&
+         entry.stale_count++ % entry.stale_divider == 0;
+}
+
+}  // namespace halmet
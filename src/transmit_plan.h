@@ -0,0 +1,75 @@
+#ifndef HALMET_SRC_TRANSMIT_PLAN_H_
+#define HALMET_SRC_TRANSMIT_PLAN_H_
+
+// Framework-independent timing of N2kTransmitScheduler: which periodic
+// message is due at which tick, and when a stale one is still sent.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace halmet {
+
+/**
+ * @brief Phase-staggered timing of periodic messages on a common tick.
+ *
+ * Each message gets a period in ticks and, from assign_phases(), a phase
+ * offset within its period chosen so that as few messages as possible are
+ * due in the same tick.
+ *
+ * A message whose inputs have all expired is only sent on every
+ * stale_divider-th period as a heartbeat, or not at all if stale_divider
+ * is 0.
+ */
+class TransmitPlan {
+ public:
+  explicit TransmitPlan(unsigned int tick_interval)
+      : tick_interval_{tick_interval} {}
+
+  /**
+   * @brief Add a message.
+   *
+   * @param period Transmit interval, in ms; rounded down to whole ticks
+   * @param stale_divider Heartbeat divider while all inputs are expired
+   * @return Index of the message
+   */
+  size_t add(unsigned int period, unsigned int stale_divider);
+
+  /// Spread the messages over the ticks. Call after the last add().
+  void assign_phases();
+
+  bool is_due(size_t index, uint32_t tick) const {
+    const Entry& entry = entries_[index];
+    return tick % entry.period_ticks == entry.phase_ticks;
+  }
+
+  /**
+   * @brief Decide whether a due message is sent.
+   *
+   * @param fresh Whether any of the message's inputs is fresh
+   */
+  bool should_send(size_t index, bool fresh);
+
+  size_t size() const { return entries_.size(); }
+  unsigned int get_period_ticks(size_t index) const {
+    return entries_[index].period_ticks;
+  }
+  unsigned int get_phase_ticks(size_t index) const {
+    return entries_[index].phase_ticks;
+  }
+
+ protected:
+  struct Entry {
+    unsigned int period_ticks;
+    unsigned int phase_ticks;
+    unsigned int stale_divider;
+    unsigned int stale_count;
+  };
+
+  unsigned int tick_interval_;
+  std::vector<Entry> entries_;
+};
+
+}  // namespace halmet
+
+#endif  // HALMET_SRC_TRANSMIT_PLAN_H_
@@ -0,0 +1,262 @@
+#include <unity.h>
+
+#include <vector>
+
+#include "ads1115_scheduler.h"
+
+using namespace halmet;
+
+// Simulated ADS1115. Conversions take their nominal time scaled by the
+// oscillator error; every conversion_complete() call counts as one I2C
+// register read.
+class SimAds1115 : public Ads1115Io {
+ public:
+  uint32_t now = 0;
+  float oscillator = 1.05;  // 5% slow
+  bool stuck = false;
+  int16_t values[4] = {100, 200, 300, 400};
+  // Overrides values[] if set
+  int16_t (*signal)(int channel, uint32_t now_us) = nullptr;
+
+  int channel = -1;
+  unsigned int data_rate = 0;
+  bool continuous = false;
+  uint32_t started = 0;
+
+  uint32_t starts = 0;
+  uint32_t checks = 0;
+  uint32_t not_ready = 0;
+
+  void start(int channel, unsigned int data_rate, bool continuous) override {
+    this->channel = channel;
+    this->data_rate = data_rate;
+    this->continuous = continuous;
+    started = now;
+    starts++;
+  }
+
+  bool conversion_complete() override {
+    checks++;
+    bool complete = !stuck && now - started >= duration();
+    if (!complete) {
+      not_ready++;
+    }
+    return complete;
+  }
+
+  int16_t read_result() override {
+    return signal ? signal(channel, now) : values[channel];
+  }
+
+  uint32_t duration() const {
+    return static_cast<uint32_t>(1e6 / data_rate * oscillator);
+  }
+};
+
+static SimAds1115* sim;
+static Ads1115Scheduler* scheduler;
+
+void setUp() {
+  sim = new SimAds1115();
+  scheduler = new Ads1115Scheduler(sim);
+}
+
+void tearDown() {
+  delete scheduler;
+  delete sim;
+}
+
+// Tick like the event loop: every millisecond for duration_ms
+static void run(uint32_t duration_ms, uint32_t tick_us = 1000) {
+  for (uint32_t t = 0; t < duration_ms * 1000; t += tick_us) {
+    sim->now += tick_us;
+    scheduler->tick(sim->now);
+  }
+}
+
+void test_readings_reach_their_channels() {
+  std::vector<int16_t> a, b;
+  scheduler->add_channel(0, 100, [&](int16_t v) { a.push_back(v); });
+  scheduler->add_channel(3, 500, [&](int16_t v) { b.push_back(v); });
+  run(10000);
+  TEST_ASSERT_UINT32_WITHIN(2, 100, a.size());
+  TEST_ASSERT_UINT32_WITHIN(2, 20, b.size());
+  TEST_ASSERT_EQUAL_INT16(100, a.back());
+  TEST_ASSERT_EQUAL_INT16(400, b.back());
+}
+
+void test_no_ready_check_before_conversion_time() {
+  // Without an ALERT pin, each check is an I2C read. At 1 ms ticks, a
+  // 128 SPS conversion (7.8 ms) must not be checked eight times.
+  scheduler->add_channel(0, 100, [](int16_t) {});
+  scheduler->add_channel(1, 100, [](int16_t) {}, {1, 860});
+  run(10000);
+  const auto& stats = scheduler->get_stats();
+  TEST_ASSERT_GREATER_THAN(150, stats.conversions);
+  TEST_ASSERT_EQUAL_UINT32(0, sim->not_ready);
+  TEST_ASSERT_EQUAL_UINT32(stats.conversions, stats.ready_checks);
+}
+
+void test_ticks_between_conversions_do_no_io() {
+  scheduler->add_channel(0, 1000, [](int16_t) {}, {1, 8});
+  run(1);  // starts the conversion
+  uint32_t starts = sim->starts;
+  uint32_t checks = sim->checks;
+  run(100);  // well within the 125 ms conversion
+  TEST_ASSERT_EQUAL_UINT32(starts, sim->starts);
+  TEST_ASSERT_EQUAL_UINT32(checks, sim->checks);
+}
+
+void test_busy_channel_does_not_starve_others() {
+  int fast = 0, slow = 0;
+  // Due at every tick
+  scheduler->add_channel(0, 0, [&](int16_t) { fast++; }, {1, 860});
+  scheduler->add_channel(1, 200, [&](int16_t) { slow++; }, {1, 860});
+  run(2000);
+  TEST_ASSERT_UINT32_WITHIN(1, 10, slow);
+  TEST_ASSERT_GREATER_THAN(100, fast);
+}
+
+void test_oversampling_rejects_spikes() {
+  static int count = 0;
+  count = 0;
+  // Every fourth conversion is a spike
+  sim->signal = [](int, uint32_t) -> int16_t {
+    return (count++ % 4 == 0) ? 30000 : 1000;
+  };
+  std::vector<int16_t> readings;
+  scheduler->add_channel(0, 100, [&](int16_t v) { readings.push_back(v); },
+                         {8, 860});
+  run(1000);
+  TEST_ASSERT_GREATER_THAN(5, readings.size());
+  for (int16_t reading : readings) {
+    TEST_ASSERT_EQUAL_INT16(1000, reading);
+  }
+  TEST_ASSERT_EQUAL_UINT32(8 * readings.size(),
+                           scheduler->get_stats().conversions);
+}
+
+void test_reduce() {
+  int16_t two[] = {10, 21};
+  TEST_ASSERT_EQUAL_INT16(16, Ads1115Scheduler::reduce(two, 2));
+  int16_t three[] = {50, 10, 20};
+  TEST_ASSERT_EQUAL_INT16(20, Ads1115Scheduler::reduce(three, 3));
+  int16_t five[] = {7, 1000, 10, 9, 8};
+  // Middle three
+  TEST_ASSERT_EQUAL_INT16(9, Ads1115Scheduler::reduce(five, 5));
+  int16_t eight[] = {1, 100, 101, 102, 103, 9000, -9000, 104};
+  // Middle four of -9000 1 100 101 102 103 104 9000
+  TEST_ASSERT_EQUAL_INT16(102, Ads1115Scheduler::reduce(eight, 8));
+}
+
+void test_timeout_recovers() {
+  std::vector<int16_t> readings;
+  scheduler->add_channel(0, 100, [&](int16_t v) { readings.push_back(v); });
+  sim->stuck = true;
+  run(1000);
+  TEST_ASSERT_GREATER_THAN(0, scheduler->get_stats().timeouts);
+  TEST_ASSERT_EQUAL(0, readings.size());
+  sim->stuck = false;
+  run(1000);
+  TEST_ASSERT_GREATER_THAN(5, readings.size());
+}
+
+void test_data_rates() {
+  TEST_ASSERT_EQUAL_UINT(128, Ads1115Scheduler::supported_data_rate(100));
+  TEST_ASSERT_EQUAL_UINT(860, Ads1115Scheduler::supported_data_rate(860));
+  TEST_ASSERT_EQUAL_UINT(860, Ads1115Scheduler::supported_data_rate(5000));
+  TEST_ASSERT_EQUAL_UINT(8, Ads1115Scheduler::supported_data_rate(1));
+  // Nominal plus 10%
+  TEST_ASSERT_UINT32_WITHIN(30, 1279, Ads1115Scheduler::conversion_time(860));
+}
+
+void test_invalid_channel() {
+  TEST_ASSERT_FALSE(scheduler->add_channel(4, 100, [](int16_t) {}));
+  TEST_ASSERT_FALSE(scheduler->add_channel(-1, 100, [](int16_t) {}));
+}
+
+void test_time_wraps() {
+  int readings = 0;
+  sim->now = UINT32_MAX - 500000;
+  scheduler->add_channel(0, 100, [&](int16_t) { readings++; });
+  run(1000);
+  TEST_ASSERT_UINT32_WITHIN(1, 10, readings);
+}
+
+// In continuous mode, the number of the conversion in the result register
+static int16_t conversion_number(int, uint32_t now_us) {
+  return (now_us - sim->started) / sim->duration();
+}
+
+static size_t capture(size_t count, uint32_t tick_us, int16_t* buffer,
+                      uint32_t* times) {
+  size_t captured = SIZE_MAX;
+  sim->signal = conversion_number;
+  TEST_ASSERT_TRUE(scheduler->start_capture(
+      2, buffer, times, count, [&](size_t n) { captured = n; }));
+  // Twice the nominal duration, in case the capture overruns
+  run(2 * count * Ads1115Scheduler::kCapturePeriod / 1000 + 10, tick_us);
+  TEST_ASSERT_NOT_EQUAL(SIZE_MAX, captured);
+  return captured;
+}
+
+void test_capture_stores_only_real_samples() {
+  int16_t buffer[100];
+  uint32_t times[100];
+  size_t count = capture(100, 1000, buffer, times);
+  TEST_ASSERT_TRUE(sim->continuous);
+  TEST_ASSERT_EQUAL_UINT(860, sim->data_rate);
+  // 1 ms ticks read every other millisecond
+  TEST_ASSERT_UINT32_WITHIN(2, 58, count);
+  for (size_t i = 1; i < count; i++) {
+    // A new conversion every time, none stored twice
+    TEST_ASSERT_GREATER_THAN_INT16(buffer[i - 1], buffer[i]);
+    TEST_ASSERT_GREATER_THAN_UINT32(times[i - 1], times[i]);
+  }
+  // The capture lasts as long as 100 conversions
+  TEST_ASSERT_UINT32_WITHIN(2000, 100 * Ads1115Scheduler::kCapturePeriod,
+                            times[count - 1]);
+}
+
+void test_capture_marks_late_ticks() {
+  int16_t buffer[100];
+  uint32_t times[100];
+  size_t count = capture(100, 7000, buffer, times);
+  TEST_ASSERT_UINT32_WITHIN(1, 16, count);
+  for (size_t i = 1; i < count; i++) {
+    // Skipped conversions show up as gaps in both
+    TEST_ASSERT_EQUAL_UINT32(7000, times[i] - times[i - 1]);
+    TEST_ASSERT_INT_WITHIN(1, 7000 / sim->duration(),
+                           buffer[i] - buffer[i - 1]);
+  }
+}
+
+void test_scanning_resumes_after_capture() {
+  int readings = 0;
+  scheduler->add_channel(0, 100, [&](int16_t) { readings++; });
+  int16_t buffer[10];
+  uint32_t times[10];
+  capture(10, 1000, buffer, times);
+  TEST_ASSERT_FALSE(sim->continuous);
+  readings = 0;
+  run(1000);
+  TEST_ASSERT_UINT32_WITHIN(1, 10, readings);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_readings_reach_their_channels);
+  RUN_TEST(test_no_ready_check_before_conversion_time);
+  RUN_TEST(test_ticks_between_conversions_do_no_io);
+  RUN_TEST(test_busy_channel_does_not_starve_others);
+  RUN_TEST(test_oversampling_rejects_spikes);
+  RUN_TEST(test_reduce);
+  RUN_TEST(test_timeout_recovers);
+  RUN_TEST(test_data_rates);
+  RUN_TEST(test_invalid_channel);
+  RUN_TEST(test_time_wraps);
+  RUN_TEST(test_capture_stores_only_real_samples);
+  RUN_TEST(test_capture_marks_late_ticks);
+  RUN_TEST(test_scanning_resumes_after_capture);
+  return UNITY_END();
+}
@@ -0,0 +1,62 @@
+#include <unity.h>
+
+#include <cmath>
+
+#include "cranking_analysis.h"
+
+using namespace halmet;
+
+// 1 mV per code, so codes read as millivolts
+static const float kVoltsPerCode = 0.001;
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_even_samples() {
+  const int16_t samples[] = {12000, 10000, 9000, 11000, 12000};
+  const uint32_t times[] = {2000, 4000, 6000, 8000, 10000};
+  CrankingSummary summary =
+      AnalyzeCranking(samples, times, 5, kVoltsPerCode, 12.0, 11.5);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 9.0, summary.minimum);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.006, summary.time_to_minimum);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.004, summary.recovery_time);
+  // (2 + 3 + 1) V for 2 ms each
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.012, summary.sag_integral);
+}
+
+void test_gap_counts_its_duration() {
+  // The third sample comes 10 ms after the second, as after a late tick
+  const int16_t samples[] = {11000, 10000, 10000, 12000};
+  const uint32_t times[] = {2000, 4000, 14000, 16000};
+  CrankingSummary summary =
+      AnalyzeCranking(samples, times, 4, kVoltsPerCode, 12.0, 11.5);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.004, summary.time_to_minimum);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.012, summary.recovery_time);
+  // 1 V for 2 ms, 2 V for 2 ms, 2 V for 10 ms
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.026, summary.sag_integral);
+}
+
+void test_no_recovery() {
+  const int16_t samples[] = {10000, 9000, 9500};
+  const uint32_t times[] = {2000, 4000, 6000};
+  CrankingSummary summary =
+      AnalyzeCranking(samples, times, 3, kVoltsPerCode, 12.0, 11.5);
+  TEST_ASSERT_FLOAT_IS_NAN(summary.recovery_time);
+}
+
+void test_empty_capture() {
+  CrankingSummary summary =
+      AnalyzeCranking(nullptr, nullptr, 0, kVoltsPerCode, 12.0, 11.5);
+  TEST_ASSERT_FLOAT_IS_NAN(summary.minimum);
+  TEST_ASSERT_FLOAT_IS_NAN(summary.recovery_time);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_even_samples);
+  RUN_TEST(test_gap_counts_its_duration);
+  RUN_TEST(test_no_recovery);
+  RUN_TEST(test_empty_capture);
+  return UNITY_END();
+}
@@ -0,0 +1,237 @@
+#include <unity.h>
+
+#include <cstring>
+#include <vector>
+
+#include "ds18b20_bus.h"
+
+using namespace halmet;
+
+// Simulated bus of DS18B20s. Tracks the ROM and function commands written
+// after each reset pulse, so the engine's transactions are decoded like a
+// real sensor would.
+class SimBus : public OneWireIo {
+ public:
+  struct Device {
+    OneWireRom rom;
+    uint8_t scratchpad[9];
+    float celsius;
+    bool present;
+  };
+
+  std::vector<Device> devices;
+
+  void add(uint8_t serial, float celsius) {
+    Device device = {};
+    uint8_t rom[8] = {0x28, serial, 0, 0, 0, 0, 0, 0};
+    rom[7] = OneWireCrc8(rom, 7);
+    memcpy(device.rom.bytes, rom, 8);
+    device.celsius = celsius;
+    device.present = true;
+    devices.push_back(device);
+    power_on(devices.size() - 1);
+  }
+
+  // Power-on state: 85 °C, EEPROM alarm values and 12 bits
+  void power_on(size_t index) {
+    uint8_t* pad = devices[index].scratchpad;
+    uint8_t defaults[8] = {0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10};
+    memcpy(pad, defaults, 8);
+    pad[8] = OneWireCrc8(pad, 8);
+  }
+
+  bool reset() override {
+    state_ = kRom;
+    received_.clear();
+    selected_ = -1;
+    for (const auto& device : devices) {
+      if (device.present) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void write_bytes(const uint8_t* data, size_t len) override {
+    for (size_t i = 0; i < len; i++) {
+      write(data[i]);
+    }
+  }
+
+  void read_bytes(uint8_t* data, size_t len) override {
+    const Device* device = selected_ >= 0 && devices[selected_].present
+                               ? &devices[selected_]
+                               : nullptr;
+    for (size_t i = 0; i < len; i++) {
+      data[i] = device != nullptr && i < 9 ? device->scratchpad[i] : 0xFF;
+    }
+  }
+
+  bool search(OneWireRom*, bool) override { return false; }
+
+ private:
+  enum State { kRom, kMatch, kFunction, kWrite, kIgnore };
+
+  void write(uint8_t byte) {
+    switch (state_) {
+      case kRom:
+        state_ = byte == 0x55 ? kMatch : byte == 0xCC ? kFunction : kIgnore;
+        break;
+      case kMatch:
+        received_.push_back(byte);
+        if (received_.size() == 8) {
+          for (size_t i = 0; i < devices.size(); i++) {
+            if (memcmp(devices[i].rom.bytes, received_.data(), 8) == 0) {
+              selected_ = i;
+            }
+          }
+          received_.clear();
+          state_ = kFunction;
+        }
+        break;
+      case kFunction:
+        if (byte == 0x44) {
+          convert();
+          state_ = kIgnore;
+        } else if (byte == 0x4E) {
+          state_ = kWrite;
+        } else {
+          state_ = kIgnore;
+        }
+        break;
+      case kWrite:
+        received_.push_back(byte);
+        if (received_.size() == 3 && selected_ >= 0) {
+          uint8_t* pad = devices[selected_].scratchpad;
+          memcpy(pad + 2, received_.data(), 3);
+          pad[8] = OneWireCrc8(pad, 8);
+          state_ = kIgnore;
+        }
+        break;
+      case kIgnore:
+        break;
+    }
+  }
+
+  void convert() {
+    for (auto& device : devices) {
+      int16_t raw = static_cast<int16_t>(device.celsius * 16);
+      device.scratchpad[0] = raw & 0xFF;
+      device.scratchpad[1] = (raw >> 8) & 0xFF;
+      device.scratchpad[8] = OneWireCrc8(device.scratchpad, 8);
+    }
+  }
+
+  State state_ = kIgnore;
+  std::vector<uint8_t> received_;
+  int selected_ = -1;
+};
+
+static SimBus* sim;
+static Ds18b20Bus* bus;
+static std::vector<float> readings;
+static uint32_t now;
+
+void setUp() {
+  sim = new SimBus();
+  bus = new Ds18b20Bus(sim, 1000);
+  readings.clear();
+  now = 0;
+  bus->set_reading_callback(
+      [](size_t, float celsius) { readings.push_back(celsius); });
+}
+
+void tearDown() {
+  delete bus;
+  delete sim;
+}
+
+static void run(uint32_t duration_ms) {
+  for (uint32_t end = now + duration_ms; now < end; now += 10) {
+    bus->tick(now);
+  }
+}
+
+void test_readings_delivered() {
+  sim->add(1, 21.5);
+  bus->add_sensor(sim->devices[0].rom, 12);
+  run(5000);
+  TEST_ASSERT_UINT32_WITHIN(1, 5, readings.size());
+  TEST_ASSERT_EQUAL_FLOAT(21.5, readings.back());
+  TEST_ASSERT_EQUAL_UINT32(0, bus->get_stats().invalid);
+}
+
+void test_genuine_85_degrees_accepted() {
+  sim->add(1, 60);
+  bus->add_sensor(sim->devices[0].rom, 12);
+  run(2000);
+  sim->devices[0].celsius = 85;
+  run(3000);
+  TEST_ASSERT_EQUAL_FLOAT(85, readings.back());
+  TEST_ASSERT_EQUAL_UINT32(0, bus->get_stats().invalid);
+}
+
+void test_85_degrees_at_startup_accepted_after_first_reading() {
+  // An exhaust that is actually at 85 °C: only the very first reading is
+  // in doubt
+  sim->add(1, 85);
+  bus->add_sensor(sim->devices[0].rom, 12);
+  run(3000);
+  TEST_ASSERT_EQUAL_UINT32(1, bus->get_stats().invalid);
+  TEST_ASSERT_GREATER_THAN(0, readings.size());
+  TEST_ASSERT_EQUAL_FLOAT(85, readings.back());
+}
+
+void test_reset_during_operation_rejected() {
+  sim->add(1, 40);
+  bus->add_sensor(sim->devices[0].rom, 10);
+  run(2000);
+  size_t count = readings.size();
+
+  // The sensor browns out after "Convert T" and comes back at power-on
+  // defaults
+  sim->devices[0].celsius = 41;
+  now += 1000 - now % 1000;
+  bus->tick(now);
+  sim->power_on(0);
+  run(990);
+  TEST_ASSERT_EQUAL_UINT32(1, bus->get_stats().invalid);
+  TEST_ASSERT_EQUAL_size_t(count, readings.size());
+
+  // Reconfigured and back to normal
+  run(2000);
+  TEST_ASSERT_GREATER_THAN(count, readings.size());
+  TEST_ASSERT_EQUAL_FLOAT(41, readings.back());
+  TEST_ASSERT_EQUAL_HEX8(0x3F, sim->devices[0].scratchpad[4]);
+}
+
+void test_missing_sensor() {
+  sim->add(1, 20);
+  bus->add_sensor(sim->devices[0].rom, 12);
+  sim->devices[0].present = false;
+  run(3000);
+  TEST_ASSERT_EQUAL(0, readings.size());
+  TEST_ASSERT_GREATER_THAN(0, bus->get_stats().no_presence);
+}
+
+void test_rom_format_roundtrip() {
+  OneWireRom rom = {{0x28, 0xff, 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc}};
+  char text[32];
+  FormatOneWireRom(rom, text, sizeof(text));
+  TEST_ASSERT_EQUAL_STRING("28:ff:12:34:56:78:9a:bc", text);
+  OneWireRom parsed;
+  TEST_ASSERT_TRUE(ParseOneWireRom(text, &parsed));
+  TEST_ASSERT_TRUE(parsed == rom);
+  TEST_ASSERT_FALSE(ParseOneWireRom("28:ff:12", &parsed));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_readings_delivered);
+  RUN_TEST(test_genuine_85_degrees_accepted);
+  RUN_TEST(test_85_degrees_at_startup_accepted_after_first_reading);
+  RUN_TEST(test_reset_during_operation_rejected);
+  RUN_TEST(test_missing_sensor);
+  RUN_TEST(test_rom_format_roundtrip);
+  return UNITY_END();
+}
@@ -0,0 +1,141 @@
+#include <unity.h>
+
+#include "engine_totals.h"
+#include "halmet_clock.h"
+
+using namespace halmet;
+
+// 36 l/h
+static const float kFuelRate = 1e-5f;  // m3/s
+static const float kRevolutions = 12.5f;  // Hz
+
+static RamFlashStorage* flash;
+static FlashLog* flash_log;
+static EngineTotals* totals;
+
+// A fresh log and totals on the same flash, as after a restart
+static bool restart() {
+  delete totals;
+  delete flash_log;
+  flash_log = new FlashLog(flash);
+  flash_log->begin();
+  totals = new EngineTotals(flash_log);
+  return totals->restore();
+}
+
+/**
+ * @brief Run the engine for a while, as the totalizer sees it.
+ *
+ * The engine PGNs feed the inputs every 500 ms and the totals are
+ * integrated every second, out of phase with the PGNs. The inputs stop
+ * after fed_ms.
+ */
+static void run(unsigned long duration_ms, unsigned long fed_ms) {
+  for (unsigned long t = 1; t <= duration_ms; t++) {
+    FakeClock::advance_ms(1);
+    if (t <= fed_ms && t % 500 == 0) {
+      totals->set_fuel_rate(kFuelRate);
+      totals->set_revolutions(kRevolutions);
+    }
+    if (t % 1000 == 300) {
+      totals->integrate();
+    }
+  }
+}
+
+void setUp() {
+  FakeClock::enable(1000000);
+  flash = new RamFlashStorage(4);
+  flash_log = nullptr;
+  totals = nullptr;
+  restart();
+}
+
+void tearDown() {
+  delete totals;
+  delete flash_log;
+  delete flash;
+  FakeClock::disable();
+}
+
+void test_integrates_fuel_rate_and_run_time() {
+  run(600300, 600300);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, 600, totals->get_run_time());
+  TEST_ASSERT_FLOAT_WITHIN(1e-7, 600 * kFuelRate, totals->get_fuel_used());
+}
+
+void test_silent_inputs_count_as_zero() {
+  // The inputs stop after 10 s, but integration goes on for a minute
+  run(60300, 10000);
+  // At most kMaxInputAge of stale input, rounded up to the next
+  // integration, is added
+  TEST_ASSERT_TRUE(totals->get_run_time() >= 10);
+  TEST_ASSERT_TRUE(totals->get_run_time() <= 10 + 2);
+  TEST_ASSERT_FLOAT_WITHIN(2 * kFuelRate, 10 * kFuelRate,
+                           totals->get_fuel_used());
+}
+
+void test_restore_after_restart() {
+  run(60300, 60300);
+  TEST_ASSERT_TRUE(totals->persist());
+  double run_time = totals->get_run_time();
+  double fuel_used = totals->get_fuel_used();
+
+  // Progress since the last persist is lost in a power cut
+  run(5000, 5000);
+  TEST_ASSERT_TRUE(restart());
+  TEST_ASSERT_EQUAL_FLOAT(run_time, totals->get_run_time());
+  TEST_ASSERT_EQUAL_FLOAT(fuel_used, totals->get_fuel_used());
+
+  // Integration continues from the restored totals
+  run(10300, 10300);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, run_time + 10, totals->get_run_time());
+}
+
+void test_persist_only_changes() {
+  TEST_ASSERT_FALSE(restart());
+  TEST_ASSERT_TRUE(totals->persist());
+  TEST_ASSERT_EQUAL_UINT32(0, flash_log->get_appended());
+
+  run(3300, 3300);
+  TEST_ASSERT_TRUE(totals->persist());
+  TEST_ASSERT_TRUE(totals->persist());
+  TEST_ASSERT_EQUAL_UINT32(1, flash_log->get_appended());
+
+  // The engine stopped: nothing more to save
+  run(10000, 0);
+  TEST_ASSERT_TRUE(totals->persist());
+  run(10000, 0);
+  TEST_ASSERT_TRUE(totals->persist());
+  TEST_ASSERT_EQUAL_UINT32(2, flash_log->get_appended());
+}
+
+void test_set_totals() {
+  totals->set_run_time(1234.5 * 3600);
+  totals->set_fuel_used(5.678);
+  TEST_ASSERT_TRUE(totals->persist());
+  TEST_ASSERT_TRUE(restart());
+  TEST_ASSERT_EQUAL_FLOAT(1234.5 * 3600, totals->get_run_time());
+  TEST_ASSERT_EQUAL_FLOAT(5.678, totals->get_fuel_used());
+}
+
+void test_without_log() {
+  EngineTotals unsaved(nullptr);
+  TEST_ASSERT_FALSE(unsaved.restore());
+  unsaved.set_revolutions(kRevolutions);
+  FakeClock::advance_ms(1000);
+  unsaved.integrate();
+  TEST_ASSERT_TRUE(unsaved.persist());
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 1, unsaved.get_run_time());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_integrates_fuel_rate_and_run_time);
+  RUN_TEST(test_silent_inputs_count_as_zero);
+  RUN_TEST(test_restore_after_restart);
+  RUN_TEST(test_persist_only_changes);
+  RUN_TEST(test_set_totals);
+  RUN_TEST(test_without_log);
+  return UNITY_END();
+}
@@ -0,0 +1,171 @@
+#include <unity.h>
+
+#include <vector>
+
+#include "flash_log.h"
+
+using namespace halmet;
+
+// RamFlashStorage that loses power part way through the next write after
+// tear_after is set: only the first tear_after bytes reach the flash
+class TornFlashStorage : public RamFlashStorage {
+ public:
+  using RamFlashStorage::RamFlashStorage;
+
+  bool write(size_t offset, const void* data, size_t len) override {
+    if (tear_after >= 0 && len > static_cast<size_t>(tear_after)) {
+      len = tear_after;
+      tear_after = -1;
+    }
+    return RamFlashStorage::write(offset, data, len);
+  }
+
+  int tear_after = -1;
+};
+
+// Header, payload and CRC of a 4-byte record
+static const size_t kRecordSize = 16;
+static const size_t kSectorSize = 256;
+static const size_t kRecordsPerSector = kSectorSize / kRecordSize;
+
+static TornFlashStorage* flash;
+static FlashLog* flash_log;
+
+// A fresh log on the same flash, as after a restart
+static void restart() {
+  delete flash_log;
+  flash_log = new FlashLog(flash);
+  TEST_ASSERT_TRUE(flash_log->begin());
+}
+
+static void append(uint32_t value) {
+  TEST_ASSERT_TRUE(flash_log->append(&value, sizeof(value)));
+}
+
+static uint32_t last() {
+  uint32_t value = 0;
+  TEST_ASSERT_EQUAL(sizeof(value), flash_log->read_last(&value, sizeof(value)));
+  return value;
+}
+
+// Four erased sectors and an empty log on them
+static void fresh_flash() {
+  delete flash_log;
+  delete flash;
+  flash = new TornFlashStorage(4, kSectorSize);
+  flash_log = nullptr;
+  restart();
+}
+
+void setUp() {
+  flash = nullptr;
+  flash_log = nullptr;
+  fresh_flash();
+}
+
+void tearDown() {
+  delete flash_log;
+  delete flash;
+}
+
+void test_empty_log() {
+  uint32_t value;
+  TEST_ASSERT_EQUAL(-1, flash_log->read_last(&value, sizeof(value)));
+  restart();
+  TEST_ASSERT_EQUAL(-1, flash_log->read_last(&value, sizeof(value)));
+}
+
+void test_read_last_after_restart() {
+  for (uint32_t i = 1; i <= 5; i++) {
+    append(i);
+    TEST_ASSERT_EQUAL_UINT32(i, last());
+  }
+  restart();
+  TEST_ASSERT_EQUAL_UINT32(5, last());
+  TEST_ASSERT_EQUAL_UINT32(5, flash_log->get_next_sequence());
+}
+
+void test_torn_final_record() {
+  // Power lost after the header, in the payload and before the CRC
+  for (int tear_after : {8, 10, 12}) {
+    fresh_flash();
+    append(1);
+    append(2);
+    flash->tear_after = tear_after;
+    append(3);
+    restart();
+    TEST_ASSERT_EQUAL_UINT32(2, last());
+
+    // Writing goes on past the torn record, and survives the next restart
+    append(4);
+    TEST_ASSERT_EQUAL_UINT32(4, last());
+    restart();
+    TEST_ASSERT_EQUAL_UINT32(4, last());
+  }
+}
+
+void test_torn_first_record_of_sector() {
+  for (uint32_t i = 1; i <= kRecordsPerSector; i++) {
+    append(i);
+  }
+  // The next record starts a new sector and is torn
+  flash->tear_after = 10;
+  append(100);
+  restart();
+  TEST_ASSERT_EQUAL_UINT32(kRecordsPerSector, last());
+
+  append(101);
+  restart();
+  TEST_ASSERT_EQUAL_UINT32(101, last());
+}
+
+void test_sector_wrap() {
+  // Several trips around the four sectors, restarting now and then
+  const uint32_t kRecords = 10 * 4 * kRecordsPerSector + 5;
+  for (uint32_t i = 1; i <= kRecords; i++) {
+    append(i);
+    if (i % 37 == 0) {
+      restart();
+      TEST_ASSERT_EQUAL_UINT32(i, last());
+    }
+  }
+  restart();
+  TEST_ASSERT_EQUAL_UINT32(kRecords, last());
+  TEST_ASSERT_EQUAL_UINT32(kRecords, flash_log->get_next_sequence());
+
+  // The log holds the most recent records, oldest first and without gaps
+  FlashLog::Cursor cursor = flash_log->oldest();
+  std::vector<uint32_t> values;
+  uint32_t value;
+  size_t len;
+  while (flash_log->read_next(&cursor, &value, sizeof(value), &len)) {
+    values.push_back(value);
+  }
+  TEST_ASSERT_GREATER_THAN(2 * kRecordsPerSector, values.size());
+  for (size_t i = 1; i < values.size(); i++) {
+    TEST_ASSERT_EQUAL_UINT32(values[i - 1] + 1, values[i]);
+  }
+  TEST_ASSERT_EQUAL_UINT32(kRecords, values.back());
+}
+
+void test_torn_record_after_wrap() {
+  const uint32_t kRecords = 4 * kRecordsPerSector + 3;
+  for (uint32_t i = 1; i <= kRecords; i++) {
+    append(i);
+  }
+  flash->tear_after = 12;
+  append(kRecords + 1);
+  restart();
+  TEST_ASSERT_EQUAL_UINT32(kRecords, last());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_log);
+  RUN_TEST(test_read_last_after_restart);
+  RUN_TEST(test_torn_final_record);
+  RUN_TEST(test_torn_first_record_of_sector);
+  RUN_TEST(test_sector_wrap);
+  RUN_TEST(test_torn_record_after_wrap);
+  return UNITY_END();
+}
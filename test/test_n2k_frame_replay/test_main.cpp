@@ -0,0 +1,200 @@
+#include <unity.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "n2k_frame_log.h"
+
+using namespace halmet;
+
+static std::vector<std::string> lines;
+static size_t next_line;
+
+void setUp() {
+  lines.clear();
+  next_line = 0;
+}
+
+void tearDown() {}
+
+static N2kFrameReplayer::LineSource source() {
+  return [](char* buf, size_t size) {
+    if (next_line == lines.size()) {
+      return false;
+    }
+    strncpy(buf, lines[next_line++].c_str(), size - 1);
+    buf[size - 1] = '\0';
+    return true;
+  };
+}
+
+// Frame IDs delivered while stepping the replay clock from start_us to
+// end_us in step_us increments
+static std::vector<uint32_t> replay(N2kFrameReplayer& replayer,
+                                    uint64_t start_us, uint64_t end_us,
+                                    uint64_t step_us) {
+  std::vector<uint32_t> ids;
+  N2kCanFrame frame;
+  for (uint64_t now = start_us; now <= end_us; now += step_us) {
+    while (replayer.next(now, &frame)) {
+      ids.push_back(frame.id);
+    }
+  }
+  return ids;
+}
+
+void test_parse_candump() {
+  N2kCanFrame frame;
+  TEST_ASSERT_TRUE(
+      ParseN2kLogLine("(1436509052.249713) can0 09F80100#FFFF7FFF", &frame));
+  TEST_ASSERT_EQUAL_UINT64(1436509052249713ULL, frame.timestamp_us);
+  TEST_ASSERT_EQUAL_HEX32(0x09F80100, frame.id);
+  TEST_ASSERT_EQUAL_UINT8(4, frame.len);
+  TEST_ASSERT_EQUAL_HEX8(0x7F, frame.data[2]);
+
+  TEST_ASSERT_TRUE(ParseN2kLogLine("can0 09F80100 [3] 01 02 03", &frame));
+  TEST_ASSERT_EQUAL_UINT64(0, frame.timestamp_us);
+  TEST_ASSERT_EQUAL_UINT8(3, frame.len);
+  TEST_ASSERT_EQUAL_HEX8(0x03, frame.data[2]);
+}
+
+void test_parse_actisense_raw() {
+  N2kCanFrame frame;
+  TEST_ASSERT_TRUE(
+      ParseN2kLogLine("17:33:21.107 R 09F80100 FF FF 7F FF", &frame));
+  TEST_ASSERT_EQUAL_UINT64(((17 * 60 + 33) * 60 + 21) * 1000000ULL + 107000,
+                           frame.timestamp_us);
+  TEST_ASSERT_EQUAL_HEX32(0x09F80100, frame.id);
+  TEST_ASSERT_EQUAL_UINT8(4, frame.len);
+}
+
+void test_parse_rejects_garbage() {
+  N2kCanFrame frame;
+  TEST_ASSERT_FALSE(ParseN2kLogLine("", &frame));
+  TEST_ASSERT_FALSE(ParseN2kLogLine("# comment", &frame));
+  TEST_ASSERT_FALSE(ParseN2kLogLine("12:00 R", &frame));
+}
+
+void test_original_pace() {
+  lines = {"(100.000000) can0 00000001#00", "(100.100000) can0 00000002#00",
+           "(100.300000) can0 00000003#00"};
+  N2kFrameReplayer replayer(source(), 1.0, 10);
+  N2kCanFrame frame;
+  TEST_ASSERT_TRUE(replayer.next(5000000, &frame));
+  TEST_ASSERT_EQUAL_HEX32(1, frame.id);
+  TEST_ASSERT_FALSE(replayer.next(5099999, &frame));
+  TEST_ASSERT_TRUE(replayer.next(5100000, &frame));
+  TEST_ASSERT_EQUAL_HEX32(2, frame.id);
+  TEST_ASSERT_EQUAL_UINT64(5100000, frame.timestamp_us);
+  TEST_ASSERT_FALSE(replayer.next(5299999, &frame));
+  TEST_ASSERT_TRUE(replayer.next(5300000, &frame));
+  TEST_ASSERT_TRUE(replayer.finished());
+}
+
+void test_speed_factor() {
+  lines = {"(0.000000) can0 00000001#00", "(1.000000) can0 00000002#00"};
+  N2kFrameReplayer replayer(source(), 4.0, 10);
+  N2kCanFrame frame;
+  TEST_ASSERT_TRUE(replayer.next(0, &frame));
+  TEST_ASSERT_FALSE(replayer.next(249999, &frame));
+  TEST_ASSERT_TRUE(replayer.next(250000, &frame));
+}
+
+void test_full_speed_never_drops() {
+  for (int i = 0; i < 100; i++) {
+    lines.push_back("(1.000000) can0 00000001#00");
+  }
+  N2kFrameReplayer replayer(source(), 0, 4);
+  N2kCanFrame frame;
+  int count = 0;
+  while (replayer.next(0, &frame)) {
+    count++;
+  }
+  TEST_ASSERT_EQUAL_INT(100, count);
+  TEST_ASSERT_EQUAL_UINT32(0, replayer.get_dropped());
+}
+
+void test_slow_consumer_drops() {
+  // 20 frames due at once into a 5 frame receive buffer
+  for (int i = 0; i < 20; i++) {
+    lines.push_back("(1.000000) can0 00000001#00");
+  }
+  lines.push_back("(2.000000) can0 00000002#00");
+  N2kFrameReplayer replayer(source(), 1.0, 5);
+  auto ids = replay(replayer, 0, 2000000, 500000);
+  TEST_ASSERT_EQUAL_UINT32(15, replayer.get_dropped());
+  TEST_ASSERT_EQUAL_size_t(6, ids.size());
+  TEST_ASSERT_EQUAL_HEX32(2, ids.back());
+}
+
+void test_midnight_wrap() {
+  lines = {"23:59:59.900 R 00000001 00", "00:00:00.100 R 00000002 00",
+           "00:00:00.200 R 00000003 00"};
+  N2kFrameReplayer replayer(source(), 1.0, 10);
+  N2kCanFrame frame;
+  TEST_ASSERT_TRUE(replayer.next(1000000, &frame));
+  TEST_ASSERT_FALSE(replayer.next(1199999, &frame));
+  TEST_ASSERT_TRUE(replayer.next(1200000, &frame));
+  TEST_ASSERT_EQUAL_HEX32(2, frame.id);
+  TEST_ASSERT_FALSE(replayer.next(1299999, &frame));
+  TEST_ASSERT_TRUE(replayer.next(1300000, &frame));
+  TEST_ASSERT_EQUAL_HEX32(3, frame.id);
+}
+
+void test_backwards_timestamp_is_due_immediately() {
+  // A log concatenated from two captures
+  lines = {"(500.000000) can0 00000001#00", "(500.500000) can0 00000002#00",
+           "(10.000000) can0 00000003#00", "(10.100000) can0 00000004#00"};
+  N2kFrameReplayer replayer(source(), 1.0, 10);
+  N2kCanFrame frame;
+  TEST_ASSERT_TRUE(replayer.next(0, &frame));
+  TEST_ASSERT_TRUE(replayer.next(500000, &frame));
+  TEST_ASSERT_EQUAL_HEX32(2, frame.id);
+  TEST_ASSERT_TRUE(replayer.next(500000, &frame));
+  TEST_ASSERT_EQUAL_HEX32(3, frame.id);
+  TEST_ASSERT_FALSE(replayer.next(599999, &frame));
+  TEST_ASSERT_TRUE(replayer.next(600000, &frame));
+  TEST_ASSERT_EQUAL_HEX32(4, frame.id);
+  TEST_ASSERT_EQUAL_UINT32(0, replayer.get_dropped());
+}
+
+void test_unparseable_lines_skipped() {
+  lines = {"# header", "(0.000000) can0 00000001#00", "",
+           "(0.000100) can0 00000002#00"};
+  N2kFrameReplayer replayer(source(), 1.0, 10);
+  auto ids = replay(replayer, 0, 1000, 100);
+  TEST_ASSERT_EQUAL_size_t(2, ids.size());
+  TEST_ASSERT_EQUAL_UINT32(2, replayer.get_replayed());
+}
+
+void test_ring_overwrite() {
+  N2kFrameRing ring(3);
+  N2kCanFrame frame = {};
+  for (uint32_t id = 1; id <= 5; id++) {
+    frame.id = id;
+    ring.push(frame, true);
+  }
+  TEST_ASSERT_TRUE(ring.full());
+  TEST_ASSERT_EQUAL_UINT32(2, ring.get_overwritten());
+  TEST_ASSERT_EQUAL_HEX32(3, ring.at(0).id);
+  TEST_ASSERT_EQUAL_HEX32(5, ring.at(2).id);
+  frame.id = 6;
+  TEST_ASSERT_FALSE(ring.push(frame));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_parse_candump);
+  RUN_TEST(test_parse_actisense_raw);
+  RUN_TEST(test_parse_rejects_garbage);
+  RUN_TEST(test_original_pace);
+  RUN_TEST(test_speed_factor);
+  RUN_TEST(test_full_speed_never_drops);
+  RUN_TEST(test_slow_consumer_drops);
+  RUN_TEST(test_midnight_wrap);
+  RUN_TEST(test_backwards_timestamp_is_due_immediately);
+  RUN_TEST(test_unparseable_lines_skipped);
+  RUN_TEST(test_ring_overwrite);
+  return UNITY_END();
+}
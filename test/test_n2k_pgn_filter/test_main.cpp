@@ -0,0 +1,298 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "n2k_frame_log.h"
+#include "n2k_pgn_filter.h"
+
+using namespace halmet;
+
+// Stand-in for the NMEA 2000 library's receive path: fast-packet frames
+// are reassembled into per-source buffers, single frames are copied out,
+// and every complete message is "parsed" by summing its bytes. It is not
+// the library, but it does the same kind of per-frame work that the filter
+// saves.
+class ReceivePathModel {
+ public:
+  static bool is_fast_packet(uint32_t pgn) {
+    switch (pgn) {
+      case 126996:
+      case 127489:
+      case 127497:
+      case 129029:
+      case 129038:
+      case 129039:
+      case 129794:
+      case 129809:
+      case 130842:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  void receive(const N2kCanFrame& frame) {
+    frames_++;
+    uint32_t pgn = N2kCanIdToPgn(frame.id);
+    uint8_t source = frame.id & 0xFF;
+    if (!is_fast_packet(pgn)) {
+      uint8_t msg[8];
+      memcpy(msg, frame.data, frame.len);
+      parse(msg, frame.len);
+      return;
+    }
+    Buffer* buffer = find_buffer(pgn, source);
+    uint8_t index = frame.data[0] & 0x1F;
+    if (index == 0) {
+      buffer->pgn = pgn;
+      buffer->source = source;
+      buffer->expected = frame.data[1];
+      buffer->received = 0;
+      memcpy(buffer->data, frame.data + 2, 6);
+      buffer->received = 6;
+    } else if (buffer->pgn == pgn && buffer->received > 0) {
+      size_t n = frame.len - 1;
+      if (buffer->received + n > sizeof(buffer->data)) {
+        n = sizeof(buffer->data) - buffer->received;
+      }
+      memcpy(buffer->data + buffer->received, frame.data + 1, n);
+      buffer->received += n;
+    }
+    if (buffer->received >= buffer->expected && buffer->received > 0) {
+      parse(buffer->data, buffer->expected);
+      buffer->pgn = 0;
+      buffer->received = 0;
+    }
+  }
+
+  uint32_t get_frames() const { return frames_; }
+  uint32_t get_messages() const { return messages_; }
+
+ private:
+  struct Buffer {
+    uint32_t pgn = 0;
+    uint8_t source = 0;
+    size_t expected = 0;
+    size_t received = 0;
+    uint8_t data[223];
+  };
+
+  Buffer* find_buffer(uint32_t pgn, uint8_t source) {
+    for (auto& buffer : buffers_) {
+      if (buffer.pgn == pgn && buffer.source == source) {
+        return &buffer;
+      }
+    }
+    for (auto& buffer : buffers_) {
+      if (buffer.pgn == 0) {
+        return &buffer;
+      }
+    }
+    return &buffers_[0];
+  }
+
+  void parse(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+      checksum_ += data[i];
+    }
+    messages_++;
+  }
+
+  Buffer buffers_[20];
+  uint32_t frames_ = 0;
+  uint32_t messages_ = 0;
+  uint32_t checksum_ = 0;
+};
+
+static uint32_t CanId(uint8_t priority, uint32_t pgn, uint8_t source) {
+  return (priority << 26) | (pgn << 8) | source;
+}
+
+// Log lines of a fast packet message of len bytes
+static void AddFastPacket(std::vector<std::string>* lines, double* t,
+                          uint32_t id, size_t len) {
+  char line[80];
+  size_t sent = 0;
+  for (uint8_t index = 0; sent < len || index == 0; index++) {
+    uint8_t data[8] = {index, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    if (index == 0) {
+      data[1] = len;
+      sent += 6;
+    } else {
+      sent += 7;
+    }
+    int n = snprintf(line, sizeof(line), "(%.6f) can0 %08X#", *t, id);
+    for (uint8_t byte : data) {
+      n += snprintf(line + n, sizeof(line) - n, "%02X", byte);
+    }
+    lines->push_back(line);
+    *t += 0.0005;
+  }
+}
+
+static void AddSingleFrame(std::vector<std::string>* lines, double* t,
+                           uint32_t id) {
+  char line[80];
+  snprintf(line, sizeof(line), "(%.6f) can0 %08X#0102030405060708", *t, id);
+  lines->push_back(line);
+  *t += 0.0005;
+}
+
+// A busy bus: AIS targets and a radar dominate, with a
+// handful of navigation PGNs and the two engine PGNs HALMET decodes.
+static std::vector<std::string> BusyBusLog() {
+  std::vector<std::string> lines;
+  double t = 1000;
+  for (int i = 0; i < 40; i++) {
+    AddFastPacket(&lines, &t, CanId(4, 129038, 40 + i % 3), 28);
+    AddFastPacket(&lines, &t, CanId(4, 129039, 40 + i % 3), 27);
+  }
+  for (int i = 0; i < 10; i++) {
+    AddFastPacket(&lines, &t, CanId(6, 129794, 40), 75);
+    AddFastPacket(&lines, &t, CanId(6, 129809, 41), 27);
+  }
+  for (int i = 0; i < 60; i++) {
+    AddFastPacket(&lines, &t, CanId(7, 130842, 60), 80);
+  }
+  for (int i = 0; i < 10; i++) {
+    AddSingleFrame(&lines, &t, CanId(2, 127250, 10));
+    AddSingleFrame(&lines, &t, CanId(2, 130306, 11));
+    AddSingleFrame(&lines, &t, CanId(2, 129025, 12));
+    AddSingleFrame(&lines, &t, CanId(2, 129026, 12));
+    AddFastPacket(&lines, &t, CanId(3, 129029, 12), 43);
+  }
+  for (int i = 0; i < 2; i++) {
+    AddFastPacket(&lines, &t, CanId(2, 127489, 20), 26);
+    AddFastPacket(&lines, &t, CanId(6, 127497, 20), 14);
+  }
+  AddSingleFrame(&lines, &t, CanId(6, 60928, 20));
+  AddSingleFrame(&lines, &t, CanId(6, 59904 | 0xFF, 30));
+  return lines;
+}
+
+// Read the log through the replayer, like HalmetNMEA2000 in replay mode
+static std::vector<N2kCanFrame> Replay(const std::vector<std::string>& log) {
+  size_t next = 0;
+  N2kFrameReplayer replayer(
+      [&](char* buf, size_t size) {
+        if (next == log.size()) {
+          return false;
+        }
+        strncpy(buf, log[next++].c_str(), size - 1);
+        buf[size - 1] = '\0';
+        return true;
+      },
+      0, 250);
+  std::vector<N2kCanFrame> frames;
+  N2kCanFrame frame;
+  while (replayer.next(0, &frame)) {
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+static N2kPgnFilter EngineFilter() {
+  N2kPgnFilter filter;
+  filter.allow(127489);
+  filter.allow(127497);
+  return filter;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_filter_passes_engine_and_system_pgns() {
+  N2kPgnFilter filter = EngineFilter();
+  TEST_ASSERT_TRUE(filter.accepts(CanId(2, 127489, 20)));
+  TEST_ASSERT_TRUE(filter.accepts(CanId(6, 127497, 99)));
+  TEST_ASSERT_TRUE(filter.accepts(CanId(6, 60928, 20)));
+  // PDU1: the destination address is not part of the PGN
+  TEST_ASSERT_TRUE(filter.accepts(CanId(6, 59904 | 0x23, 30)));
+  TEST_ASSERT_FALSE(filter.accepts(CanId(4, 129038, 40)));
+  TEST_ASSERT_FALSE(filter.accepts(CanId(7, 130842, 60)));
+  TEST_ASSERT_FALSE(filter.accepts(CanId(2, 127488, 20)));
+}
+
+void test_acceptance_filter_passes_allowed_pgns() {
+  N2kPgnFilter filter = EngineFilter();
+  CanAcceptanceFilter hw = filter.get_acceptance_filter();
+  for (uint32_t pgn : filter.get_pgns()) {
+    uint32_t id = CanId(3, pgn, 0x42);
+    TEST_ASSERT_EQUAL_HEX32(hw.code, id & ~hw.mask);
+  }
+  TEST_ASSERT_GREATER_THAN(0.0f, hw.pgn_pass_ratio());
+  TEST_ASSERT_LESS_OR_EQUAL(1.0f, hw.pgn_pass_ratio());
+}
+
+void test_replayed_busy_bus_reaches_receive_path_filtered() {
+  auto frames = Replay(BusyBusLog());
+  N2kPgnFilter filter = EngineFilter();
+
+  ReceivePathModel unfiltered;
+  ReceivePathModel filtered;
+  for (const auto& frame : frames) {
+    unfiltered.receive(frame);
+    if (filter.accepts(frame.id)) {
+      filtered.receive(frame);
+    }
+  }
+  // Two 127489 (4 frames) and two 127497 (3 frames), plus 2 system frames
+  TEST_ASSERT_EQUAL_UINT32(frames.size(), unfiltered.get_frames());
+  TEST_ASSERT_EQUAL_UINT32(2 * (4 + 3) + 2, filtered.get_frames());
+  TEST_ASSERT_EQUAL_UINT32(2 * 2 + 2, filtered.get_messages());
+}
+
+void test_cpu_time_saved_per_1000_frames() {
+  auto frames = Replay(BusyBusLog());
+  N2kPgnFilter filter = EngineFilter();
+  const int kRounds = 200;
+
+  ReceivePathModel unfiltered;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; round++) {
+    for (const auto& frame : frames) {
+      unfiltered.receive(frame);
+    }
+  }
+  auto unfiltered_ns = std::chrono::duration<double, std::nano>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+
+  ReceivePathModel filtered;
+  start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; round++) {
+    for (const auto& frame : frames) {
+      if (filter.accepts(frame.id)) {
+        filtered.receive(frame);
+      }
+    }
+  }
+  auto filtered_ns = std::chrono::duration<double, std::nano>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+  double total_frames = static_cast<double>(frames.size()) * kRounds;
+  double unfiltered_us = unfiltered_ns / total_frames;  // per 1000 frames
+  double filtered_us = filtered_ns / total_frames;
+  char message[160];
+  snprintf(message, sizeof(message),
+           "%u frames; receive path per 1000 frames: %.1f us "
+           "unfiltered, %.1f us filtered, %.1f us saved",
+           static_cast<unsigned>(frames.size()), unfiltered_us, filtered_us,
+           unfiltered_us - filtered_us);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_LESS_THAN(unfiltered_ns, filtered_ns);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_filter_passes_engine_and_system_pgns);
+  RUN_TEST(test_acceptance_filter_passes_allowed_pgns);
+  RUN_TEST(test_replayed_busy_bus_reaches_receive_path_filtered);
+  RUN_TEST(test_cpu_time_saved_per_1000_frames);
+  return UNITY_END();
+}
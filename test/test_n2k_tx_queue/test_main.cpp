@@ -0,0 +1,143 @@
+#include <unity.h>
+
+#include <vector>
+
+#include "priority_tx_queue.h"
+
+using namespace halmet;
+
+// Stands in for tN2kMsg
+struct FakeMsg {
+  int stream;
+  int value;
+};
+
+using Queue = PriorityTxQueue<FakeMsg>;
+
+static Queue* queue;
+static std::vector<FakeMsg> sent;
+
+void setUp() {
+  FakeClock::enable(1000000);
+  queue = new Queue(4);
+  sent.clear();
+}
+
+void tearDown() {
+  delete queue;
+  FakeClock::disable();
+}
+
+static bool enqueue(int stream, int value, N2kTxClass tx_class) {
+  return queue->enqueue({stream, value}, tx_class, stream);
+}
+
+static int drain_all() {
+  return queue->drain([](const FakeMsg& msg) {
+    sent.push_back(msg);
+    return true;
+  });
+}
+
+void test_priority_then_age() {
+  enqueue(1, 10, N2kTxClass::kSlow);
+  enqueue(2, 20, N2kTxClass::kDynamic);
+  enqueue(3, 30, N2kTxClass::kRapid);
+  enqueue(4, 40, N2kTxClass::kDynamic);
+  TEST_ASSERT_EQUAL(4, drain_all());
+  TEST_ASSERT_EQUAL(3, sent[0].stream);
+  TEST_ASSERT_EQUAL(2, sent[1].stream);
+  TEST_ASSERT_EQUAL(4, sent[2].stream);
+  TEST_ASSERT_EQUAL(1, sent[3].stream);
+  TEST_ASSERT_EQUAL(0, queue->size());
+}
+
+void test_coalescing_keeps_place() {
+  enqueue(1, 10, N2kTxClass::kDynamic);
+  enqueue(2, 20, N2kTxClass::kDynamic);
+  // Supersedes the pending value of stream 1 without moving it back
+  TEST_ASSERT_TRUE(enqueue(1, 11, N2kTxClass::kDynamic));
+  TEST_ASSERT_EQUAL(2, queue->size());
+  drain_all();
+  TEST_ASSERT_EQUAL(2, sent.size());
+  TEST_ASSERT_EQUAL(1, sent[0].stream);
+  TEST_ASSERT_EQUAL(11, sent[0].value);
+  auto stats = queue->get_stats(N2kTxClass::kDynamic);
+  TEST_ASSERT_EQUAL_UINT32(3, stats.enqueued);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.coalesced);
+  TEST_ASSERT_EQUAL_UINT32(2, stats.sent);
+}
+
+void test_full_queue_evicts_oldest_lower_class() {
+  enqueue(1, 10, N2kTxClass::kSlow);
+  enqueue(2, 20, N2kTxClass::kDynamic);
+  enqueue(3, 30, N2kTxClass::kSlow);
+  enqueue(4, 40, N2kTxClass::kDynamic);
+  // Full: the oldest slow message makes room
+  TEST_ASSERT_TRUE(enqueue(5, 50, N2kTxClass::kRapid));
+  TEST_ASSERT_EQUAL_UINT32(1, queue->get_stats(N2kTxClass::kSlow).dropped);
+  drain_all();
+  TEST_ASSERT_EQUAL(4, sent.size());
+  for (const auto& msg : sent) {
+    TEST_ASSERT_NOT_EQUAL(1, msg.stream);
+  }
+  TEST_ASSERT_EQUAL(3, sent.back().stream);
+}
+
+void test_full_queue_drops_new_message_without_lower_class() {
+  for (int stream = 1; stream <= 4; stream++) {
+    enqueue(stream, 0, N2kTxClass::kDynamic);
+  }
+  // Same class: nothing to evict
+  TEST_ASSERT_FALSE(enqueue(5, 0, N2kTxClass::kDynamic));
+  TEST_ASSERT_FALSE(enqueue(6, 0, N2kTxClass::kSlow));
+  TEST_ASSERT_EQUAL_UINT32(1, queue->get_stats(N2kTxClass::kDynamic).dropped);
+  TEST_ASSERT_EQUAL_UINT32(1, queue->get_stats(N2kTxClass::kSlow).dropped);
+  TEST_ASSERT_EQUAL(4, queue->size());
+}
+
+void test_busy_driver_keeps_message() {
+  enqueue(1, 10, N2kTxClass::kRapid);
+  enqueue(2, 20, N2kTxClass::kSlow);
+  int sent_count = queue->drain([](const FakeMsg&) { return false; });
+  TEST_ASSERT_EQUAL(0, sent_count);
+  TEST_ASSERT_EQUAL(2, queue->size());
+  // Still first in line
+  drain_all();
+  TEST_ASSERT_EQUAL(1, sent[0].stream);
+}
+
+void test_newer_message_supersedes_one_being_sent() {
+  enqueue(1, 10, N2kTxClass::kRapid);
+  // The event loop queues a newer value while the driver is busy
+  queue->drain([](const FakeMsg&) {
+    enqueue(1, 11, N2kTxClass::kRapid);
+    return false;
+  });
+  TEST_ASSERT_EQUAL(1, queue->size());
+  drain_all();
+  TEST_ASSERT_EQUAL(1, sent.size());
+  TEST_ASSERT_EQUAL(11, sent[0].value);
+}
+
+void test_latency() {
+  enqueue(1, 10, N2kTxClass::kSlow);
+  FakeClock::advance_ms(35);
+  drain_all();
+  TEST_ASSERT_EQUAL_UINT32(35,
+                           queue->get_stats(N2kTxClass::kSlow).max_latency_ms);
+  queue->clear_stats();
+  TEST_ASSERT_EQUAL_UINT32(0, queue->get_stats(N2kTxClass::kSlow).sent);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_priority_then_age);
+  RUN_TEST(test_coalescing_keeps_place);
+  RUN_TEST(test_full_queue_evicts_oldest_lower_class);
+  RUN_TEST(test_full_queue_drops_new_message_without_lower_class);
+  RUN_TEST(test_busy_driver_keeps_message);
+  RUN_TEST(test_newer_message_supersedes_one_being_sent);
+  RUN_TEST(test_latency);
+  return UNITY_END();
+}
@@ -0,0 +1,114 @@
+#include <unity.h>
+
+#include <cmath>
+
+#include "expiring_value.h"
+#include "halmet_clock.h"
+#include "output_gates.h"
+
+using namespace halmet;
+
+void setUp() { FakeClock::enable(1000000); }
+
+void tearDown() { FakeClock::disable(); }
+
+void test_fake_clock() {
+  TEST_ASSERT_EQUAL_UINT32(1000, ClockMillis());
+  TEST_ASSERT_EQUAL_UINT32(1000000, ClockMicros());
+  FakeClock::advance_us(1500);
+  TEST_ASSERT_EQUAL_UINT32(1001, ClockMillis());
+  TEST_ASSERT_EQUAL_UINT32(1001500, ClockMicros());
+}
+
+void test_expiring_value_expires() {
+  ExpiringValue<float> value(1.5, 2000, NAN);
+  TEST_ASSERT_EQUAL_FLOAT(1.5, value.get());
+  FakeClock::advance_ms(2000);
+  TEST_ASSERT_FALSE(value.is_expired());
+  FakeClock::advance_ms(1);
+  TEST_ASSERT_TRUE(value.is_expired());
+  TEST_ASSERT_FLOAT_IS_NAN(value.get());
+}
+
+void test_expiring_value_update_renews() {
+  ExpiringValue<int> value(1, 1000, -1);
+  FakeClock::advance_ms(900);
+  value.update(2);
+  FakeClock::advance_ms(900);
+  TEST_ASSERT_EQUAL_INT(2, value.get());
+  FakeClock::advance_ms(200);
+  TEST_ASSERT_EQUAL_INT(-1, value.get());
+}
+
+void test_min_interval_first_value_passes() {
+  MinIntervalGate gate(500);
+  TEST_ASSERT_TRUE(gate.pass(ClockMillis()));
+}
+
+void test_min_interval_limits_rate() {
+  MinIntervalGate gate(500);
+  int passed = 0;
+  // 10 s of values every 10 ms
+  for (int i = 0; i < 1000; i++) {
+    passed += gate.pass(ClockMillis());
+    FakeClock::advance_ms(10);
+  }
+  TEST_ASSERT_EQUAL_INT(20, passed);
+}
+
+void test_deadband_suppresses_small_changes() {
+  DeadbandGate<float> gate(0.5, 10000);
+  TEST_ASSERT_TRUE(gate.pass(20.0, ClockMillis()));
+  FakeClock::advance_ms(100);
+  TEST_ASSERT_FALSE(gate.pass(20.4, ClockMillis()));
+  FakeClock::advance_ms(100);
+  TEST_ASSERT_FALSE(gate.pass(19.6, ClockMillis()));
+  FakeClock::advance_ms(100);
+  // Compared with the last value passed, not the last value seen
+  TEST_ASSERT_TRUE(gate.pass(20.6, ClockMillis()));
+  TEST_ASSERT_EQUAL_UINT32(2, gate.get_passed());
+  TEST_ASSERT_EQUAL_UINT32(2, gate.get_suppressed());
+}
+
+void test_deadband_heartbeat() {
+  DeadbandGate<float> gate(0.5, 10000);
+  int passed = 0;
+  // A constant value for a minute, every 100 ms
+  for (int i = 0; i < 600; i++) {
+    passed += gate.pass(12.8, ClockMillis());
+    FakeClock::advance_ms(100);
+  }
+  TEST_ASSERT_EQUAL_INT(6, passed);
+}
+
+void test_deadband_nan_transitions_pass() {
+  DeadbandGate<float> gate(0.5, 10000);
+  TEST_ASSERT_TRUE(gate.pass(1.0, ClockMillis()));
+  TEST_ASSERT_TRUE(gate.pass(NAN, ClockMillis()));
+  TEST_ASSERT_FALSE(gate.pass(NAN, ClockMillis()));
+  TEST_ASSERT_TRUE(gate.pass(1.0, ClockMillis()));
+}
+
+void test_deadband_reconfigured() {
+  DeadbandGate<float> gate(0.5, 10000);
+  gate.pass(1.0, ClockMillis());
+  gate.set_deadband(0.05);
+  TEST_ASSERT_TRUE(gate.pass(1.1, ClockMillis()));
+  gate.set_heartbeat_interval(1000);
+  FakeClock::advance_ms(1000);
+  TEST_ASSERT_TRUE(gate.pass(1.1, ClockMillis()));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fake_clock);
+  RUN_TEST(test_expiring_value_expires);
+  RUN_TEST(test_expiring_value_update_renews);
+  RUN_TEST(test_min_interval_first_value_passes);
+  RUN_TEST(test_min_interval_limits_rate);
+  RUN_TEST(test_deadband_suppresses_small_changes);
+  RUN_TEST(test_deadband_heartbeat);
+  RUN_TEST(test_deadband_nan_transitions_pass);
+  RUN_TEST(test_deadband_reconfigured);
+  return UNITY_END();
+}
@@ -0,0 +1,74 @@
+#include <unity.h>
+
+#include <climits>
+
+#include "packed_fields.h"
+
+using namespace halmet;
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_never_stamped_is_stale() {
+  TEST_ASSERT_FALSE(IsFresh(0, 100, 1000));
+}
+
+void test_expiry_boundary() {
+  TEST_ASSERT_TRUE(IsFresh(5000, 6000, 1000));
+  TEST_ASSERT_FALSE(IsFresh(5000, 6001, 1000));
+}
+
+void test_expiry_across_wrap() {
+  unsigned long stamped = ULONG_MAX - 200;
+  TEST_ASSERT_TRUE(IsFresh(stamped, 500, 1000));
+  TEST_ASSERT_FALSE(IsFresh(stamped, 1000, 1000));
+}
+
+void test_any_fresh() {
+  unsigned long updated[3] = {0, 1000, 4000};
+  TEST_ASSERT_TRUE(AnyFresh(updated, 3, 5000, 1000));
+  TEST_ASSERT_FALSE(AnyFresh(updated, 3, 5001, 1000));
+  TEST_ASSERT_FALSE(AnyFresh(updated, 0, 5000, 1000));
+}
+
+void test_set_bit() {
+  uint32_t bits = 0;
+  SetBit(&bits, 3, true);
+  SetBit(&bits, 20, true);
+  TEST_ASSERT_EQUAL_HEX32(0x00100008, bits);
+  SetBit(&bits, 3, false);
+  TEST_ASSERT_EQUAL_HEX32(0x00100000, bits);
+}
+
+void test_expired_flags_cleared() {
+  unsigned long updated[4] = {4500, 1000, 4500, 0};
+  // Bit 1 expired, bit 3 never set from an input
+  TEST_ASSERT_EQUAL_HEX32(0x5, FreshBits(0xF, updated, 4, 5000, 1000));
+}
+
+void test_check_engine_follows_other_flags() {
+  TEST_ASSERT_EQUAL_HEX16(0x0000, EngineStatus1(0));
+  // Low oil pressure (bit 2) also raises Check Engine (bit 0)
+  TEST_ASSERT_EQUAL_HEX16(0x0005, EngineStatus1(1 << 2));
+  TEST_ASSERT_EQUAL_HEX16(0x0001, EngineStatus1(1));
+  // Status 2 bits don't count
+  TEST_ASSERT_EQUAL_HEX16(0x0000, EngineStatus1(1UL << 16));
+}
+
+void test_status_2() {
+  TEST_ASSERT_EQUAL_HEX16(0x81, EngineStatus2((1UL << 16) | (1UL << 23) | 1));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_never_stamped_is_stale);
+  RUN_TEST(test_expiry_boundary);
+  RUN_TEST(test_expiry_across_wrap);
+  RUN_TEST(test_any_fresh);
+  RUN_TEST(test_set_bit);
+  RUN_TEST(test_expired_flags_cleared);
+  RUN_TEST(test_check_engine_follows_other_flags);
+  RUN_TEST(test_status_2);
+  return UNITY_END();
+}
@@ -0,0 +1,71 @@
+#include <unity.h>
+
+#include <vector>
+
+#include "pgn_set.h"
+
+using namespace halmet;
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_sorted_without_duplicates() {
+  PgnSet set;
+  TEST_ASSERT_TRUE(set.insert(127489));
+  TEST_ASSERT_TRUE(set.insert(127488));
+  TEST_ASSERT_TRUE(set.insert(59904));
+  TEST_ASSERT_FALSE(set.insert(127488));
+
+  std::vector<uint32_t> expected = {59904, 127488, 127489};
+  TEST_ASSERT_TRUE(set.get_pgns() == expected);
+  TEST_ASSERT_EQUAL(3, set.size());
+}
+
+void test_find_gives_index() {
+  PgnSet set;
+  for (uint32_t pgn : {130312, 127505, 127489, 127488}) {
+    set.insert(pgn);
+  }
+  TEST_ASSERT_EQUAL(0, set.find(127488));
+  TEST_ASSERT_EQUAL(2, set.find(127505));
+  TEST_ASSERT_EQUAL(3, set.find(130312));
+  TEST_ASSERT_EQUAL(-1, set.find(127508));
+  TEST_ASSERT_FALSE(set.contains(0));
+}
+
+void test_bitmap_collision_still_rejected() {
+  PgnSet set;
+  set.insert(127488);
+  // Look for a PGN that hashes to the same bitmap slot: the binary search
+  // must still reject it
+  uint32_t colliding = 0;
+  for (uint32_t pgn = 0; pgn < 0x40000; pgn++) {
+    if (pgn != 127488 &&
+        ((pgn * 2654435761u) >> 22) == ((127488u * 2654435761u) >> 22)) {
+      colliding = pgn;
+      break;
+    }
+  }
+  TEST_ASSERT_NOT_EQUAL(0, colliding);
+  TEST_ASSERT_FALSE(set.contains(colliding));
+  TEST_ASSERT_TRUE(set.contains(127488));
+}
+
+void test_clear() {
+  PgnSet set;
+  set.insert(127488);
+  set.clear();
+  TEST_ASSERT_EQUAL(0, set.size());
+  TEST_ASSERT_FALSE(set.contains(127488));
+  TEST_ASSERT_TRUE(set.insert(127488));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_sorted_without_duplicates);
+  RUN_TEST(test_find_gives_index);
+  RUN_TEST(test_bitmap_collision_still_rejected);
+  RUN_TEST(test_clear);
+  return UNITY_END();
+}
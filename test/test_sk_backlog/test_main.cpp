@@ -0,0 +1,204 @@
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "sk_backlog.h"
+
+using namespace halmet;
+
+static const uint32_t kLayout = 0x1234;
+// 2024-06-10T06:13:20.000Z
+static const uint64_t kStart = 1718000000000ULL;
+
+// Websocket stand-in: collects the deltas sent while connected. With
+// fail_after set, the connection drops after that many more deltas.
+struct Server {
+  bool connected = true;
+  int fail_after = -1;
+  std::vector<std::string> deltas;
+
+  bool send(const char* delta, size_t len) {
+    if (fail_after == 0) {
+      connected = false;
+    }
+    if (!connected) {
+      return false;
+    }
+    if (fail_after > 0) {
+      fail_after--;
+    }
+    deltas.emplace_back(delta, len);
+    return true;
+  }
+
+  int count(const char* needle) const {
+    int n = 0;
+    for (const auto& delta : deltas) {
+      for (size_t pos = delta.find(needle); pos != std::string::npos;
+           pos = delta.find(needle, pos + 1)) {
+        n++;
+      }
+    }
+    return n;
+  }
+};
+
+static RamFlashStorage* flash;
+static SKDeltaWriter* writer;
+static FlashLog* flash_log;
+static SKBacklog* backlog;
+static Server* server;
+static SKBacklog::SendCallback send;
+
+// A fresh log and backlog on the same flash, as after a restart
+static void restart(uint32_t layout = kLayout) {
+  delete backlog;
+  delete flash_log;
+  flash_log = new FlashLog(flash);
+  flash_log->begin();
+  backlog = new SKBacklog(flash_log, writer);
+  backlog->begin(layout);
+}
+
+void setUp() {
+  flash = new RamFlashStorage(16);
+  // Small, so every block takes several deltas
+  writer = new SKDeltaWriter(1024);
+  writer->add_path("propulsion.main.revolutions");
+  writer->add_path("propulsion.main.exhaustTemperature1");
+  writer->add_path("tanks.fuel.0.currentVolume");
+  flash_log = nullptr;
+  backlog = nullptr;
+  restart();
+  server = new Server();
+  send = [](const char* delta, size_t len) {
+    return server->send(delta, len);
+  };
+}
+
+void tearDown() {
+  delete server;
+  delete backlog;
+  delete flash_log;
+  delete writer;
+  delete flash;
+}
+
+// An outage at 1 Hz for all three outputs, from second from after kStart.
+// Returns the number of values recorded.
+static int record_outage(int seconds, int from = 0) {
+  for (int i = from; i < from + seconds; i++) {
+    uint64_t t = kStart + i * 1000;
+    backlog->record(0, 30.0f + (i % 7) * 0.1f, t);
+    backlog->record(1, 350.15f + i * 0.01f, t);
+    backlog->record(2, 0.123f, t);
+    backlog->flush_if_older(t, 60000);
+  }
+  backlog->flush();
+  return 3 * seconds;
+}
+
+// Every value of output 1 is different: each must arrive exactly once
+static void assert_each_exhaust_value_once(int seconds, int from = 0) {
+  for (int i = from; i < from + seconds; i++) {
+    char number[24];
+    number[FormatSKNumber(350.15f + i * 0.01f, number)] = '\0';
+    std::string needle = std::string("\"value\":") + number + "}";
+    TEST_ASSERT_EQUAL(1, server->count(needle.c_str()));
+  }
+}
+
+static void replay_all() {
+  while (backlog->replay_step(send)) {
+  }
+}
+
+void test_outage_replayed() {
+  int recorded = record_outage(600);
+  TEST_ASSERT_TRUE(backlog->has_backlog());
+  replay_all();
+  TEST_ASSERT_FALSE(backlog->has_backlog());
+  TEST_ASSERT_GREATER_THAN(1, backlog->get_stats().blocks);
+
+  TEST_ASSERT_EQUAL(recorded, server->count("\"path\""));
+  assert_each_exhaust_value_once(600);
+  // Original timestamps
+  TEST_ASSERT_EQUAL(1, server->count("2024-06-10T06:13:20.000Z"));
+  const std::string& first = server->deltas[0];
+  TEST_ASSERT_TRUE(first.find("\"value\":30}") != std::string::npos);
+  TEST_ASSERT_TRUE(first.find("\"value\":350.15}") != std::string::npos);
+  TEST_ASSERT_TRUE(first.find("\"value\":0.123}") != std::string::npos);
+}
+
+void test_outage_during_replay() {
+  int recorded = record_outage(600);
+  // Drops in the middle of a block
+  server->fail_after = 5;
+  replay_all();
+  TEST_ASSERT_TRUE(backlog->has_backlog());
+  TEST_ASSERT_EQUAL(5, server->deltas.size());
+
+  // Values recorded during the second outage are replayed after the rest
+  recorded += record_outage(60, 3600);
+  server->connected = true;
+  server->fail_after = -1;
+  replay_all();
+  TEST_ASSERT_FALSE(backlog->has_backlog());
+  // Nothing lost and nothing sent twice
+  TEST_ASSERT_EQUAL(recorded, server->count("\"path\""));
+  assert_each_exhaust_value_once(600);
+  assert_each_exhaust_value_once(60, 3600);
+}
+
+void test_restart_during_replay() {
+  int recorded = record_outage(600);
+  server->fail_after = 7;
+  replay_all();
+  TEST_ASSERT_EQUAL(7, server->deltas.size());
+
+  restart();
+  TEST_ASSERT_TRUE(backlog->has_backlog());
+  server->connected = true;
+  server->fail_after = -1;
+  replay_all();
+  TEST_ASSERT_EQUAL(recorded, server->count("\"path\""));
+  assert_each_exhaust_value_once(600);
+
+  // Nothing left after another restart
+  restart();
+  TEST_ASSERT_FALSE(backlog->has_backlog());
+}
+
+void test_other_layout_skipped() {
+  record_outage(10);
+  restart(0x9999);
+  TEST_ASSERT_TRUE(backlog->has_backlog());
+  replay_all();
+  TEST_ASSERT_EQUAL(0, server->deltas.size());
+  TEST_ASSERT_EQUAL_UINT32(1, backlog->get_stats().skipped);
+  TEST_ASSERT_FALSE(backlog->has_backlog());
+}
+
+void test_compact_encoding() {
+  int recorded = record_outage(600);
+  size_t bytes = 0;
+  FlashLog::Cursor cursor = flash_log->oldest();
+  uint8_t record[FlashLog::kMaxPayload];
+  size_t len;
+  while (flash_log->read_next(&cursor, record, sizeof(record), &len)) {
+    bytes += len;
+  }
+  // Output ID, time step and value difference: a few bytes per value
+  TEST_ASSERT_LESS_THAN(5 * recorded, static_cast<int>(bytes));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_outage_replayed);
+  RUN_TEST(test_outage_during_replay);
+  RUN_TEST(test_restart_during_replay);
+  RUN_TEST(test_other_layout_skipped);
+  RUN_TEST(test_compact_encoding);
+  return UNITY_END();
+}
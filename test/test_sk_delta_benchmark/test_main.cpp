@@ -0,0 +1,243 @@
+#include <ArduinoJson.h>
+#include <unity.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "sk_delta_writer.h"
+
+using namespace halmet;
+
+// Heap allocations: the containers and strings allocate through operator
+// new, the JsonDocuments through CountingAllocator
+struct AllocationStats {
+  size_t count;
+  size_t bytes;
+};
+static AllocationStats allocations = {0, 0};
+
+static void count_allocation(size_t size) {
+  allocations.count++;
+  allocations.bytes += size;
+}
+
+void* operator new(size_t size) {
+  count_allocation(size);
+  void* p = malloc(size ? size : 1);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// ArduinoJson's DefaultAllocator calls malloc() directly, which the
+// operator new above doesn't see. A reallocation counts as a new
+// allocation of the new size, since it may move the block.
+class CountingAllocator : public ArduinoJson::Allocator {
+ public:
+  void* allocate(size_t size) override {
+    count_allocation(size);
+    return malloc(size);
+  }
+
+  void deallocate(void* pointer) override { free(pointer); }
+
+  void* reallocate(void* pointer, size_t new_size) override {
+    count_allocation(new_size);
+    return realloc(pointer, new_size);
+  }
+};
+
+static CountingAllocator json_allocator;
+
+// The values of a busy batcher window: engine, tanks and voltages
+static const char* const kPaths[] = {
+    "propulsion.main.revolutions",
+    "propulsion.main.oilPressure",
+    "propulsion.main.temperature",
+    "propulsion.main.fuel.rate",
+    "tanks.fuel.0.currentLevel",
+    "tanks.fuel.0.currentVolume",
+    "electrical.sensors.analog.2.voltage",
+    "electrical.sensors.analog.3.voltage",
+    "electrical.sensors.analog.4.voltage",
+    "environment.inside.engineRoom.temperature",
+};
+static const size_t kValues = sizeof(kPaths) / sizeof(kPaths[0]);
+
+static float value_for(size_t i, int round) { return 0.1f * i + round; }
+
+/**
+ * @brief The path a value takes through SKOutputFloat.
+ *
+ * Modelled on SensESP 3.1: SKOutput::as_signalk_json() serializes each
+ * value into a String through its own JsonDocument, SKDeltaQueue keeps the
+ * strings in a list, and SKDeltaQueue::get_delta() adds them to a delta
+ * document that is serialized once more. std::string stands in for the
+ * Arduino String, and the documents allocate through CountingAllocator
+ * instead of the DefaultAllocator.
+ */
+class SensESPStyleDelta {
+ public:
+  SensESPStyleDelta() {
+    for (auto path : kPaths) {
+      paths_.push_back(path);
+    }
+  }
+
+  void set(size_t i, float value) {
+    JsonDocument json_doc(&json_allocator);
+    JsonObject root = json_doc.to<JsonObject>();
+    root["path"] = paths_[i];
+    root["value"] = value;
+    std::string json;
+    serializeJson(json_doc, json);
+    buffer_.push_back(json);
+  }
+
+  const std::string& get_delta() {
+    JsonDocument json_message(&json_allocator);
+    JsonArray updates = json_message["updates"].to<JsonArray>();
+    JsonObject current = updates.add<JsonObject>();
+    JsonArray values = current["values"].to<JsonArray>();
+    while (!buffer_.empty()) {
+      values.add(serialized(buffer_.front()));
+      buffer_.pop_front();
+    }
+    output_.clear();
+    serializeJson(json_message, output_);
+    return output_;
+  }
+
+ private:
+  std::vector<std::string> paths_;
+  std::list<std::string> buffer_;
+  std::string output_;
+};
+
+static SensESPStyleDelta* sensesp_delta;
+static SKDeltaWriter* writer;
+
+void setUp() {
+  sensesp_delta = new SensESPStyleDelta();
+  writer = new SKDeltaWriter(2048);
+  for (auto path : kPaths) {
+    writer->add_path(path);
+  }
+}
+
+void tearDown() {
+  delete writer;
+  delete sensesp_delta;
+}
+
+static const std::string& sensesp_round(int round) {
+  for (size_t i = 0; i < kValues; i++) {
+    sensesp_delta->set(i, value_for(i, round));
+  }
+  return sensesp_delta->get_delta();
+}
+
+static const char* writer_round(int round, size_t* len) {
+  writer->begin();
+  writer->begin_update();
+  for (size_t i = 0; i < kValues; i++) {
+    writer->add_value(i, value_for(i, round));
+  }
+  return writer->finish(len);
+}
+
+void test_same_delta() {
+  size_t len;
+  JsonDocument expected;
+  JsonDocument actual;
+  TEST_ASSERT_FALSE(deserializeJson(expected, sensesp_round(7)));
+  TEST_ASSERT_FALSE(deserializeJson(actual, writer_round(7, &len), len));
+
+  JsonArray expected_values = expected["updates"][0]["values"];
+  JsonArray actual_values = actual["updates"][0]["values"];
+  TEST_ASSERT_EQUAL(kValues, expected_values.size());
+  TEST_ASSERT_EQUAL(kValues, actual_values.size());
+  for (size_t i = 0; i < kValues; i++) {
+    TEST_ASSERT_EQUAL_STRING(expected_values[i]["path"].as<const char*>(),
+                             actual_values[i]["path"].as<const char*>());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, expected_values[i]["value"].as<float>(),
+                             actual_values[i]["value"].as<float>());
+  }
+}
+
+void test_allocations_per_delta() {
+  size_t len;
+  // Warm up, so lasting buffers are in place
+  sensesp_round(0);
+  writer_round(0, &len);
+
+  allocations = {0, 0};
+  sensesp_round(1);
+  AllocationStats sensesp_allocations = allocations;
+  allocations = {0, 0};
+  writer_round(1, &len);
+  AllocationStats writer_allocations = allocations;
+
+  char message[120];
+  snprintf(message, sizeof(message),
+           "Allocations per delta: ArduinoJson %u (%u bytes), "
+           "SKDeltaWriter %u (%u bytes)",
+           static_cast<unsigned>(sensesp_allocations.count),
+           static_cast<unsigned>(sensesp_allocations.bytes),
+           static_cast<unsigned>(writer_allocations.count),
+           static_cast<unsigned>(writer_allocations.bytes));
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL(0, writer_allocations.count);
+  TEST_ASSERT_EQUAL(0, writer_allocations.bytes);
+  TEST_ASSERT_GREATER_THAN(kValues, sensesp_allocations.count);
+}
+
+void test_benchmark_against_arduinojson() {
+  const int kRounds = 20000;
+  size_t sink = 0;
+  size_t len;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; round++) {
+    sink += sensesp_round(round).size();
+  }
+  double sensesp_us = std::chrono::duration<double, std::micro>(
+                          std::chrono::steady_clock::now() - start)
+                          .count() /
+                      kRounds;
+
+  start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; round++) {
+    writer_round(round, &len);
+    sink += len;
+  }
+  double writer_us = std::chrono::duration<double, std::micro>(
+                         std::chrono::steady_clock::now() - start)
+                         .count() /
+                     kRounds;
+
+  char message[120];
+  snprintf(message, sizeof(message),
+           "%u-value delta: ArduinoJson %.2f us, SKDeltaWriter %.2f us",
+           static_cast<unsigned>(kValues), sensesp_us, writer_us);
+  TEST_MESSAGE(message);
+  // Timing depends on the host, so it is only reported
+  TEST_ASSERT_GREATER_THAN(0, sink);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_same_delta);
+  RUN_TEST(test_allocations_per_delta);
+  RUN_TEST(test_benchmark_against_arduinojson);
+  return UNITY_END();
+}
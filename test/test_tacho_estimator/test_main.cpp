@@ -0,0 +1,365 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+
+#include "tacho_estimator.h"
+
+using namespace halmet;
+
+// Same sizes and timing as TachoInput
+static const size_t kEdgeHistory = 16;
+static const size_t kCountHistory = 5;
+static const uint64_t kUpdateIntervalUs = 50000;
+static const uint32_t kEdgeTimeoutUs = 1000000;
+static const size_t kPeriodIntervals = 4;
+
+// Largest error of the count rate from whole pulses alone: one pulse over
+// the window of kCountHistory - 1 update intervals
+static const float kCountQuantizationHz =
+    1e6f / ((kCountHistory - 1) * kUpdateIntervalUs);
+
+/**
+ * @brief Simulated tacho input.
+ *
+ * Edges are generated by integrating the signal frequency in small time
+ * steps, so the frequency may change continuously. Every update interval,
+ * the estimators are read the same way TachoInput::update() reads them:
+ * a 64-bit counter reading and time for the count rate, and a 32-bit
+ * esp_timer timestamp for the edge period.
+ */
+class TachoSimulator {
+ public:
+  TachoSimulator(uint64_t start_us = 0, uint32_t start_count = 0)
+      : now_us_{start_us}, count_{start_count} {}
+
+  /**
+   * @brief Run for one update interval and read both estimators.
+   *
+   * @param frequency Signal frequency in Hz as a function of the time since
+   *   the simulation started, in us
+   */
+  template <typename Frequency>
+  void update(Frequency frequency) {
+    for (uint64_t end = now_us_ + kUpdateIntervalUs; now_us_ < end;
+         now_us_ += kStepUs) {
+      phase_ += frequency(elapsed_us()) * kStepUs * 1e-6;
+      if (phase_ >= 1) {
+        phase_ -= 1;
+        count_++;
+        edges_.add_edge(static_cast<uint32_t>(now_us_));
+        recent_edges_us_.push_back(elapsed_us());
+        if (recent_edges_us_.size() > kPeriodIntervals + 1) {
+          recent_edges_us_.pop_front();
+        }
+      }
+    }
+    updates_++;
+    count_hz_ = count_rate_.update(static_cast<int32_t>(count_), now_us_);
+    period_hz_ = edges_.get_frequency(static_cast<uint32_t>(now_us_),
+                                      kEdgeTimeoutUs, kPeriodIntervals);
+  }
+
+  uint64_t elapsed_us() const { return now_us_ - start_us_; }
+  int updates() const { return updates_; }
+  float count_hz() const { return count_hz_; }
+  float period_hz() const { return period_hz_; }
+
+  /// Both estimators have a full history to average over.
+  bool settled() const {
+    return updates_ >= static_cast<int>(kCountHistory) &&
+           recent_edges_us_.size() == kPeriodIntervals + 1;
+  }
+
+  /// Time of the oldest edge that the period estimate averages over.
+  uint64_t first_averaged_edge_us() const { return recent_edges_us_.front(); }
+  uint64_t last_edge_us() const { return recent_edges_us_.back(); }
+
+ private:
+  static const uint64_t kStepUs = 5;
+
+  uint64_t now_us_;
+  const uint64_t start_us_ = now_us_;
+  uint32_t count_;
+  double phase_ = 0;
+  int updates_ = 0;
+  std::deque<uint64_t> recent_edges_us_;
+
+  SlidingPulseRate<kCountHistory> count_rate_;
+  EdgePeriodEstimator<kEdgeHistory> edges_;
+  float count_hz_ = 0;
+  float period_hz_ = 0;
+};
+
+void setUp() {}
+
+void tearDown() {}
+
+// Steady signal at frequency_hz for one second
+static void assert_tracks_constant(TachoSimulator* tacho, float frequency_hz) {
+  auto constant = [=](uint64_t) { return frequency_hz; };
+  for (int i = 0; i < 20; i++) {
+    tacho->update(constant);
+    if (!tacho->settled()) {
+      continue;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(kCountQuantizationHz + 0.01f * frequency_hz,
+                             frequency_hz, tacho->count_hz());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f * frequency_hz, frequency_hz,
+                             tacho->period_hz());
+  }
+  TEST_ASSERT_TRUE(tacho->settled());
+}
+
+void test_constant_pulse_train() {
+  // Idle to full speed of a typical flywheel pickup
+  for (float frequency_hz : {12.0f, 100.0f, 950.0f, 4000.0f}) {
+    TachoSimulator tacho;
+    assert_tracks_constant(&tacho, frequency_hz);
+  }
+}
+
+void test_ramping_pulse_train() {
+  // 10 Hz to 1000 Hz in 10 s
+  auto ramp = [](uint64_t t_us) { return 10 + 99e-6 * t_us; };
+  TachoSimulator tacho;
+  while (tacho.elapsed_us() < 10000000) {
+    tacho.update(ramp);
+    if (!tacho.settled()) {
+      continue;
+    }
+    uint64_t now = tacho.elapsed_us();
+    // Each estimate is an average over its window, so it lies between the
+    // frequencies at the start and at the end of the window
+    uint64_t window_us = (kCountHistory - 1) * kUpdateIntervalUs;
+    TEST_ASSERT_TRUE(tacho.count_hz() >=
+                     ramp(now - window_us) - kCountQuantizationHz);
+    TEST_ASSERT_TRUE(tacho.count_hz() <= ramp(now) + kCountQuantizationHz);
+    TEST_ASSERT_TRUE(tacho.period_hz() >=
+                     0.99 * ramp(tacho.first_averaged_edge_us()));
+    TEST_ASSERT_TRUE(tacho.period_hz() <= 1.01 * ramp(tacho.last_edge_us()));
+  }
+}
+
+void test_stopping_pulse_train() {
+  TachoSimulator tacho;
+  assert_tracks_constant(&tacho, 50);
+
+  auto stopped = [](uint64_t) { return 0.0; };
+  uint64_t last_edge = tacho.last_edge_us();
+  float previous_count_hz = tacho.count_hz();
+  int count_zero_after = -1;
+  for (int i = 1; i <= 30; i++) {
+    tacho.update(stopped);
+    uint64_t since_last = tacho.elapsed_us() - last_edge;
+
+    // Decays as soon as a period passes without an edge, then drops to zero
+    if (since_last <= 20000) {
+      TEST_ASSERT_FLOAT_WITHIN(0.5f, 50, tacho.period_hz());
+    } else if (since_last <= kEdgeTimeoutUs) {
+      TEST_ASSERT_FLOAT_WITHIN(0.01f, 1e6f / since_last, tacho.period_hz());
+    } else {
+      TEST_ASSERT_EQUAL_FLOAT(0, tacho.period_hz());
+    }
+
+    // The count rate falls as the window empties of pulses
+    TEST_ASSERT_TRUE(tacho.count_hz() <= previous_count_hz);
+    previous_count_hz = tacho.count_hz();
+    if (count_zero_after < 0 && tacho.count_hz() == 0) {
+      count_zero_after = i;
+    }
+  }
+  TEST_ASSERT_EQUAL(kCountHistory - 1, count_zero_after);
+}
+
+void test_timestamp_wrap() {
+  // The 32-bit edge timestamps wrap 0.3 s into the run
+  const uint64_t kWrap = 1ULL << 32;
+  TachoSimulator tacho(kWrap - 300000);
+  assert_tracks_constant(&tacho, 80);
+
+  // Stop just before the next wrap of the microsecond clock, and decay
+  // across it
+  TachoSimulator stopping(kWrap - 1000000);
+  assert_tracks_constant(&stopping, 80);
+  uint64_t last_edge = stopping.last_edge_us();
+  for (int i = 0; i < 4; i++) {
+    stopping.update([](uint64_t) { return 0.0; });
+  }
+  uint64_t since_last = stopping.elapsed_us() - last_edge;
+  TEST_ASSERT_GREATER_THAN(20000, static_cast<int>(since_last));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1e6f / since_last, stopping.period_hz());
+}
+
+void test_count_wrap() {
+  // The accumulated PCNT count overflows the signed 32-bit range, and then
+  // wraps through zero
+  for (uint32_t start_count : {0x7FFFFFF0U, 0xFFFFFFF0U}) {
+    TachoSimulator tacho(0, start_count);
+    assert_tracks_constant(&tacho, 300);
+  }
+}
+
+void test_decay_after_last_edge() {
+  EdgePeriodEstimator<kEdgeHistory> edges;
+  for (uint32_t t = 0; t <= 100000; t += 10000) {
+    edges.add_edge(t);
+  }
+  // Within one period of the last edge: the measured 100 Hz
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 100, edges.get_frequency(105000, 1000000, 4));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 100, edges.get_frequency(110000, 1000000, 4));
+  // After that, 1 / (time since the last edge)
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 50, edges.get_frequency(120000, 1000000, 4));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 25, edges.get_frequency(140000, 1000000, 4));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 2, edges.get_frequency(600000, 1000000, 4));
+}
+
+void test_timeout_to_zero() {
+  EdgePeriodEstimator<kEdgeHistory> edges;
+  for (uint32_t t = 0; t <= 100000; t += 10000) {
+    edges.add_edge(t);
+  }
+  // Down to 1 / timeout, then zero
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 4, edges.get_frequency(350000, 250000, 4));
+  TEST_ASSERT_EQUAL_FLOAT(0, edges.get_frequency(350001, 250000, 4));
+  TEST_ASSERT_EQUAL_FLOAT(0, edges.get_frequency(5000000, 250000, 4));
+  // Fewer than two edges give no period at all
+  EdgePeriodEstimator<kEdgeHistory> single;
+  TEST_ASSERT_EQUAL_FLOAT(0, single.get_frequency(0, 250000, 4));
+  single.add_edge(1000);
+  TEST_ASSERT_EQUAL_FLOAT(0, single.get_frequency(1000, 250000, 4));
+}
+
+void test_intervals_clamped_to_history() {
+  // Three edges: only two intervals to average over
+  EdgePeriodEstimator<kEdgeHistory> edges;
+  edges.add_edge(0);
+  edges.add_edge(10000);
+  edges.add_edge(30000);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 50, edges.get_frequency(30000, 1000000, 1));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 2e6f / 30000,
+                           edges.get_frequency(30000, 1000000, 10));
+
+  // A full, wrapped history: 20 edges, of which the oldest 4 are gone.
+  // Edges 4 to 9 are 20 ms apart and edges 9 to 19 10 ms apart.
+  EdgePeriodEstimator<kEdgeHistory> full;
+  uint32_t t = 0;
+  for (int i = 0; i < 20; i++) {
+    full.add_edge(t);
+    t += i < 9 ? 20000 : 10000;
+  }
+  uint32_t last = t - 10000;
+  // 15 intervals over 5 * 20 ms + 10 * 10 ms
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 75,
+                           full.get_frequency(last, 1000000, kEdgeHistory - 1));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 75, full.get_frequency(last, 1000000, 100));
+}
+
+void test_crossover_hysteresis() {
+  TachoCrossover crossover(300);
+  TEST_ASSERT_TRUE(crossover.get_mode() == TachoCrossover::Mode::kPeriod);
+  // Inside the band around 300 Hz, the mode doesn't change
+  for (float frequency : {290.0f, 310.0f, 329.0f}) {
+    TEST_ASSERT_TRUE(crossover.update(frequency) ==
+                     TachoCrossover::Mode::kPeriod);
+  }
+  TEST_ASSERT_TRUE(crossover.update(331) == TachoCrossover::Mode::kCount);
+  for (float frequency : {310.0f, 290.0f, 271.0f, 400.0f}) {
+    TEST_ASSERT_TRUE(crossover.update(frequency) ==
+                     TachoCrossover::Mode::kCount);
+  }
+  TEST_ASSERT_TRUE(crossover.update(269) == TachoCrossover::Mode::kPeriod);
+
+  crossover.set_crossover(100);
+  TEST_ASSERT_TRUE(crossover.update(109) == TachoCrossover::Mode::kPeriod);
+  TEST_ASSERT_TRUE(crossover.update(111) == TachoCrossover::Mode::kCount);
+}
+
+void test_count_to_period_handover() {
+  // The edge history as TachoInput leaves it when it switches to counting
+  // above the crossover: timestamps from before the switch
+  EdgePeriodEstimator<kEdgeHistory> edges;
+  TachoCrossover crossover(300);
+  uint32_t t = 0;
+  for (int i = 0; i < 10; i++, t += 2000) {
+    edges.add_edge(t);
+  }
+  TEST_ASSERT_TRUE(crossover.update(edges.get_frequency(t, 1000000, 4)) ==
+                   TachoCrossover::Mode::kCount);
+
+  // Back below the crossover two seconds later. The edge interrupt is
+  // attached again, which resets the history.
+  t += 2000000;
+  TEST_ASSERT_TRUE(crossover.update(200) == TachoCrossover::Mode::kPeriod);
+  edges.reset();
+
+  // The first new edge gives no period yet, instead of one spanning the
+  // two seconds without interrupts
+  edges.add_edge(t);
+  TEST_ASSERT_EQUAL_FLOAT(0, edges.get_frequency(t + 1000, 1000000, 4));
+  // The second gives the new period, averaged over the one interval known
+  edges.add_edge(t + 5000);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 200,
+                           edges.get_frequency(t + 5000, 1000000, 4));
+  for (int i = 2; i <= 4; i++) {
+    edges.add_edge(t + i * 5000);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 200,
+                           edges.get_frequency(t + 20000, 1000000, 4));
+}
+
+void test_update_path_time() {
+  const int kUpdates = 200000;
+  SlidingPulseRate<kCountHistory> count_rate;
+  EdgePeriodEstimator<kEdgeHistory> edges;
+  for (uint32_t i = 0; i < kEdgeHistory; i++) {
+    edges.add_edge(i * 10000);
+  }
+  float sink = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kUpdates; i++) {
+    sink += count_rate.update(i * 5, i * kUpdateIntervalUs);
+  }
+  double count_ns = std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - start)
+                        .count() /
+                    kUpdates;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kUpdates; i++) {
+    // TachoInput copies the edge history out of the critical section
+    EdgePeriodEstimator<kEdgeHistory> copy = edges;
+    sink += copy.get_frequency(150000 + (i & 0xFF), kEdgeTimeoutUs,
+                               kPeriodIntervals);
+  }
+  double period_ns = std::chrono::duration<double, std::nano>(
+                         std::chrono::steady_clock::now() - start)
+                         .count() /
+                     kUpdates;
+
+  char message[120];
+  snprintf(message, sizeof(message),
+           "Update path per reading: count rate %.1f ns, edge period %.1f ns",
+           count_ns, period_ns);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_TRUE(sink > 0);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_constant_pulse_train);
+  RUN_TEST(test_ramping_pulse_train);
+  RUN_TEST(test_stopping_pulse_train);
+  RUN_TEST(test_timestamp_wrap);
+  RUN_TEST(test_count_wrap);
+  RUN_TEST(test_decay_after_last_edge);
+  RUN_TEST(test_timeout_to_zero);
+  RUN_TEST(test_intervals_clamped_to_history);
+  RUN_TEST(test_crossover_hysteresis);
+  RUN_TEST(test_count_to_period_handover);
+  RUN_TEST(test_update_path_time);
+  return UNITY_END();
+}
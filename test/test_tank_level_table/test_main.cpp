@@ -0,0 +1,181 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "tank_level_table.h"
+
+using namespace halmet;
+using Point = TankLevelTable::Point;
+
+// Resistance per ADC code on HALMET: 0.125 mV per code at GAIN_ONE, the
+// 33.3/3.3 input divider and the 10 mA sender current
+const float kOhmsPerCode = 0.125e-3 * 33.3 / 3.3 / 0.01;
+
+// Same walk as sensesp::CurveInterpolator::set(): linear search for the
+// first sample at or above the input, an implicit (0, 0) before the first
+// sample and the last output past the last sample
+static float CurveInterpolator(const std::vector<Point>& curve, float input) {
+  float x0 = 0;
+  float y0 = 0;
+  size_t i = 0;
+  while (i < curve.size() && input > curve[i].resistance) {
+    x0 = curve[i].resistance;
+    y0 = curve[i].level;
+    i++;
+  }
+  if (i == curve.size()) {
+    return y0;
+  }
+  float x1 = curve[i].resistance;
+  float y1 = curve[i].level;
+  if (x1 == x0) {
+    return y1;
+  }
+  return (y0 * (x1 - input) + y1 * (input - x0)) / (x1 - x0);
+}
+
+// The default curve of ConnectTankSender
+static const std::vector<Point> kDefaultCurve = {{0, 0}, {180, 1}, {1000, 1}};
+
+// An odd-shaped tank: many points on a curve that isn't linear
+static std::vector<Point> OddCurve(size_t points, float max_ohms) {
+  std::vector<Point> curve;
+  for (size_t i = 1; i <= points; i++) {
+    float x = static_cast<float>(i) / points;
+    curve.push_back({x * max_ohms, x * x * (3 - 2 * x)});
+  }
+  return curve;
+}
+
+static float MaxDeviation(const TankLevelTable& table,
+                          const std::vector<Point>& curve, float ohms_per_code,
+                          int16_t max_code) {
+  float max_deviation = 0;
+  for (int32_t code = 0; code <= max_code; code++) {
+    float expected = CurveInterpolator(curve, code * ohms_per_code);
+    float deviation = std::fabs(table.level(code) - expected);
+    if (deviation > max_deviation) {
+      max_deviation = deviation;
+    }
+  }
+  return max_deviation;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_matches_interpolator_on_every_code() {
+  // A narrow range: one entry per code
+  TankLevelTable table;
+  table.build(kDefaultCurve, 1.0);
+  TEST_ASSERT_EQUAL_size_t(1002, table.size());
+  TEST_ASSERT_LESS_THAN(1e-5f, MaxDeviation(table, kDefaultCurve, 1.0, 2000));
+  TEST_ASSERT_EQUAL_FLOAT(0.5, table.level(90));
+}
+
+void test_strided_table() {
+  // 1000 ohms at HALMET's resolution is 8000 codes, more than kMaxEntries
+  TankLevelTable table;
+  table.build(kDefaultCurve, kOhmsPerCode);
+  TEST_ASSERT_LESS_OR_EQUAL(TankLevelTable::kMaxEntries, table.size());
+  // Exact at the entries, linear in between; only the entry that straddles
+  // the 180 ohm breakpoint deviates
+  TEST_ASSERT_LESS_THAN(1e-3f,
+                        MaxDeviation(table, kDefaultCurve, kOhmsPerCode,
+                                     INT16_MAX));
+  TEST_ASSERT_EQUAL_FLOAT(1, table.level(static_cast<int16_t>(
+                                 500 / kOhmsPerCode)));
+}
+
+void test_implicit_zero_point() {
+  // No point at 0 ohms: the curve starts from (0, 0) like the interpolator
+  std::vector<Point> curve = {{100, 0.2}, {200, 1}};
+  TankLevelTable table;
+  table.build(curve, 1.0);
+  TEST_ASSERT_EQUAL_FLOAT(0, table.level(0));
+  TEST_ASSERT_EQUAL_FLOAT(0.1, table.level(50));
+  TEST_ASSERT_EQUAL_FLOAT(0.6, table.level(150));
+  TEST_ASSERT_LESS_THAN(1e-5f, MaxDeviation(table, curve, 1.0, 300));
+}
+
+void test_clamps_past_last_sample() {
+  std::vector<Point> curve = {{0, 1}, {200, 0.25}};
+  TankLevelTable table;
+  table.build(curve, kOhmsPerCode);
+  TEST_ASSERT_EQUAL_FLOAT(0.25, table.level(static_cast<int16_t>(
+                                    200 / kOhmsPerCode + 1)));
+  TEST_ASSERT_EQUAL_FLOAT(0.25, table.level(INT16_MAX));
+  // Negative codes count as zero resistance
+  TEST_ASSERT_EQUAL_FLOAT(1, table.level(-100));
+}
+
+void test_many_points() {
+  std::vector<Point> curve = OddCurve(64, 300);
+  TankLevelTable table;
+  table.build(curve, kOhmsPerCode);
+  TEST_ASSERT_LESS_THAN(2e-3f,
+                        MaxDeviation(table, curve, kOhmsPerCode, INT16_MAX));
+}
+
+void test_empty_curve() {
+  TankLevelTable table;
+  table.build({}, kOhmsPerCode);
+  TEST_ASSERT_TRUE(table.empty());
+  TEST_ASSERT_EQUAL_FLOAT(0, table.level(1000));
+}
+
+// Average time per conversion over a sweep of all positive codes, in ns
+template <typename F>
+static double TimePerLookup(F lookup) {
+  const int kRounds = 20;
+  volatile float sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; round++) {
+    for (int32_t code = 0; code <= INT16_MAX; code += 7) {
+      sink = sink + lookup(static_cast<int16_t>(code));
+    }
+  }
+  double ns = std::chrono::duration<double, std::nano>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  return ns / (kRounds * (INT16_MAX / 7 + 1));
+}
+
+void test_benchmark_against_interpolator() {
+  char message[120];
+  for (size_t points : {3, 64}) {
+    std::vector<Point> curve =
+        points == 3 ? kDefaultCurve : OddCurve(points, 1000);
+    TankLevelTable table;
+    table.build(curve, kOhmsPerCode);
+
+    double interpolator_ns = TimePerLookup([&curve](int16_t code) {
+      return CurveInterpolator(curve, code * kOhmsPerCode);
+    });
+    double table_ns =
+        TimePerLookup([&table](int16_t code) { return table.level(code); });
+    snprintf(message, sizeof(message),
+             "%u points: interpolator %.1f ns, table %.1f ns per conversion",
+             static_cast<unsigned>(points), interpolator_ns, table_ns);
+    TEST_MESSAGE(message);
+    if (points == 64) {
+      TEST_ASSERT_LESS_THAN(interpolator_ns, table_ns);
+    }
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_matches_interpolator_on_every_code);
+  RUN_TEST(test_strided_table);
+  RUN_TEST(test_implicit_zero_point);
+  RUN_TEST(test_clamps_past_last_sample);
+  RUN_TEST(test_many_points);
+  RUN_TEST(test_empty_curve);
+  RUN_TEST(test_benchmark_against_interpolator);
+  return UNITY_END();
+}
@@ -0,0 +1,113 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "transmit_plan.h"
+
+using namespace halmet;
+
+void setUp() {}
+
+void tearDown() {}
+
+// Most messages due in any one tick over cycle ticks
+static unsigned int max_per_tick(const TransmitPlan& plan, uint32_t cycle) {
+  unsigned int max = 0;
+  for (uint32_t tick = 0; tick < cycle; tick++) {
+    unsigned int due = 0;
+    for (size_t i = 0; i < plan.size(); i++) {
+      due += plan.is_due(i, tick);
+    }
+    max = std::max(max, due);
+  }
+  return max;
+}
+
+void test_rapid_and_dynamic_never_collide() {
+  TransmitPlan plan(10);
+  plan.add(100, 10);
+  plan.add(500, 10);
+  plan.assign_phases();
+  TEST_ASSERT_EQUAL_UINT(1, max_per_tick(plan, 1000));
+}
+
+void test_engine_and_tank_set_spread() {
+  // Two engines (rapid and dynamic), two tanks and a 1 s PGN
+  TransmitPlan plan(10);
+  for (unsigned int period : {100, 100, 500, 500, 2500, 2500, 1000}) {
+    plan.add(period, 10);
+  }
+  plan.assign_phases();
+  TEST_ASSERT_EQUAL_UINT(1, max_per_tick(plan, 2500));
+}
+
+void test_each_message_due_once_per_period() {
+  TransmitPlan plan(10);
+  plan.add(100, 10);
+  plan.add(250, 10);
+  plan.add(1000, 10);
+  plan.assign_phases();
+  for (size_t i = 0; i < plan.size(); i++) {
+    int due = 0;
+    for (uint32_t tick = 0; tick < 1000; tick++) {
+      due += plan.is_due(i, tick);
+    }
+    TEST_ASSERT_EQUAL(1000 / plan.get_period_ticks(i), due);
+    TEST_ASSERT_LESS_THAN(plan.get_period_ticks(i), plan.get_phase_ticks(i));
+  }
+}
+
+void test_overloaded_ticks_stay_balanced() {
+  // Five 20 ms messages on 10 ms ticks can't avoid sharing
+  TransmitPlan plan(10);
+  for (int i = 0; i < 5; i++) {
+    plan.add(20, 10);
+  }
+  plan.assign_phases();
+  TEST_ASSERT_EQUAL_UINT(3, max_per_tick(plan, 100));
+}
+
+void test_period_rounding() {
+  TransmitPlan plan(10);
+  plan.add(5, 10);
+  plan.add(105, 10);
+  TEST_ASSERT_EQUAL_UINT(1, plan.get_period_ticks(0));
+  TEST_ASSERT_EQUAL_UINT(10, plan.get_period_ticks(1));
+}
+
+void test_stale_heartbeat() {
+  TransmitPlan plan(10);
+  plan.add(100, 10);
+  int sent = 0;
+  for (int i = 0; i < 100; i++) {
+    sent += plan.should_send(0, false);
+  }
+  TEST_ASSERT_EQUAL(10, sent);
+
+  // Fresh inputs are always sent, and restart the heartbeat count
+  TEST_ASSERT_TRUE(plan.should_send(0, true));
+  TEST_ASSERT_TRUE(plan.should_send(0, false));
+  TEST_ASSERT_FALSE(plan.should_send(0, false));
+}
+
+void test_stale_divider_zero_is_silent() {
+  TransmitPlan plan(10);
+  plan.add(100, 0);
+  for (int i = 0; i < 100; i++) {
+    TEST_ASSERT_FALSE(plan.should_send(0, false));
+  }
+  TEST_ASSERT_TRUE(plan.should_send(0, true));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_rapid_and_dynamic_never_collide);
+  RUN_TEST(test_engine_and_tank_set_spread);
+  RUN_TEST(test_each_message_due_once_per_period);
+  RUN_TEST(test_overloaded_ticks_stay_balanced);
+  RUN_TEST(test_period_rounding);
+  RUN_TEST(test_stale_heartbeat);
+  RUN_TEST(test_stale_divider_zero_is_silent);
+  return UNITY_END();
+}